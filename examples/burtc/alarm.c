@@ -0,0 +1,369 @@
+/***************************************************************************//**
+ * @file
+ * @brief Alarm scheduler on RTC and BURTC compare channels
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#if defined(ALARM_HOST)
+#include "alarmsim.h"     /* Host build, see host/readme.txt */
+#else
+#include "em_device.h"
+#endif
+#include "alarm.h"
+
+/******************************************************************************
+ * Any number of alarms, up to ALARM_MAX, share one compare channel. They are
+ * kept in a binary min-heap ordered by due time, and the compare register is
+ * always set to the earliest one. The compare interrupt handler calls
+ * alarmDispatch(), which calls back all due alarms.
+ *
+ * Due times are counter values and wrap around with the counter. They are
+ * ordered by their signed distance, which is correct as long as all
+ * scheduled alarms are less than half a counter period apart. This is
+ * guaranteed by only accepting due times within a quarter counter period
+ * from the counter (alarmMaxDelay()), in the future or in the past, and a
+ * dispatch latency shorter than a quarter counter period.
+ *****************************************************************************/
+
+
+/**************************************************************************//**
+ * @brief Signed distance from counter value b to counter value a
+ *****************************************************************************/
+static int32_t alarmDelta(const AlarmQueue_TypeDef *queue, uint32_t a, uint32_t b)
+{
+  /* Sign extend from the counter width */
+  return (int32_t)((a - b) << queue->shift) / (int32_t)(1UL << queue->shift);
+}
+
+
+/**************************************************************************//**
+ * @brief Put an alarm at a position in the heap
+ *****************************************************************************/
+static void alarmPlace(AlarmQueue_TypeDef *queue, Alarm_TypeDef *alarm, uint32_t index)
+{
+  queue->heap[index] = alarm;
+  alarm->index = (int32_t)index;
+}
+
+
+/**************************************************************************//**
+ * @brief Move an alarm towards the root until its parent is not later
+ *****************************************************************************/
+static void alarmSiftUp(AlarmQueue_TypeDef *queue, uint32_t index)
+{
+  Alarm_TypeDef *alarm = queue->heap[index];
+  uint32_t      parent;
+
+  while ( index > 0 )
+  {
+    parent = (index - 1) / 2;
+    if ( alarmDelta(queue, alarm->time, queue->heap[parent]->time) >= 0 )
+    {
+      break;
+    }
+    alarmPlace(queue, queue->heap[parent], index);
+    index = parent;
+  }
+  alarmPlace(queue, alarm, index);
+}
+
+
+/**************************************************************************//**
+ * @brief Move an alarm towards the leaves until no child is earlier
+ *****************************************************************************/
+static void alarmSiftDown(AlarmQueue_TypeDef *queue, uint32_t index)
+{
+  Alarm_TypeDef *alarm = queue->heap[index];
+  uint32_t      child;
+
+  while ( (child = 2 * index + 1) < queue->count )
+  {
+    /* Earlier of the two children */
+    if ( (child + 1 < queue->count)
+         && (alarmDelta(queue, queue->heap[child + 1]->time, queue->heap[child]->time) < 0) )
+    {
+      child++;
+    }
+    if ( alarmDelta(queue, queue->heap[child]->time, alarm->time) >= 0 )
+    {
+      break;
+    }
+    alarmPlace(queue, queue->heap[child], index);
+    index = child;
+  }
+  alarmPlace(queue, alarm, index);
+}
+
+
+/**************************************************************************//**
+ * @brief Remove the alarm at a position in the heap
+ *****************************************************************************/
+static void alarmRemove(AlarmQueue_TypeDef *queue, uint32_t index)
+{
+  Alarm_TypeDef *last;
+
+  queue->heap[index]->index = -1;
+  last = queue->heap[--queue->count];
+
+  /* Fill the hole with the last alarm, which may belong above or below */
+  if ( index < queue->count )
+  {
+    alarmPlace(queue, last, index);
+    alarmSiftUp(queue, index);
+    alarmSiftDown(queue, (uint32_t)last->index);
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief Set compare register to the earliest alarm
+ *
+ *   An alarm which is already due, or too close to the counter to be matched
+ *   reliably, sets the compare interrupt pending instead. Must be called with
+ *   interrupts disabled.
+ *****************************************************************************/
+static void alarmProgram(AlarmQueue_TypeDef *queue)
+{
+  const AlarmTimer_TypeDef *timer = queue->timer;
+  uint32_t                 time;
+
+  if ( queue->count == 0 )
+  {
+    timer->compareDisable();
+    return;
+  }
+
+  time = queue->heap[0]->time;
+  timer->compareSet(time);
+
+  /* Counter read after setting compare, so a match missed in between is
+     found here */
+  if ( alarmDelta(queue, time, timer->counterGet()) <= (int32_t)timer->minDelay )
+  {
+    timer->interruptSet();
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief Initialize an alarm queue
+ *
+ * @param[in] queue Alarm queue
+ * @param[in] timer Counter and compare channel of the queue
+ *****************************************************************************/
+void alarmQueueInit(AlarmQueue_TypeDef *queue, const AlarmTimer_TypeDef *timer)
+{
+  queue->timer = timer;
+  queue->count = 0;
+  queue->shift = 32 - timer->width;
+  timer->compareDisable();
+}
+
+
+/**************************************************************************//**
+ * @brief Initialize an alarm
+ *
+ * @param[in] alarm    Alarm
+ * @param[in] callback Called from the compare interrupt when the alarm is due
+ * @param[in] user     Argument of the callback
+ *****************************************************************************/
+void alarmInit(Alarm_TypeDef *alarm, AlarmCallback_TypeDef callback, void *user)
+{
+  alarm->time     = 0;
+  alarm->callback = callback;
+  alarm->user     = user;
+  alarm->index    = -1;
+}
+
+
+/**************************************************************************//**
+ * @brief Schedule an alarm at an absolute counter value
+ *
+ *   An alarm which is already scheduled is moved to the new time. A time in
+ *   the past is due at once. Can be called from alarm callbacks.
+ *
+ * @param[in] queue Alarm queue
+ * @param[in] alarm Alarm
+ * @param[in] time  Counter value when the alarm is due
+ *
+ * @return false if time is more than alarmMaxDelay() from the counter or the
+ *   queue is full, the alarm is not changed then
+ *****************************************************************************/
+bool alarmStart(AlarmQueue_TypeDef *queue, Alarm_TypeDef *alarm, uint32_t time)
+{
+  uint32_t primask;
+  int32_t  delay;
+  bool     head;
+
+  time &= 0xFFFFFFFFUL >> queue->shift;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  delay = alarmDelta(queue, time, queue->timer->counterGet());
+  if ( (delay >= (int32_t)alarmMaxDelay(queue))
+       || (delay < -(int32_t)alarmMaxDelay(queue))
+       || ((alarm->index < 0) && (queue->count == ALARM_MAX)) )
+  {
+    __set_PRIMASK(primask);
+    return false;
+  }
+
+  /* Reschedule */
+  head = (alarm->index == 0);
+  if ( alarm->index >= 0 )
+  {
+    alarmRemove(queue, (uint32_t)alarm->index);
+  }
+
+  alarm->time = time;
+  alarmPlace(queue, alarm, queue->count++);
+  alarmSiftUp(queue, (uint32_t)alarm->index);
+
+  /* Compare register only changes with the earliest alarm */
+  if ( head || (alarm->index == 0) )
+  {
+    alarmProgram(queue);
+  }
+
+  __set_PRIMASK(primask);
+  return true;
+}
+
+
+/**************************************************************************//**
+ * @brief Schedule an alarm relative to the counter
+ *
+ * @param[in] queue Alarm queue
+ * @param[in] alarm Alarm
+ * @param[in] delay Counts from now until the alarm is due
+ *
+ * @return false if delay is more than alarmMaxDelay() or the queue is full
+ *****************************************************************************/
+bool alarmStartDelay(AlarmQueue_TypeDef *queue, Alarm_TypeDef *alarm, uint32_t delay)
+{
+  if ( delay >= alarmMaxDelay(queue) )
+  {
+    return false;
+  }
+  return alarmStart(queue, alarm, queue->timer->counterGet() + delay);
+}
+
+
+/**************************************************************************//**
+ * @brief Cancel an alarm
+ *
+ * @param[in] queue Alarm queue
+ * @param[in] alarm Alarm
+ *
+ * @return false if the alarm was not scheduled
+ *****************************************************************************/
+bool alarmStop(AlarmQueue_TypeDef *queue, Alarm_TypeDef *alarm)
+{
+  uint32_t primask;
+  bool     head;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  if ( alarm->index < 0 )
+  {
+    __set_PRIMASK(primask);
+    return false;
+  }
+
+  head = (alarm->index == 0);
+  alarmRemove(queue, (uint32_t)alarm->index);
+  if ( head )
+  {
+    alarmProgram(queue);
+  }
+
+  __set_PRIMASK(primask);
+  return true;
+}
+
+
+/**************************************************************************//**
+ * @brief Check if an alarm is scheduled
+ *****************************************************************************/
+bool alarmPending(const Alarm_TypeDef *alarm)
+{
+  return alarm->index >= 0;
+}
+
+
+/**************************************************************************//**
+ * @brief Longest delay of an alarm, a quarter of the counter period
+ *****************************************************************************/
+uint32_t alarmMaxDelay(const AlarmQueue_TypeDef *queue)
+{
+  return 1UL << (30 - queue->shift);
+}
+
+
+/**************************************************************************//**
+ * @brief Call back all due alarms, in order of due time
+ *
+ *   Called from the compare interrupt handler of the queue's timer. Callbacks
+ *   are called with interrupts enabled, and may start and stop alarms.
+ *
+ * @param[in] queue Alarm queue
+ *****************************************************************************/
+void alarmDispatch(AlarmQueue_TypeDef *queue)
+{
+  Alarm_TypeDef *alarm;
+  uint32_t      primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  while ( queue->count > 0 )
+  {
+    alarm = queue->heap[0];
+    if ( alarmDelta(queue, alarm->time, queue->timer->counterGet()) > 0 )
+    {
+      break;
+    }
+    alarmRemove(queue, 0);
+
+    __set_PRIMASK(primask);
+    alarm->callback(alarm->user);
+    __disable_irq();
+  }
+
+  alarmProgram(queue);
+
+  __set_PRIMASK(primask);
+}
@@ -0,0 +1,103 @@
+/***************************************************************************//**
+ * @file
+ * @brief Alarm scheduler on RTC and BURTC compare channels
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+
+#ifndef __ALARM_H
+#define __ALARM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of alarms scheduled in one queue at the same time */
+#ifndef ALARM_MAX
+#define ALARM_MAX  16
+#endif
+
+/** Alarm callback, called from the compare interrupt handler */
+typedef void (*AlarmCallback_TypeDef)(void *user);
+
+/** Alarm. The memory is owned by the caller and must stay valid while the
+ *  alarm is scheduled. */
+typedef struct
+{
+  uint32_t              time;      /**< Counter value when the alarm is due */
+  AlarmCallback_TypeDef callback;  /**< Called when the alarm is due */
+  void                  *user;     /**< Argument of the callback */
+  int32_t               index;     /**< Position in queue, -1 if not scheduled */
+} Alarm_TypeDef;
+
+/** Counter and compare channel driving an alarm queue */
+typedef struct
+{
+  uint32_t (*counterGet)(void);          /**< Read counter */
+  void     (*compareSet)(uint32_t time); /**< Set compare value, enable interrupt */
+  void     (*compareDisable)(void);      /**< Disable compare interrupt */
+  void     (*interruptSet)(void);        /**< Set compare interrupt pending */
+  uint32_t width;                        /**< Counter width in bits */
+  uint32_t minDelay;                     /**< Counts a compare value must be ahead
+                                              of the counter to match reliably */
+} AlarmTimer_TypeDef;
+
+/** Alarm queue, a binary min-heap of alarms ordered by due time */
+typedef struct
+{
+  const AlarmTimer_TypeDef *timer;
+  Alarm_TypeDef            *heap[ALARM_MAX];
+  uint32_t                 count;
+  uint32_t                 shift;     /* 32 - counter width */
+} AlarmQueue_TypeDef;
+
+/* Timers, see alarm_timer.c */
+extern const AlarmTimer_TypeDef alarmTimerRtc;
+extern const AlarmTimer_TypeDef alarmTimerBurtc;
+
+/* Function prototypes */
+void     alarmQueueInit(AlarmQueue_TypeDef *queue, const AlarmTimer_TypeDef *timer);
+void     alarmInit(Alarm_TypeDef *alarm, AlarmCallback_TypeDef callback, void *user);
+bool     alarmStart(AlarmQueue_TypeDef *queue, Alarm_TypeDef *alarm, uint32_t time);
+bool     alarmStartDelay(AlarmQueue_TypeDef *queue, Alarm_TypeDef *alarm, uint32_t delay);
+bool     alarmStop(AlarmQueue_TypeDef *queue, Alarm_TypeDef *alarm);
+bool     alarmPending(const Alarm_TypeDef *alarm);
+uint32_t alarmMaxDelay(const AlarmQueue_TypeDef *queue);
+void     alarmDispatch(AlarmQueue_TypeDef *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
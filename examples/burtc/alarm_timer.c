@@ -0,0 +1,154 @@
+/***************************************************************************//**
+ * @file
+ * @brief Counters and compare channels for the alarm scheduler
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+#include "em_rtc.h"
+#include "em_burtc.h"
+#include "alarm.h"
+
+/******************************************************************************
+ * Alarms on the RTC wake the device from EM2 and EM3, alarms on the BURTC
+ * also from EM4 and backup mode. Both use compare channel 0, which must not
+ * be used for anything else while alarms are scheduled. The counters are
+ * configured and started by the application, and its interrupt handler
+ * calls alarmDispatch() on a compare 0 interrupt.
+ *
+ * In EM4 and backup mode the alarm queue in RAM is lost, but the earliest
+ * BURTC alarm remains in the compare register and wakes the device.
+ *****************************************************************************/
+
+
+/**************************************************************************//**
+ * @brief Read RTC counter
+ *****************************************************************************/
+static uint32_t alarmRtcCounterGet(void)
+{
+  return RTC_CounterGet();
+}
+
+
+/**************************************************************************//**
+ * @brief Set RTC compare value and enable compare interrupt
+ *****************************************************************************/
+static void alarmRtcCompareSet(uint32_t time)
+{
+  RTC_CompareSet(0, time);
+  RTC_IntEnable(RTC_IEN_COMP0);
+}
+
+
+/**************************************************************************//**
+ * @brief Disable RTC compare interrupt
+ *****************************************************************************/
+static void alarmRtcCompareDisable(void)
+{
+  RTC_IntDisable(RTC_IEN_COMP0);
+}
+
+
+/**************************************************************************//**
+ * @brief Set RTC compare interrupt pending
+ *****************************************************************************/
+static void alarmRtcInterruptSet(void)
+{
+  RTC_IntSet(RTC_IFS_COMP0);
+}
+
+
+/**************************************************************************//**
+ * @brief Read BURTC counter
+ *****************************************************************************/
+static uint32_t alarmBurtcCounterGet(void)
+{
+  return BURTC_CounterGet();
+}
+
+
+/**************************************************************************//**
+ * @brief Set BURTC compare value and enable compare interrupt
+ *
+ *   Waits until the compare value is synchronized to the low frequency
+ *   domain, so the value is in effect when the counter is read next.
+ *****************************************************************************/
+static void alarmBurtcCompareSet(uint32_t time)
+{
+  BURTC_CompareSet(0, time);
+  while ( BURTC->SYNCBUSY & BURTC_SYNCBUSY_COMP0 )
+    ;
+  BURTC_IntEnable(BURTC_IEN_COMP0);
+}
+
+
+/**************************************************************************//**
+ * @brief Disable BURTC compare interrupt
+ *****************************************************************************/
+static void alarmBurtcCompareDisable(void)
+{
+  BURTC_IntDisable(BURTC_IEN_COMP0);
+}
+
+
+/**************************************************************************//**
+ * @brief Set BURTC compare interrupt pending
+ *****************************************************************************/
+static void alarmBurtcInterruptSet(void)
+{
+  BURTC_IntSet(BURTC_IFS_COMP0);
+}
+
+
+/** RTC, 24 bit. The compare register is written through the low frequency
+    domain without a busy flag, so it must be 2 counts ahead. */
+const AlarmTimer_TypeDef alarmTimerRtc =
+{
+  alarmRtcCounterGet,
+  alarmRtcCompareSet,
+  alarmRtcCompareDisable,
+  alarmRtcInterruptSet,
+  24,
+  2
+};
+
+/** BURTC, 32 bit. The compare register is synchronized when set. */
+const AlarmTimer_TypeDef alarmTimerBurtc =
+{
+  alarmBurtcCounterGet,
+  alarmBurtcCompareSet,
+  alarmBurtcCompareDisable,
+  alarmBurtcInterruptSet,
+  32,
+  0
+};
@@ -0,0 +1,196 @@
+/***************************************************************************//**
+ * @file
+ * @brief LFXO frequency calibration against HFXO
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_prs.h"
+#include "em_rtc.h"
+#include "em_timer.h"
+#include "calibrate.h"
+
+/* Calibration defines */
+#define LFXO_FREQUENCY      32768
+#define CAL_LFXO_CYCLES     8192    /* LFXO cycles per measurement, 1/4 s */
+#define CAL_MEASUREMENTS    4       /* Measurements to add up */
+#define CAL_PRS_CHANNEL     0       /* PRS channel from RTC to TIMER0 */
+#define CAL_MAX_PPB         500000  /* Larger errors are not accepted */
+
+
+/***************************************************************************//**
+ * @brief Wait for the next capture of TIMER0
+ *
+ * @param[out] capture
+ *   Captured TIMER0 value
+ *
+ * @param[in] timeout
+ *   Number of TIMER0 overflows to wait
+ *
+ * @return
+ *   false if no capture occured, e.g. LFXO is not running
+ ******************************************************************************/
+static bool calibrateCapture(uint16_t *capture, uint32_t timeout)
+{
+  while (!(TIMER_IntGet(TIMER0) & TIMER_IF_CC0))
+  {
+    if (TIMER_IntGet(TIMER0) & TIMER_IF_OF)
+    {
+      TIMER_IntClear(TIMER0, TIMER_IF_OF);
+      if (timeout-- == 0)
+      {
+        return false;
+      }
+    }
+  }
+
+  TIMER_IntClear(TIMER0, TIMER_IF_CC0);
+  *capture = TIMER_CaptureGet(TIMER0, 0);
+
+  return true;
+}
+
+
+/***************************************************************************//**
+ * @brief Measure the LFXO frequency error against HFXO
+ *
+ * @details
+ *   The RTC is clocked from LFXO and generates a compare event every
+ *   CAL_LFXO_CYCLES. The event is routed through PRS to a capture channel of
+ *   TIMER0, which counts HFXO cycles. The number of HFXO cycles between two
+ *   events is expected to be within half a TIMER0 period of the nominal
+ *   number, so a 16 bit timer is sufficient.
+ *
+ *   HFXO is used as HFCLK while measuring, and the clock selections are
+ *   restored afterwards. The accuracy is that of the HFXO crystal.
+ *
+ * @param[out] ppb
+ *   LFXO frequency error in parts per billion, positive if LFXO is fast
+ *
+ * @return
+ *   true on success, false if no valid measurement was made
+ ******************************************************************************/
+bool calibrateLfxo(int32_t *ppb)
+{
+  TIMER_Init_TypeDef   timerInit   = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
+  RTC_Init_TypeDef     rtcInit     = RTC_INIT_DEFAULT;
+  CMU_Select_TypeDef   hfSelect;
+  CMU_Select_TypeDef   lfaSelect;
+  bool                 hfxoEnabled;
+  bool                 valid = true;
+  uint32_t             expected;
+  uint32_t             measured = 0;
+  uint32_t             timeout;
+  uint16_t             last;
+  uint16_t             capture;
+  int                  i;
+
+  /* Use HFXO as reference */
+  hfxoEnabled = (CMU->STATUS & CMU_STATUS_HFXOENS) != 0;
+  hfSelect    = CMU_ClockSelectGet(cmuClock_HF);
+  CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+
+  /* Clock RTC from LFXO */
+  lfaSelect = CMU_ClockSelectGet(cmuClock_LFA);
+  CMU_ClockEnable(cmuClock_CORELE, true);
+  CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFXO);
+  CMU_ClockDivSet(cmuClock_RTC, cmuClkDiv_1);
+  CMU_ClockEnable(cmuClock_RTC, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  /* HFXO cycles per measurement, and TIMER0 overflows before timeout */
+  expected = (uint32_t)(((uint64_t)CMU_ClockFreqGet(cmuClock_TIMER0) * CAL_LFXO_CYCLES) / LFXO_FREQUENCY);
+  timeout  = 2 * (expected >> 16) + 2;
+
+  /* RTC compare event every CAL_LFXO_CYCLES */
+  rtcInit.enable   = false;
+  rtcInit.debugRun = false;
+  rtcInit.comp0Top = true;
+  RTC_Init(&rtcInit);
+  RTC_CompareSet(0, CAL_LFXO_CYCLES - 1);
+
+  /* Route RTC compare event to TIMER0 capture channel */
+  PRS_SourceSignalSet(CAL_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_RTC, PRS_CH_CTRL_SIGSEL_RTCCOMP0, prsEdgeOff);
+
+  timerCCInit.mode     = timerCCModeCapture;
+  timerCCInit.edge     = timerEdgeRising;
+  timerCCInit.prsInput = true;
+  timerCCInit.prsSel   = (TIMER_PRSSEL_TypeDef) CAL_PRS_CHANNEL;
+  TIMER_InitCC(TIMER0, 0, &timerCCInit);
+
+  timerInit.prescale = timerPrescale1;
+  TIMER_Init(TIMER0, &timerInit);
+  TIMER_IntClear(TIMER0, TIMER_IF_CC0 | TIMER_IF_OF | TIMER_IF_ICBOF0);
+
+  RTC_Enable(true);
+
+  /* Count HFXO cycles between compare events */
+  valid = calibrateCapture(&last, timeout);
+  for (i = 0; valid && (i < CAL_MEASUREMENTS); i++)
+  {
+    valid = calibrateCapture(&capture, timeout);
+
+    /* Add the difference to the expected number, modulo the timer period */
+    measured += expected + (int16_t)(uint16_t)(capture - last - expected);
+    last      = capture;
+  }
+
+  /* Restore peripherals and clocks */
+  RTC_Reset();
+  TIMER_Reset(TIMER0);
+  PRS_SourceSignalSet(CAL_PRS_CHANNEL, 0, 0, prsEdgeOff);
+  CMU_ClockEnable(cmuClock_TIMER0, false);
+  CMU_ClockEnable(cmuClock_PRS, false);
+  CMU_ClockEnable(cmuClock_RTC, false);
+  CMU_ClockSelectSet(cmuClock_LFA, lfaSelect);
+  CMU_ClockSelectSet(cmuClock_HF, hfSelect);
+  if (!hfxoEnabled)
+  {
+    CMU_OscillatorEnable(cmuOsc_HFXO, false, false);
+  }
+
+  if (!valid)
+  {
+    return false;
+  }
+
+  /* A fast LFXO gives fewer HFXO cycles than expected */
+  expected *= CAL_MEASUREMENTS;
+  *ppb = (int32_t)(((int64_t)expected - measured) * 1000000000LL / measured);
+
+  return (*ppb <= CAL_MAX_PPB) && (*ppb >= -CAL_MAX_PPB);
+}
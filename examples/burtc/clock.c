@@ -32,21 +32,109 @@
  * arising from your use of this Software.
  *
  *****************************************************************************/
+#include <stdint.h>
 #include <time.h>
 #include "em_device.h"
+#include "em_assert.h"
 #include "clock.h"
+#include "hibernate.h"
 
 /* Clock Defines */
 static time_t rtcStartTime = 0;
 
 /* Time defines */
-static uint32_t rtcOverflowCounter = 0;
-static uint32_t overflow_interval;
-static uint32_t overflow_interval_r;
+static volatile uint32_t rtcOverflowCounter = 0;
 
 /* This variables must reflect BURTC frequency */
 #define COUNTS_PER_SEC (32768/128)
 
+/* Seconds per count as a 0.64 fixed point fraction, floor(2^64 / COUNTS_PER_SEC).
+   This is also the length of a counter overflow period in 32.32 fixed point
+   seconds. The scale is computed at compile time, so time is read with
+   multiplications only. */
+#define COUNT_SCALE ((UINT64_MAX / COUNTS_PER_SEC) + \
+                     (((UINT64_MAX % COUNTS_PER_SEC) + 1) / COUNTS_PER_SEC))
+
+/* Nanoseconds and microseconds per second */
+#define NSEC_PER_SEC 1000000000UL
+#define USEC_PER_SEC 1000000UL
+
+/* Scale corrected for the measured LFXO frequency, see clockSetCorrection() */
+static uint64_t countScale = COUNT_SCALE;
+
+/* LFXO frequency error in parts per billion, positive if LFXO is fast */
+static int32_t rtcCorrection = 0;
+
+/* Added to elapsed time (32.32 fixed point), keeps time continuous when the
+   correction is changed */
+static int64_t rtcTimeOffset = 0;
+
+
+/***************************************************************************//**
+ * @brief Read the BURTC counter and the overflow counter consistently
+ *
+ * @param[out] count
+ *   BURTC counter value
+ *
+ * @return
+ *   Number of counter overflows that belongs to count
+ ******************************************************************************/
+uint32_t clockGetCounters(uint32_t *count)
+{
+  uint32_t overflows;
+  uint32_t pending;
+
+  /* Read again if an overflow interrupt was handled in between */
+  do
+  {
+    overflows = rtcOverflowCounter;
+    *count    = BURTC->CNT;
+    pending   = BURTC->IF & BURTC_IF_OF;
+  } while (overflows != rtcOverflowCounter);
+
+  /* The counter has wrapped but the overflow interrupt is not handled yet,
+     e.g. when called with interrupts disabled */
+  if (pending && (*count < 0x80000000UL))
+  {
+    overflows++;
+  }
+
+  return overflows;
+}
+
+
+/***************************************************************************//**
+ * @brief Convert a BURTC count to time since the BURTC was started
+ *
+ * @return
+ *   Elapsed time in 32.32 fixed point seconds
+ ******************************************************************************/
+static uint64_t clockCountToTime(uint32_t overflows, uint32_t count)
+{
+  /* count * countScale is a 96 bit product, keep the upper 64 bits */
+  return (uint64_t)overflows * countScale
+         + (uint64_t)count * (uint32_t)(countScale >> 32)
+         + (((uint64_t)count * (uint32_t)countScale) >> 32)
+         + (uint64_t)rtcTimeOffset;
+}
+
+
+/***************************************************************************//**
+ * @brief Time since the BURTC was started
+ *
+ * @return
+ *   Elapsed time in 32.32 fixed point seconds
+ ******************************************************************************/
+static uint64_t clockElapsed(void)
+{
+  uint32_t overflows;
+  uint32_t count;
+
+  overflows = clockGetCounters(&count);
+
+  return clockCountToTime(overflows, count);
+}
+
 
 /******************************************************************************
  * @brief Returns the current system time
@@ -70,31 +158,174 @@ time_t time( time_t * timer )
 {
   time_t t;
 
-  /* Add the time offset */
-  t = rtcStartTime;
+  /* Add the time offset and the whole seconds counted by the BURTC */
+  t = rtcStartTime + (time_t)(clockElapsed() >> 32);
 
-  /* Add time based on number of counter overflows*/
-  t += rtcOverflowCounter * overflow_interval;
+  /* Copy system time to timer if not NULL*/
+  if ( timer )
+  {
+    *timer = t;
+  }
 
-  /* Correct if overflow interval is not an integer*/
-  if ( overflow_interval_r != 0 )
+  return t;
+}
+
+
+/***************************************************************************//**
+ * @brief Returns the time of a clock with nanosecond resolution
+ *
+ * @param[in] clk_id
+ *   CLOCK_REALTIME for system time, CLOCK_MONOTONIC for time since the BURTC
+ *   was started, which is not changed by setting the clock
+ *
+ * @param[out] tp
+ *   Current time, resolution is one BURTC count
+ *
+ * @return
+ *   0 on success, -1 if clock is unknown
+ ******************************************************************************/
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+  uint64_t elapsed;
+
+  if ( (clk_id != CLOCK_REALTIME) && (clk_id != CLOCK_MONOTONIC) )
   {
-    t += rtcOverflowCounter * overflow_interval_r / COUNTS_PER_SEC;
+    return -1;
   }
 
-  /* Add the number of seconds for BURTC */
-  t += (BURTC->CNT / COUNTS_PER_SEC);
+  elapsed = clockElapsed();
 
-  /* Copy system time to timer if not NULL*/
-  if ( !timer )
+  tp->tv_sec  = (time_t)(elapsed >> 32);
+  tp->tv_nsec = (long)(((elapsed & 0xFFFFFFFFUL) * NSEC_PER_SEC) >> 32);
+
+  if ( clk_id == CLOCK_REALTIME )
   {
-    timer = &t;
+    tp->tv_sec += rtcStartTime;
   }
 
-  return t;
+  return 0;
 }
 
 
+/***************************************************************************//**
+ * @brief Returns the current system time with microsecond resolution
+ *
+ * @param[out] tv
+ *   Current system time, resolution is one BURTC count
+ *
+ * @param tz
+ *   Obsolete, ignored
+ *
+ * @return
+ *   Always 0
+ ******************************************************************************/
+int gettimeofday(struct timeval *tv, void *tz)
+{
+  uint64_t elapsed;
+  (void)tz;                                       /* Unused parameter */
+
+  elapsed = clockElapsed();
+
+  tv->tv_sec  = rtcStartTime + (time_t)(elapsed >> 32);
+  tv->tv_usec = (long)(((elapsed & 0xFFFFFFFFUL) * USEC_PER_SEC) >> 32);
+
+  return 0;
+}
+
+
+/***************************************************************************//**
+ * @brief Set the LFXO frequency correction
+ *
+ * @details
+ *   The scale from BURTC counts to time is corrected once here, so reading
+ *   the time still needs no division. Time continues from its current value.
+ *
+ * @param[in] ppb
+ *   LFXO frequency error in parts per billion, positive if LFXO is fast
+ ******************************************************************************/
+void clockSetCorrection(int32_t ppb)
+{
+  uint32_t overflows;
+  uint32_t count;
+  uint64_t before;
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  overflows = clockGetCounters(&count);
+  before    = clockCountToTime(overflows, count);
+
+  /* Seconds per count are 1 / (COUNTS_PER_SEC * (1 + ppb / 10^9)) */
+  countScale    = COUNT_SCALE - (int64_t)(COUNT_SCALE / (NSEC_PER_SEC + ppb)) * ppb;
+  rtcCorrection = ppb;
+
+  /* Same time at the current count with the new scale */
+  rtcTimeOffset = 0;
+  rtcTimeOffset = (int64_t)(before - clockCountToTime(overflows, count));
+
+  __set_PRIMASK(primask);
+}
+
+
+
+/***************************************************************************//**
+ * @brief Restore the LFXO frequency correction, e.g. from retention memory
+ *
+ * @param[in] ppb
+ *   LFXO frequency error in parts per billion
+ *
+ * @param[in] offset
+ *   Time offset returned by clockGetCorrection()
+ ******************************************************************************/
+void clockRestoreCorrection(int32_t ppb, int64_t offset)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  countScale    = COUNT_SCALE - (int64_t)(COUNT_SCALE / (NSEC_PER_SEC + ppb)) * ppb;
+  rtcCorrection = ppb;
+  rtcTimeOffset = offset;
+
+  __set_PRIMASK(primask);
+}
+
+
+
+/***************************************************************************//**
+ * @brief Get the LFXO frequency correction
+ *
+ * @param[out] offset
+ *   Time offset which belongs to the correction
+ *
+ * @return
+ *   LFXO frequency error in parts per billion
+ ******************************************************************************/
+int32_t clockGetCorrection(int64_t *offset)
+{
+  *offset = rtcTimeOffset;
+  return rtcCorrection;
+}
+
+
+
+/***************************************************************************//**
+ * @brief Get the corrected number of BURTC counts per second
+ *
+ * @return
+ *   Counts per second in 32.32 fixed point
+ ******************************************************************************/
+uint64_t clockGetCountsPerSec(void)
+{
+  uint64_t counts = (uint64_t)COUNTS_PER_SEC << 32;
+
+  return counts + (int64_t)(counts / NSEC_PER_SEC) * rtcCorrection;
+}
+
+
+
 /***************************************************************************//**
  * @brief Set the epoch offset
  *
@@ -149,13 +380,18 @@ void clockInit(struct tm * timeptr)
 {
   /* Reset variables */
   rtcOverflowCounter = 0;
-
-  /* Set overflow interval based on counter width and frequency */
-  overflow_interval  =  ((uint64_t)UINT32_MAX+1) / COUNTS_PER_SEC; /* in seconds */
-  overflow_interval_r = ((uint64_t)UINT32_MAX+1) % COUNTS_PER_SEC; /* division remainder */
+  clockRestoreCorrection(0, 0);
 
   /* Set epoch offset */
   clockSetCal(timeptr);
+
+  /* Keep time through EM4 hibernation. The time would be wrong after an EM4
+     wake-up if a block did not fit in the snapshot. */
+  EFM_ASSERT(hibernateRegister(&rtcStartTime, sizeof(rtcStartTime)));
+  EFM_ASSERT(hibernateRegister((void *)&rtcOverflowCounter, sizeof(rtcOverflowCounter)));
+  EFM_ASSERT(hibernateRegister(&countScale, sizeof(countScale)));
+  EFM_ASSERT(hibernateRegister(&rtcCorrection, sizeof(rtcCorrection)));
+  EFM_ASSERT(hibernateRegister(&rtcTimeOffset, sizeof(rtcTimeOffset)));
 }
 
 
@@ -37,12 +37,41 @@
 #define __CLOCK_H
 
 #include <time.h>
+#if defined (__GNUC__)
+#include <sys/time.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if !defined (__GNUC__)
+/* POSIX time types, not defined by the IAR and Keil libraries */
+typedef int clockid_t;
+
+struct timespec
+{
+  time_t tv_sec;   /* Seconds */
+  long   tv_nsec;  /* Nanoseconds */
+};
+
+struct timeval
+{
+  time_t tv_sec;   /* Seconds */
+  long   tv_usec;  /* Microseconds */
+};
+#endif
+
+#ifndef CLOCK_REALTIME
+#define CLOCK_REALTIME  ((clockid_t) 1)
+#endif
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC ((clockid_t) 4)
+#endif
+
 /* Function prototypes*/
+int clock_gettime(clockid_t clk_id, struct timespec *tp);
+int gettimeofday(struct timeval *tv, void *tz);
 void clockInit(struct tm * timeptr);
 void clockSetCal(struct tm * timeptr);
 void clockSetStartTime(time_t offset);
@@ -50,6 +79,11 @@ time_t clockGetStartTime(void);
 uint32_t clockOverflow(void);
 void clockSetOverflowCounter(uint32_t of);
 uint32_t clockGetOverflowCounter(void);
+uint32_t clockGetCounters(uint32_t *count);
+void clockSetCorrection(int32_t ppb);
+void clockRestoreCorrection(int32_t ppb, int64_t offset);
+int32_t clockGetCorrection(int64_t *offset);
+uint64_t clockGetCountsPerSec(void);
 
 #ifdef __cplusplus
 }
@@ -34,19 +34,33 @@
  *
  *****************************************************************************/
 #include <stdint.h>
-#include <stdio.h>
+#include <stdbool.h>
 #include "em_device.h"
+#include "em_assert.h"
 #include "em_gpio.h"
 #include "em_burtc.h"
 #include "em_cmu.h"
 #include "clock.h"
 #include "clockApp.h"
+#include "calibrate.h"
+#include "alarm.h"
+#include "hibernate.h"
 #include "segmentlcd.h"
 
 /* Calendar struct */
 static struct tm calendar;
 static time_t startTime;
 
+/* Declare variables for the calendar, which is advanced on every update
+   interval and only derived from system time after a restore or a set */
+static volatile uint32_t calendarTicks = 0;     /* Update intervals counted */
+static uint32_t          calendarTicksDone = 0; /* Intervals added to calendar */
+static volatile bool     calendarSet = true;    /* Derive from system time */
+
+/* Days in each month of a non-leap year */
+static const uint8_t daysInMonth[12] = { 31, 28, 31, 30, 31, 30,
+                                         31, 31, 30, 31, 30, 31 };
+
 /** Interrupt pin used to detect STK button/joystick activity */
 #define UIF_PB0_PORT    gpioPortB
 #define UIF_PB0_PIN     9
@@ -64,15 +78,50 @@ static uint32_t  burtcCount = 0;
 static uint32_t  burtcOverflowCounter = 0;
 static uint32_t  burtcOverflowIntervalRem;
 // static uint32_t  burtcOverflowInterval;
-static uint32_t  burtcTimestamp;
 static time_t    currentTime;
 
+/* Retention register journal. Two records are written alternately, so a
+   record torn by entering backup mode while it was written leaves the other
+   one intact. Every record takes JOURNAL_WORDS retention registers. */
+#define JOURNAL_SLOTS      2
+#define JOURNAL_SEQUENCE   0  /* Incremented on every backup */
+#define JOURNAL_OVERFLOWS  1  /* Number of BURTC overflows */
+#define JOURNAL_START_TIME 2  /* Epoch offset */
+#define JOURNAL_COUNT      3  /* BURTC counter at backup */
+#define JOURNAL_CORRECTION 4  /* LFXO frequency error in ppb */
+#define JOURNAL_OFFSET_LO  5  /* Time offset of the correction */
+#define JOURNAL_OFFSET_HI  6
+#define JOURNAL_CHECKSUM   7  /* Checksum of the words above, written last */
+#define JOURNAL_WORDS      8
+
+static uint32_t  journalSequence = 0;  /* Sequence of the newest record */
+static uint32_t  journalSlot = 0;      /* Slot of the newest record */
+
 /* Clock defines */
 #define LFXO_FREQUENCY 32768
 #define BURTC_PRESCALING 128
 #define UPDATE_INTERVAL 1
 #define COUNTS_PER_SEC (LFXO_FREQUENCY/BURTC_PRESCALING)
 #define COUNTS_BETWEEN_UPDATE (UPDATE_INTERVAL*COUNTS_PER_SEC)
+#define CALIBRATION_INTERVAL (24*60*60)  /* Seconds between LFXO calibrations */
+
+/* Hibernation defines */
+#define HIBERNATE_IDLE_TIME     300  /* Seconds without button press before EM4 */
+#define HIBERNATE_WAKE_INTERVAL 60   /* Seconds in EM4 between wake-ups */
+#define HIBERNATE_AWAKE_TIME    5    /* Seconds awake after a wake-up */
+
+/* Declare variables for the update interval, corrected for the LFXO error */
+static uint64_t  compareNext;           /* Next compare value, 32.32 fixed point */
+static uint64_t  compareStep = (uint64_t)COUNTS_BETWEEN_UPDATE << 32;
+static uint32_t  calibrationTicks = 0;  /* calendarTicks at last calibration */
+
+/* BURTC compare is shared by all alarms, the update interval is one of them */
+static AlarmQueue_TypeDef burtcAlarms;
+static Alarm_TypeDef      updateAlarm;
+static Alarm_TypeDef      wakeAlarm;
+
+/* calendarTicks at last button press or wake-up */
+static volatile uint32_t activityTicks = 0;
 
 /**************************************************************************//**
  * @brief GPIO Odd Interrupt Handler
@@ -80,19 +129,23 @@ static time_t    currentTime;
  *****************************************************************************/
 void GPIO_ODD_IRQHandler(void)
 {
+  struct tm setCalendar;
+
   /* Clear GPIO interrupt */
   GPIO_IntClear(1 << UIF_PB0_PIN);
 
   startTime = clockGetStartTime( );
-  calendar = *localtime( &startTime );
+  setCalendar = *localtime( &startTime );
 
-  calendar.tm_hour++;
+  setCalendar.tm_hour++;
 
   /* Set new epoch offset */
-  startTime = mktime(&calendar);
+  startTime = mktime(&setCalendar);
   clockSetStartTime( startTime );
   clockAppBackup( );
+  calendarSet = true;
   lcdUpdate = true;
+  activityTicks = calendarTicks;
 
 }
 
@@ -102,19 +155,23 @@ void GPIO_ODD_IRQHandler(void)
  *****************************************************************************/
 void GPIO_EVEN_IRQHandler(void)
 {
+  struct tm setCalendar;
+
   /* Clear GPIO interrupt */
   GPIO_IntClear(1 << UIF_PB1_PIN);
 
   startTime = clockGetStartTime( );
-  calendar = *localtime( &startTime );
+  setCalendar = *localtime( &startTime );
 
-  calendar.tm_min++;
+  setCalendar.tm_min++;
 
   /* Set new epoch offset */
-  startTime = mktime(&calendar);
+  startTime = mktime(&setCalendar);
   clockSetStartTime( startTime );
   clockAppBackup( );
+  calendarSet = true;
   lcdUpdate = true;
+  activityTicks = calendarTicks;
 
 }
 
@@ -133,11 +190,10 @@ void BURTC_IRQHandler(void)
   BURTC_IntClear(irq);
 
   /* Interrupt source: compare match */
-  /*   Increment compare value and
-   *   update TFT display            */
+  /*   Call back due alarms          */
   if ( irq & BURTC_IF_COMP0 )
   {
-    BURTC_CompareSet(0, BURTC->COMP0 + COUNTS_BETWEEN_UPDATE );
+    alarmDispatch(&burtcAlarms);
   }
 
   /* Interrupt source: counter overflow */
@@ -153,17 +209,121 @@ void BURTC_IRQHandler(void)
 }
 
 
+/**************************************************************************//**
+ * @brief Update interval alarm callback
+ *
+ *   Schedules the next update, advances calendar and updates display
+ *****************************************************************************/
+static void clockAppUpdateAlarm(void *user)
+{
+  (void)user;                                     /* Unused parameter */
+
+  compareNext += compareStep;
+  alarmStart(&burtcAlarms, &updateAlarm, (uint32_t)(compareNext >> 32));
+  calendarTicks++;
+}
+
+
+/**************************************************************************//**
+ * @brief Wake-up alarm callback
+ *
+ *   The alarm wakes the device from EM4, and is only called back if it is
+ *   due before the device hibernates.
+ *****************************************************************************/
+static void clockAppWakeAlarm(void *user)
+{
+  (void)user;                                     /* Unused parameter */
+}
+
+
+/**************************************************************************//**
+ * @brief Checksum of a journal record
+ *****************************************************************************/
+static uint32_t journalChecksum(const uint32_t *record)
+{
+  uint32_t sum = 0;
+  uint32_t i;
+
+  for ( i = 0; i < JOURNAL_CHECKSUM; i++ )
+  {
+    sum = ((sum << 5) | (sum >> 27)) ^ record[i];
+  }
+
+  /* Inverted, so cleared retention registers are not a valid record */
+  return ~sum;
+}
+
+
+/**************************************************************************//**
+ * @brief Read the newest valid record from the journal
+ *
+ * @param[out] record Newest valid record
+ *
+ * @return true if a valid record was found
+ *****************************************************************************/
+static bool journalRead(uint32_t *record)
+{
+  uint32_t slotRecord[JOURNAL_WORDS];
+  uint32_t slot;
+  uint32_t i;
+  bool     valid = false;
+
+  for ( slot = 0; slot < JOURNAL_SLOTS; slot++ )
+  {
+    for ( i = 0; i < JOURNAL_WORDS; i++ )
+    {
+      slotRecord[i] = BURTC_RetRegGet(slot * JOURNAL_WORDS + i);
+    }
+
+    if ( slotRecord[JOURNAL_CHECKSUM] != journalChecksum(slotRecord) )
+    {
+      continue;
+    }
+
+    /* Keep the record with the newest sequence number */
+    if ( !valid || ((int32_t)(slotRecord[JOURNAL_SEQUENCE] - journalSequence) > 0) )
+    {
+      for ( i = 0; i < JOURNAL_WORDS; i++ )
+      {
+        record[i] = slotRecord[i];
+      }
+      journalSequence = slotRecord[JOURNAL_SEQUENCE];
+      journalSlot     = slot;
+      valid           = true;
+    }
+  }
+
+  return valid;
+}
+
+
 /**************************************************************************//**
  * @brief Initialize clock application
  *****************************************************************************/
 void clockAppInit(void)
 {
+  uint32_t record[JOURNAL_WORDS];
+
+  /* Continue the sequence of an existing journal, so that a new backup is
+     always newer than old records */
+  journalRead(record);
+
   /* Compute overflow interval (integer) and remainder */
   // burtcOverflowInterval  =  ((uint64_t)UINT32_MAX+1)/COUNTS_BETWEEN_UPDATE; /* in seconds */
   burtcOverflowIntervalRem = ((uint64_t)UINT32_MAX+1)%COUNTS_BETWEEN_UPDATE;
 
   // burtcSetComp( COUNTS_BETWEEN_UPDATE );
-  BURTC_CompareSet(0, COUNTS_BETWEEN_UPDATE );
+  alarmQueueInit(&burtcAlarms, &alarmTimerBurtc);
+  alarmInit(&updateAlarm, clockAppUpdateAlarm, NULL);
+  alarmInit(&wakeAlarm, clockAppWakeAlarm, NULL);
+
+  /* Keep calendar and update interval through EM4 hibernation */
+  EFM_ASSERT(hibernateRegister(&calendar, sizeof(calendar)));
+  EFM_ASSERT(hibernateRegister((void *)&calendarTicks, sizeof(calendarTicks)));
+  EFM_ASSERT(hibernateRegister(&calendarTicksDone, sizeof(calendarTicksDone)));
+  EFM_ASSERT(hibernateRegister((void *)&calendarSet, sizeof(calendarSet)));
+  EFM_ASSERT(hibernateRegister(&compareNext, sizeof(compareNext)));
+  EFM_ASSERT(hibernateRegister(&calibrationTicks, sizeof(calibrationTicks)));
 
   /* Initialize interrupts for STK */
   gpioIrqInit();
@@ -175,53 +335,154 @@ void clockAppInit(void)
 
 
 
+/**************************************************************************//**
+ * @brief  Start update interval on a newly configured BURTC
+ *****************************************************************************/
+void clockAppStart(void)
+{
+  compareNext = (uint64_t)COUNTS_BETWEEN_UPDATE << 32;
+  alarmStart(&burtcAlarms, &updateAlarm, COUNTS_BETWEEN_UPDATE);
+}
+
+
+
+/**************************************************************************//**
+ * @brief  Continue after EM4 hibernation
+ *
+ *   Time, calendar and update interval are restored by hibernateResume().
+ *   The BURTC kept counting in EM4, and only the update intervals passed
+ *   while hibernating are added.
+ *****************************************************************************/
+void clockAppResume(void)
+{
+  uint32_t count;
+
+  compareStep = clockGetCountsPerSec() * UPDATE_INTERVAL;
+
+  /* Skip update intervals passed in EM4, the calendar is advanced by them */
+  count = BURTC_CounterGet();
+  while ( (int32_t)(count - (uint32_t)(compareNext >> 32)) >= 0 )
+  {
+    compareNext += compareStep;
+    calendarTicks++;
+  }
+  alarmStart(&burtcAlarms, &updateAlarm, (uint32_t)(compareNext >> 32));
+
+  /* Hibernate again after HIBERNATE_AWAKE_TIME */
+  activityTicks = calendarTicks - (HIBERNATE_IDLE_TIME - HIBERNATE_AWAKE_TIME) / UPDATE_INTERVAL;
+  lcdUpdate = true;
+}
+
+
+/**************************************************************************//**
+ * @brief  Check if the application is idle and should hibernate
+ *****************************************************************************/
+bool clockAppHibernateDue(void)
+{
+  return (calendarTicks - activityTicks) >= (HIBERNATE_IDLE_TIME / UPDATE_INTERVAL);
+}
+
+
+/**************************************************************************//**
+ * @brief  Enter EM4 until the next wake-up interval
+ *
+ *   Time is backed up to the journal as well, in case main power is lost in
+ *   EM4. Does not return.
+ *****************************************************************************/
+void clockAppHibernate(void)
+{
+  /* Only the wake-up alarm is left in the BURTC compare register */
+  alarmStop(&burtcAlarms, &updateAlarm);
+  alarmStartDelay(&burtcAlarms, &wakeAlarm, HIBERNATE_WAKE_INTERVAL * COUNTS_PER_SEC);
+  BURTC_IntClear(BURTC_IF_COMP0);
+
+  clockAppBackup();
+  hibernateEnter();
+}
+
+
 /**************************************************************************//**
  * @brief  Backup CALENDAR to retention registers
  *
- *   Retention register 0 : Number of BURTC overflows
- *   Retention register 1 : Epoch offset
+ *   A record with the number of BURTC overflows, the epoch offset and the
+ *   BURTC counter is written to the journal slot which does not hold the
+ *   newest record. The checksum is written last, and makes the record valid.
  *****************************************************************************/
 void clockAppBackup(void)
 {
-  /* Write overflow counter to retention memory */
-  BURTC_RetRegSet(0, clockGetOverflowCounter() );
+  uint32_t record[JOURNAL_WORDS];
+  uint32_t slot;
+  uint32_t i;
+  int64_t  offset;
+
+  record[JOURNAL_SEQUENCE]   = journalSequence + 1;
+  record[JOURNAL_OVERFLOWS]  = clockGetCounters(&record[JOURNAL_COUNT]);
+  record[JOURNAL_START_TIME] = clockGetStartTime();
+  record[JOURNAL_CORRECTION] = (uint32_t)clockGetCorrection(&offset);
+  record[JOURNAL_OFFSET_LO]  = (uint32_t)offset;
+  record[JOURNAL_OFFSET_HI]  = (uint32_t)((uint64_t)offset >> 32);
+  record[JOURNAL_CHECKSUM]   = journalChecksum(record);
+
+  slot = (journalSlot + 1) % JOURNAL_SLOTS;
+  for ( i = 0; i < JOURNAL_WORDS; i++ )
+  {
+    BURTC_RetRegSet(slot * JOURNAL_WORDS + i, record[i]);
+  }
 
-  /* Write local epoch offset to retention memory */
-  BURTC_RetRegSet(1, clockGetStartTime());
+  journalSequence = record[JOURNAL_SEQUENCE];
+  journalSlot     = slot;
 }
 
 
 /**************************************************************************//**
  * @brief  Restore CALENDAR from retention registers
  *
+ *   The newest valid journal record is used. A record torn by entering backup
+ *   mode while it was written (BURTC_STATUS_RAMWERR) fails its checksum, and
+ *   the previous record is used instead.
+ *
+ *   Overflows are counted by the overflow interrupt and recorded, so only
+ *   overflows since the last record need to be found from the BURTC counter.
+ *   The counter is lower than the recorded one if it has wrapped, which is
+ *   correct for up to one counter period (2^32 counts, 194 days) without a
+ *   running CPU.
+ *
  * @param[in] burtcCountAtWakeup BURTC value at power up. Only used for printout
+ *
+ * @return true if time was restored, false if the journal holds no valid record
  *****************************************************************************/
-void clockAppRestore(uint32_t burtcCountAtWakeup)
+bool clockAppRestore(uint32_t burtcCountAtWakeup)
 {
+  uint32_t record[JOURNAL_WORDS];
   uint32_t burtcStart;
   uint32_t nextUpdate;
   (void)burtcCountAtWakeup;                       /* Unused parameter */
 
+  /* Read newest valid record from retention memory */
+  if ( !journalRead(record) )
+  {
+    return false;
+  }
+
+  /* A pending overflow is counted below, not in the interrupt handler */
+  BURTC_IntClear(BURTC_IF_OF);
 
   /* Store BURTC->CNT for consistency in display output within this function */
   burtcCount = BURTC_CounterGet();
 
-  /* Timestamp is BURTC value at time of main power loss */
-  burtcTimestamp = BURTC_TimestampGet();
-
-  /* Read overflow counter from retention memory */
-  burtcOverflowCounter = BURTC_RetRegGet(0);
-
-  /* Check for overflow while in backup mode
-     Assume that overflow interval >> backup source capacity
-     i.e. that overflow has only occured once during main power loss */
-  if ( burtcCount < burtcTimestamp )
+  /* Restore overflow counter, and check for overflow since the record */
+  burtcOverflowCounter = record[JOURNAL_OVERFLOWS];
+  if ( burtcCount < record[JOURNAL_COUNT] )
   {
     burtcOverflowCounter++;
   }
 
-  /* Restore epoch offset from retention memory */
-  clockSetStartTime(BURTC_RetRegGet(1));
+  /* Restore epoch offset and LFXO correction from retention memory */
+  clockSetStartTime(record[JOURNAL_START_TIME]);
+  clockRestoreCorrection((int32_t)record[JOURNAL_CORRECTION],
+                         (int64_t)(((uint64_t)record[JOURNAL_OFFSET_HI] << 32)
+                                   | record[JOURNAL_OFFSET_LO]));
+  compareStep = clockGetCountsPerSec() * UPDATE_INTERVAL;
 
   /* Restore clock overflow counter */
   clockSetOverflowCounter(burtcOverflowCounter);
@@ -236,7 +497,164 @@ void clockAppRestore(uint32_t burtcCountAtWakeup)
       pass COMP value before interrupts are enabled */
   nextUpdate = burtcStart + ((burtcCount / COUNTS_BETWEEN_UPDATE) +1 ) * COUNTS_BETWEEN_UPDATE ;
 
-  BURTC_CompareSet(0, nextUpdate);
+  compareNext = (uint64_t)nextUpdate << 32;
+  alarmStart(&burtcAlarms, &updateAlarm, nextUpdate);
+
+  /* Derive calendar from restored time */
+  calendarSet = true;
+
+  /* Record restored time, the counter may wrap before the next overflow
+     interrupt */
+  clockAppBackup();
+
+  return true;
+}
+
+
+/**************************************************************************//**
+ * @brief  Calibrate LFXO against HFXO and correct the clock
+ *
+ *   The correction is kept in retention memory with the rest of the clock.
+ *****************************************************************************/
+void clockAppCalibrate(void)
+{
+  int32_t  ppb;
+  uint32_t primask;
+
+  calibrationTicks = calendarTicks;
+
+  if ( !calibrateLfxo(&ppb) )
+  {
+    return;
+  }
+
+  clockSetCorrection(ppb);
+
+  /* Corrected update interval */
+  primask = __get_PRIMASK();
+  __disable_irq();
+  compareStep = clockGetCountsPerSec() * UPDATE_INTERVAL;
+  __set_PRIMASK(primask);
+
+  clockAppBackup();
+}
+
+
+/**************************************************************************//**
+ * @brief  Check if LFXO should be calibrated again
+ *****************************************************************************/
+bool clockAppCalibrationDue(void)
+{
+  return (calendarTicks - calibrationTicks) >= (CALIBRATION_INTERVAL / UPDATE_INTERVAL);
+}
+
+
+/**************************************************************************//**
+ * @brief  Check if a year of the calendar is a leap year
+ *
+ * @param[in] year Years since 1900
+ *****************************************************************************/
+static bool calendarLeapYear(int year)
+{
+  year += 1900;
+  return ((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0));
+}
+
+
+/**************************************************************************//**
+ * @brief  Advance calendar by one second
+ *
+ *   Handles minute, hour, day, month and year rollovers, including leap years.
+ *****************************************************************************/
+static void calendarNextSecond(void)
+{
+  int days;
+
+  if ( ++calendar.tm_sec < 60 ) return;
+  calendar.tm_sec = 0;
+  if ( ++calendar.tm_min < 60 ) return;
+  calendar.tm_min = 0;
+  if ( ++calendar.tm_hour < 24 ) return;
+  calendar.tm_hour = 0;
+
+  /* Next day */
+  calendar.tm_wday = (calendar.tm_wday + 1) % 7;
+  calendar.tm_yday++;
+
+  days = daysInMonth[calendar.tm_mon];
+  if ( (calendar.tm_mon == 1) && calendarLeapYear(calendar.tm_year) )
+  {
+    days++;
+  }
+  if ( ++calendar.tm_mday <= days ) return;
+  calendar.tm_mday = 1;
+  if ( ++calendar.tm_mon < 12 ) return;
+  calendar.tm_mon  = 0;
+  calendar.tm_yday = 0;
+  calendar.tm_year++;
+}
+
+
+/**************************************************************************//**
+ * @brief  Derive calendar from system time
+ *****************************************************************************/
+static void calendarSync(void)
+{
+  uint32_t primask;
+
+  /* Read system time and counted update intervals together */
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  calendarSet       = false;
+  calendarTicksDone = calendarTicks;
+  currentTime       = time( NULL );
+
+  /* System time already includes an interval whose alarm is not yet
+     dispatched */
+  if ( (int32_t)(BURTC_CounterGet() - (uint32_t)(compareNext >> 32)) >= 0 )
+  {
+    calendarTicksDone++;
+  }
+
+  __set_PRIMASK(primask);
+
+  calendar = *localtime( &currentTime );
+}
+
+
+/**************************************************************************//**
+ * @brief  Bring calendar up to date
+ *****************************************************************************/
+static void calendarUpdate(void)
+{
+  uint32_t i;
+
+  if ( calendarSet )
+  {
+    calendarSync();
+    return;
+  }
+
+  /* Add the update intervals counted since the last update */
+  while ( calendarTicksDone != calendarTicks )
+  {
+    calendarTicksDone++;
+    for ( i = 0; i < UPDATE_INTERVAL; i++ )
+    {
+      calendarNextSecond();
+    }
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Write a number as two digits
+ *****************************************************************************/
+static void lcdTwoDigits(char *str, int value)
+{
+  str[0] = '0' + (value / 10);
+  str[1] = '0' + (value % 10);
 }
 
 
@@ -255,11 +673,12 @@ void clockAppDisplay(void)
   }
   if ( lcdUpdate )
   {
-    currentTime = time( NULL );
-    calendar = *localtime( &currentTime );
-    sprintf( lcdString, "%02d%02d%02d", calendar.tm_hour,
-                                        calendar.tm_min,
-                                        calendar.tm_sec );
+    calendarUpdate();
+
+    lcdTwoDigits( &lcdString[0], calendar.tm_hour );
+    lcdTwoDigits( &lcdString[2], calendar.tm_min );
+    lcdTwoDigits( &lcdString[4], calendar.tm_sec );
+    lcdString[6] = '\0';
 
     /* Print string to TFT display using GLIB_drawString routine */
     SegmentLCD_Write(lcdString);
@@ -35,21 +35,29 @@
 #ifndef __CLOCKAPP_H
 #define __CLOCKAPP_H
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /* Function prototypes */
 void clockAppInit(void);
+void clockAppStart(void);
+void clockAppResume(void);
+bool clockAppHibernateDue(void);
+void clockAppHibernate(void);
 void clockAppDisplay(void);
 void clockAppBackup(void);
-void clockAppRestore(uint32_t);
+bool clockAppRestore(uint32_t);
 void clockAppUpdate(void);
 void clockAppPrintWakeupStatus(uint32_t);
 void clockAppPrintRamWErr(void);
 void clockAppPrintNoTimestamp(void);
 void clockAppPrintResetCause(uint32_t);
 void clockAppOverflow(void);
+void clockAppCalibrate(void);
+bool clockAppCalibrationDue(void);
 
 void gpioIrqInit(void);
 
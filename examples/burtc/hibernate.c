@@ -0,0 +1,237 @@
+/***************************************************************************//**
+ * @file
+ * @brief EM4 hibernation with state kept in BURTC retention registers
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_burtc.h"
+#include "em_emu.h"
+#include "em_rmu.h"
+#include "hibernate.h"
+
+/******************************************************************************
+ * The application registers the variables it needs to continue after EM4
+ * with hibernateRegister(). hibernateEnter() copies them to the BURTC
+ * retention registers as one snapshot and enters EM4. After the EM4 wake-up
+ * reset, hibernateResume() copies them back, so the application can skip
+ * initialization of the state and of peripherals which kept their
+ * configuration through EM4.
+ *
+ * The snapshot is a header word with the layout of the registered blocks, the
+ * block contents and a checksum. A snapshot written by a program which
+ * registers other blocks, torn by a power failure, or already resumed from,
+ * is not restored.
+ *****************************************************************************/
+
+/* Snapshot header: magic, number of blocks and number of data words */
+#define HIBERNATE_MAGIC         0xB4000000UL
+#define HIBERNATE_HEADER(blocks, words) \
+  (HIBERNATE_MAGIC | ((uint32_t)(blocks) << 16) | (uint32_t)(words))
+
+/* Data words available between header and checksum */
+#define HIBERNATE_DATA_WORDS    (HIBERNATE_RETREG_COUNT - 2)
+
+/* Registered state blocks */
+static struct
+{
+  uint8_t  *data;
+  uint32_t size;
+} hibernateBlocks[HIBERNATE_MAX_BLOCKS];
+
+static uint32_t hibernateBlockCount = 0;
+static uint32_t hibernateWords = 0;     /* Data words of all blocks */
+
+
+/**************************************************************************//**
+ * @brief Add a word to a snapshot checksum
+ *****************************************************************************/
+static uint32_t hibernateChecksum(uint32_t sum, uint32_t word)
+{
+  return ((sum << 5) | (sum >> 27)) ^ word;
+}
+
+
+/**************************************************************************//**
+ * @brief Register a state block to be kept through EM4
+ *
+ *   Blocks must be registered in the same order on every start, before
+ *   hibernateResume() is called.
+ *
+ * @param[in] data Start of the block
+ * @param[in] size Size of the block in bytes
+ *
+ * @return false if the block does not fit in the retention registers
+ *****************************************************************************/
+bool hibernateRegister(void *data, uint32_t size)
+{
+  uint32_t words = (size + 3) / 4;
+  uint32_t i;
+
+  /* Already registered */
+  for ( i = 0; i < hibernateBlockCount; i++ )
+  {
+    if ( hibernateBlocks[i].data == data )
+    {
+      return true;
+    }
+  }
+
+  if ( (hibernateBlockCount == HIBERNATE_MAX_BLOCKS)
+       || (hibernateWords + words > HIBERNATE_DATA_WORDS) )
+  {
+    return false;
+  }
+
+  hibernateBlocks[hibernateBlockCount].data = data;
+  hibernateBlocks[hibernateBlockCount].size = size;
+  hibernateBlockCount++;
+  hibernateWords += words;
+
+  return true;
+}
+
+
+/**************************************************************************//**
+ * @brief Write registered state blocks to the retention registers
+ *
+ *   The checksum is written last and makes the snapshot valid.
+ *****************************************************************************/
+void hibernateSave(void)
+{
+  uint32_t reg = HIBERNATE_RETREG_FIRST;
+  uint32_t header;
+  uint32_t sum;
+  uint32_t word;
+  uint32_t block;
+  uint32_t offset;
+  uint32_t bytes;
+
+  /* Invalidate while writing */
+  BURTC_RetRegSet(HIBERNATE_RETREG_FIRST, 0);
+
+  header = HIBERNATE_HEADER(hibernateBlockCount, hibernateWords);
+  sum    = hibernateChecksum(0, header);
+  reg++;
+
+  for ( block = 0; block < hibernateBlockCount; block++ )
+  {
+    for ( offset = 0; offset < hibernateBlocks[block].size; offset += 4 )
+    {
+      bytes = hibernateBlocks[block].size - offset;
+      word  = 0;
+      memcpy(&word, hibernateBlocks[block].data + offset, bytes < 4 ? bytes : 4);
+
+      BURTC_RetRegSet(reg++, word);
+      sum = hibernateChecksum(sum, word);
+    }
+  }
+
+  /* Inverted, so cleared retention registers are not a valid snapshot */
+  BURTC_RetRegSet(reg, ~sum);
+  BURTC_RetRegSet(HIBERNATE_RETREG_FIRST, header);
+}
+
+
+/**************************************************************************//**
+ * @brief Save state and enter EM4
+ *
+ *   Does not return. The device wakes up through a reset, on the wake-up
+ *   sources configured with EMU_EM4Init(), e.g. a BURTC interrupt.
+ *****************************************************************************/
+void hibernateEnter(void)
+{
+  hibernateSave();
+  EMU_EnterEM4();
+}
+
+
+/**************************************************************************//**
+ * @brief Restore state after an EM4 wake-up
+ *
+ *   The snapshot is invalidated, so it is only restored once.
+ *
+ * @param[in] resetCause RMU->RSTCAUSE read at start-up
+ *
+ * @return true if the device woke up from EM4 and all registered blocks were
+ *   restored, else no block is changed
+ *****************************************************************************/
+bool hibernateResume(uint32_t resetCause)
+{
+  uint32_t reg = HIBERNATE_RETREG_FIRST;
+  uint32_t header;
+  uint32_t sum;
+  uint32_t word;
+  uint32_t block;
+  uint32_t offset;
+  uint32_t bytes;
+
+  if ( !(resetCause & RMU_RSTCAUSE_EM4WURST) )
+  {
+    return false;
+  }
+
+  /* Snapshot of the same blocks */
+  header = BURTC_RetRegGet(reg++);
+  if ( header != HIBERNATE_HEADER(hibernateBlockCount, hibernateWords) )
+  {
+    return false;
+  }
+
+  sum = hibernateChecksum(0, header);
+  while ( reg < HIBERNATE_RETREG_FIRST + 1 + hibernateWords )
+  {
+    sum = hibernateChecksum(sum, BURTC_RetRegGet(reg++));
+  }
+  if ( BURTC_RetRegGet(reg) != ~sum )
+  {
+    return false;
+  }
+
+  /* Restore blocks */
+  reg = HIBERNATE_RETREG_FIRST + 1;
+  for ( block = 0; block < hibernateBlockCount; block++ )
+  {
+    for ( offset = 0; offset < hibernateBlocks[block].size; offset += 4 )
+    {
+      bytes = hibernateBlocks[block].size - offset;
+      word  = BURTC_RetRegGet(reg++);
+      memcpy(hibernateBlocks[block].data + offset, &word, bytes < 4 ? bytes : 4);
+    }
+  }
+
+  BURTC_RetRegSet(HIBERNATE_RETREG_FIRST, 0);
+
+  return true;
+}
@@ -0,0 +1,64 @@
+/***************************************************************************//**
+ * @file
+ * @brief EM4 hibernation with state kept in BURTC retention registers
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+
+#ifndef __HIBERNATE_H
+#define __HIBERNATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Retention registers used for the state snapshot, registers below
+   HIBERNATE_RETREG_FIRST hold the clock journal (see clockApp.c) */
+#define HIBERNATE_RETREG_FIRST  16
+#define HIBERNATE_RETREG_COUNT  (128 - HIBERNATE_RETREG_FIRST)
+
+/* Maximum number of registered state blocks */
+#define HIBERNATE_MAX_BLOCKS    16
+
+/* Function prototypes */
+bool hibernateRegister(void *data, uint32_t size);
+void hibernateSave(void);
+void hibernateEnter(void);
+bool hibernateResume(uint32_t resetCause);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,504 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host simulator and stress test of the alarm scheduler
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "alarm.h"
+#include "alarmsim.h"
+
+/******************************************************************************
+*  Runs the alarm scheduler (alarm.c) on a simulated counter with a compare
+*  channel, and checks that
+*
+*  - alarms are called back in order of due time: no scheduled alarm is
+*    earlier than the one called back
+*  - alarms are never called back early, and not later than the interrupt
+*    latency plus the compare synchronization delay
+*  - every started alarm is called back exactly once, unless stopped
+*
+*  The counter advances by one count per step. A written compare value takes
+*  effect after a synchronization delay, like in the low frequency domain,
+*  and the compare interrupt is taken after a random latency. Between
+*  interrupts, random alarms are started, restarted and stopped, with due
+*  times from the past to the maximum delay. Half of the alarms are periodic
+*  and restart themselves from their callback.
+*
+*  usage: alarmsim [-w width] [-n steps] [-a alarms] [-l latency] [-d delay]
+*                  [-s seed]
+******************************************************************************/
+
+/* Simulated counter and compare channel */
+static uint32_t simWidth   = 24;     /* Counter width */
+static uint32_t simMask;             /* Counter mask */
+static uint32_t simCounter;          /* Counter */
+static uint32_t simCompare;          /* Compare value in effect */
+static uint32_t simCompareNew;       /* Compare value being synchronized */
+static uint32_t simSyncLeft;         /* Counts until new compare value */
+static uint32_t simSyncDelay = 2;    /* Synchronization delay in counts */
+static bool     simIen;              /* Compare interrupt enabled */
+static bool     simIf;               /* Compare interrupt flag */
+static uint32_t simLatency   = 3;    /* Maximum interrupt latency in counts */
+static uint32_t simLatencyLeft;      /* Counts until interrupt is taken */
+static uint32_t simPrimask;          /* Interrupts disabled */
+static uint32_t simRandom    = 1;    /* Random generator state */
+
+/* Alarms of the test */
+#define ALARMS_MAX  ALARM_MAX
+typedef struct
+{
+  Alarm_TypeDef alarm;
+  uint32_t      period;    /* Restarted from callback if not 0 */
+  uint32_t      started;   /* Counter when started */
+  bool          expected;  /* Started, and not yet called back or stopped */
+} TestAlarm_TypeDef;
+
+static AlarmQueue_TypeDef queue;
+static AlarmTimer_TypeDef simTimer;
+static TestAlarm_TypeDef  alarms[ALARMS_MAX];
+static uint32_t           alarmCount = ALARMS_MAX;
+
+/* Statistics */
+static uint64_t callbacks;
+static uint64_t starts;
+static uint64_t startsRejected;
+static uint64_t stops;
+static uint64_t interrupts;
+static uint64_t wraps;
+static uint64_t lateness[8];         /* Callbacks per lateness in counts */
+static uint32_t latenessMax;
+static uint32_t queueMax;
+static bool     failed;
+
+
+/******************************************************************************
+ * Random number
+ *****************************************************************************/
+static uint32_t simRand(void)
+{
+  simRandom ^= simRandom << 13;
+  simRandom ^= simRandom >> 17;
+  simRandom ^= simRandom << 5;
+  return simRandom;
+}
+
+/******************************************************************************
+ * Signed distance between counter values
+ *****************************************************************************/
+static int32_t simDelta(uint32_t a, uint32_t b)
+{
+  uint32_t shift = 32 - simWidth;
+  return (int32_t)((a - b) << shift) / (int32_t)(1UL << shift);
+}
+
+/******************************************************************************
+ * Report a failed check
+ *****************************************************************************/
+static void simFail(const char *what, const TestAlarm_TypeDef *test)
+{
+  fprintf(stderr, "FAIL: %s, alarm %d due %lu, counter %lu\n", what,
+          (int)(test - alarms), (unsigned long)test->alarm.time,
+          (unsigned long)simCounter);
+  failed = true;
+}
+
+/******************************************************************************
+ * Interrupt mask of the simulated core
+ *****************************************************************************/
+uint32_t __get_PRIMASK(void)
+{
+  return simPrimask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+  simPrimask = primask;
+}
+
+void __disable_irq(void)
+{
+  simPrimask = 1;
+}
+
+/******************************************************************************
+ * Simulated timer
+ *****************************************************************************/
+static uint32_t simCounterGet(void)
+{
+  return simCounter;
+}
+
+static void simCompareSet(uint32_t time)
+{
+  if ( time & ~simMask )
+  {
+    fprintf(stderr, "FAIL: compare value %lx out of range\n", (unsigned long)time);
+    failed = true;
+  }
+  simCompareNew = time;
+  simSyncLeft   = simSyncDelay;
+  simIen        = true;
+  if ( simSyncLeft == 0 )
+  {
+    simCompare = time;
+  }
+}
+
+static void simCompareDisable(void)
+{
+  simIen = false;
+}
+
+static void simInterruptSet(void)
+{
+  simIf = true;
+}
+
+/******************************************************************************
+ * Compare interrupt handler, as BURTC_IRQHandler() or RTC_IRQHandler()
+ *****************************************************************************/
+static void simIrqHandler(void)
+{
+  interrupts++;
+  simIf = false;
+  alarmDispatch(&queue);
+}
+
+/******************************************************************************
+ * Counts an alarm is overdue, from when it was started if due in the past
+ *****************************************************************************/
+static int32_t simLate(const TestAlarm_TypeDef *test)
+{
+  if ( simDelta(test->alarm.time, test->started) < 0 )
+  {
+    return simDelta(simCounter, test->started);
+  }
+  return simDelta(simCounter, test->alarm.time);
+}
+
+/******************************************************************************
+ * Alarm callback
+ *****************************************************************************/
+static void simCallback(void *user)
+{
+  TestAlarm_TypeDef *test = user;
+  uint32_t          i;
+  int32_t           late;
+
+  callbacks++;
+
+  if ( simPrimask )
+  {
+    simFail("callback with interrupts disabled", test);
+  }
+  if ( !test->expected || alarmPending(&test->alarm) )
+  {
+    simFail("unexpected callback", test);
+  }
+  test->expected = false;
+
+  late = simLate(test);
+  if ( simDelta(simCounter, test->alarm.time) < 0 )
+  {
+    simFail("early callback", test);
+  }
+  else
+  {
+    lateness[late < 7 ? late : 7]++;
+    if ( (uint32_t)late > latenessMax )
+    {
+      latenessMax = (uint32_t)late;
+    }
+  }
+
+  /* No scheduled alarm may be earlier */
+  for ( i = 0; i < alarmCount; i++ )
+  {
+    if ( alarmPending(&alarms[i].alarm)
+         && (simDelta(alarms[i].alarm.time, test->alarm.time) < 0) )
+    {
+      simFail("out of order callback", test);
+    }
+  }
+
+  /* Periodic alarm, restart from its due time */
+  if ( test->period )
+  {
+    if ( alarmStart(&queue, &test->alarm, test->alarm.time + test->period) )
+    {
+      test->expected = true;
+      test->started  = simCounter;
+      starts++;
+    }
+    else
+    {
+      startsRejected++;
+    }
+  }
+}
+
+/******************************************************************************
+ * Advance the counter by one count
+ *****************************************************************************/
+static void simStep(void)
+{
+  simCounter = (simCounter + 1) & simMask;
+  if ( simCounter == 0 )
+  {
+    wraps++;
+  }
+
+  if ( simSyncLeft && (--simSyncLeft == 0) )
+  {
+    simCompare = simCompareNew;
+  }
+  if ( simCounter == simCompare )
+  {
+    simIf = true;
+  }
+
+  /* Take pending interrupt after the latency */
+  if ( simIf && simIen )
+  {
+    if ( simLatencyLeft == 0 )
+    {
+      simLatencyLeft = 1 + (simLatency ? simRand() % (simLatency + 1) : 0);
+    }
+    if ( --simLatencyLeft == 0 )
+    {
+      simIrqHandler();
+    }
+  }
+}
+
+/******************************************************************************
+ * Check the earliest alarm is not overdue
+ *****************************************************************************/
+static void simCheckOverdue(void)
+{
+  TestAlarm_TypeDef *head;
+
+  if ( queue.count == 0 )
+  {
+    return;
+  }
+  head = queue.heap[0]->user;
+  if ( simLate(head) > (int32_t)(simLatency + simSyncDelay + 1) )
+  {
+    simFail("missed alarm", head);
+  }
+}
+
+/******************************************************************************
+ * Random due time, mostly close to the counter
+ *****************************************************************************/
+static uint32_t simRandomDelay(void)
+{
+  uint32_t max = alarmMaxDelay(&queue);
+
+  switch ( simRand() % 8 )
+  {
+  case 0:
+    return max - 1 - simRand() % 4;         /* Longest delays */
+  case 1:
+    return -(simRand() % 16);               /* Due or in the past */
+  case 2:
+    return simRand() % 4;                   /* At the synchronization delay */
+  case 3:
+    return simRand() % max;
+  default:
+    return simRand() % (max < 4096 ? max : 4096);
+  }
+}
+
+/******************************************************************************
+ * Start, restart or stop a random alarm
+ *****************************************************************************/
+static void simOperation(void)
+{
+  TestAlarm_TypeDef *test = &alarms[simRand() % alarmCount];
+  uint32_t          delay;
+
+  if ( simRand() % 4 == 0 )
+  {
+    if ( alarmStop(&queue, &test->alarm) != test->expected )
+    {
+      simFail("stop of unexpected alarm", test);
+    }
+    test->expected = false;
+    stops++;
+    return;
+  }
+
+  delay = simRandomDelay();
+  if ( test->period )
+  {
+    delay %= 1024;
+  }
+  if ( alarmStart(&queue, &test->alarm, simCounter + delay) )
+  {
+    test->expected = true;
+    test->started  = simCounter;
+    starts++;
+  }
+  else
+  {
+    startsRejected++;
+    if ( (delay < alarmMaxDelay(&queue)) && (queue.count < ALARM_MAX) )
+    {
+      simFail("start rejected", test);
+    }
+  }
+
+  if ( queue.count > queueMax )
+  {
+    queueMax = queue.count;
+  }
+}
+
+/******************************************************************************
+ * Main function
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+  uint64_t steps = 20000000;
+  uint64_t step;
+  uint32_t i;
+  int      opt;
+
+  while ( (opt = getopt(argc, argv, "w:n:a:l:d:s:")) != -1 )
+  {
+    switch ( opt )
+    {
+    case 'w': simWidth     = strtoul(optarg, NULL, 0); break;
+    case 'n': steps        = strtoull(optarg, NULL, 0); break;
+    case 'a': alarmCount   = strtoul(optarg, NULL, 0); break;
+    case 'l': simLatency   = strtoul(optarg, NULL, 0); break;
+    case 'd': simSyncDelay = strtoul(optarg, NULL, 0); break;
+    case 's': simRandom    = strtoul(optarg, NULL, 0); break;
+    default:
+      fprintf(stderr, "usage: %s [-w width] [-n steps] [-a alarms] [-l latency] "
+              "[-d delay] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+  if ( (simWidth < 8) || (simWidth > 32) || (alarmCount < 1)
+       || (alarmCount > ALARMS_MAX) || (simRandom == 0) )
+  {
+    fprintf(stderr, "invalid option\n");
+    return 2;
+  }
+
+  simMask = 0xFFFFFFFFUL >> (32 - simWidth);
+
+  /* Start just before the counter wraps */
+  simCounter = simMask - 1000;
+  simCompare = simMask;
+
+  /* A compare value must be ahead by the synchronization delay */
+  simTimer.counterGet     = simCounterGet;
+  simTimer.compareSet     = simCompareSet;
+  simTimer.compareDisable = simCompareDisable;
+  simTimer.interruptSet   = simInterruptSet;
+  simTimer.width          = simWidth;
+  simTimer.minDelay       = simSyncDelay;
+  alarmQueueInit(&queue, &simTimer);
+
+  for ( i = 0; i < alarmCount; i++ )
+  {
+    alarmInit(&alarms[i].alarm, simCallback, &alarms[i]);
+    alarms[i].period = (i % 2) ? 1 + simRand() % 256 : 0;
+  }
+
+  printf("%lu bit counter, %lu alarms, interrupt latency up to %lu, "
+         "synchronization delay %lu, max delay %lu\n",
+         (unsigned long)simWidth, (unsigned long)alarmCount,
+         (unsigned long)simLatency, (unsigned long)simSyncDelay,
+         (unsigned long)alarmMaxDelay(&queue));
+
+  /* Random operations between interrupts */
+  for ( step = 0; (step < steps) && !failed; step++ )
+  {
+    if ( simRand() % 16 == 0 )
+    {
+      simOperation();
+    }
+    simStep();
+    simCheckOverdue();
+  }
+
+  /* Stop periodic alarms and wait for all others */
+  for ( i = 0; i < alarmCount; i++ )
+  {
+    alarms[i].period = 0;
+  }
+  while ( (queue.count > 0) && !failed )
+  {
+    /* Skip to the compare value when nothing else can happen */
+    if ( !simIf && !simSyncLeft && simIen && (simDelta(queue.heap[0]->time, simCounter) > 2) )
+    {
+      simCounter = (simCompare - 1) & simMask;
+    }
+    simStep();
+    simCheckOverdue();
+  }
+  for ( i = 0; (i < alarmCount) && !failed; i++ )
+  {
+    if ( alarms[i].expected )
+    {
+      simFail("alarm never called back", &alarms[i]);
+    }
+  }
+
+  printf("starts %llu (rejected %llu), stops %llu, callbacks %llu, "
+         "interrupts %llu, counter wraps %llu, queue length up to %lu\n",
+         (unsigned long long)starts, (unsigned long long)startsRejected,
+         (unsigned long long)stops, (unsigned long long)callbacks,
+         (unsigned long long)interrupts, (unsigned long long)wraps,
+         (unsigned long)queueMax);
+  printf("lateness in counts:");
+  for ( i = 0; i < 8; i++ )
+  {
+    printf(" %lu%s:%.4f%%", (unsigned long)i, i == 7 ? "+" : "",
+           callbacks ? 100.0 * lateness[i] / callbacks : 0.0);
+  }
+  printf("\nmaximum lateness %lu counts\n", (unsigned long)latenessMax);
+  printf("%s\n", failed ? "FAILED" : "OK");
+
+  return failed ? 1 : 0;
+}
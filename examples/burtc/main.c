@@ -42,6 +42,7 @@
 #include "segmentlcd.h"
 #include "clock.h"
 #include "clockApp.h"
+#include "hibernate.h"
 #include "bsp_trace.h"
 
 /* Declare variables */
@@ -78,11 +79,20 @@ int main( void )
   /* Read Backup Real Time Counter value */
   burtcCountAtWakeup = BURTC_CounterGet();
 
-  /* Configure Backup Domain */
-  budSetup();
+  /* Backup domain and EM4 configuration are kept through EM4, and LFXO is
+     kept running (see budSetup()), so there is no need to wait for it */
+  if ( resetcause & RMU_RSTCAUSE_EM4WURST )
+  {
+    CMU_OscillatorEnable(cmuOsc_LFXO, true, false);
+  }
+  else
+  {
+    /* Configure Backup Domain */
+    budSetup();
 
-  /* Start LFXO and wait until it is stable */
-  CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
+    /* Start LFXO and wait until it is stable */
+    CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
+  }
 
   /* Setting up a structure to initialize the calendar
      for January 1 2012 12:00:00
@@ -104,23 +114,24 @@ int main( void )
   /* Initialize display ++ */
   clockAppInit();
 
-  /* If waking from backup mode, restore time from retention registers */
-  if ( !(resetcause & RMU_RSTCAUSE_BUBODBUVIN) && (resetcause & RMU_RSTCAUSE_BUMODERST) )
+  /* If waking from EM4 hibernation, continue with the state saved on entry.
+     BURTC configuration and LFXO calibration are kept. */
+  if ( hibernateResume( resetcause ) )
   {
-    /* Check if retention registers were being written to when backup mode was entered */
-    if ( (BURTC->STATUS & BURTC_STATUS_RAMWERR) >> _BURTC_STATUS_RAMWERR_SHIFT )
-    {
-    }
-
-    /* Check if timestamp is written */
-    if (! ((BURTC->STATUS & BURTC_STATUS_BUMODETS) >> _BURTC_STATUS_BUMODETS_SHIFT) )
-    {
-    }
-
-    /* Restore time from backup RTC + retention memory and print backup info*/
-    clockAppRestore( burtcCountAtWakeup );
+    clockAppResume();
+  }
 
-    /* Reset timestamp */
+  /* If waking from backup mode, or from EM4 without a valid snapshot,
+     restore time from retention registers.
+     A retention register write interrupted by backup mode entry
+     (BURTC_STATUS_RAMWERR) is detected by the journal checksum, and the
+     backup timestamp is not needed since every record holds the BURTC
+     counter. */
+  else if ( !(resetcause & RMU_RSTCAUSE_BUBODBUVIN)
+            && (resetcause & (RMU_RSTCAUSE_BUMODERST | RMU_RSTCAUSE_EM4WURST))
+            && clockAppRestore( burtcCountAtWakeup ) )
+  {
+    /* Reset timestamp and retention register write error */
     BURTC_StatusClear();
   }
 
@@ -130,6 +141,12 @@ int main( void )
     /* Setup BURTC */
     burtcSetup();
 
+    /* Start display update interval */
+    clockAppStart();
+
+    /* Measure LFXO frequency error, and correct the clock */
+    clockAppCalibrate();
+
     /* Backup initial calendar (also to initialize retention registers) */
     clockAppBackup();
 
@@ -150,6 +167,18 @@ int main( void )
 
     /* Update display if necessary */
     clockAppDisplay();
+
+    /* Follow LFXO drift, e.g. with temperature */
+    if ( clockAppCalibrationDue() )
+    {
+      clockAppCalibrate();
+    }
+
+    /* Enter EM4 when idle, and wake up at intervals to show the time */
+    if ( clockAppHibernateDue() )
+    {
+      clockAppHibernate();
+    }
   }
 }
 
@@ -197,6 +226,9 @@ void budSetup(void)
   /* Configure oscillators in EM4 */
   em4Init.osc = emuEM4Osc_LFXO;
 
+  /* BURTC interrupts wake up from EM4 hibernation */
+  em4Init.buRtcWakeup = true;
+
   /* Lock configuration in case of brown out */
   em4Init.lockConfig = true;
 
@@ -223,8 +255,9 @@ void burtcSetup(void)
   burtcInit.compare0Top = false;
   burtcInit.enable = true;
 
-  /* Enable interrupt on compare match */
-  BURTC_IntClear(BURTC_IEN_COMP0);
-  BURTC_IntEnable(BURTC_IEN_COMP0);
+  /* Enable interrupt on counter overflow, the compare match interrupt is
+     enabled by the alarm scheduler */
+  BURTC_IntClear(BURTC_IEN_OF);
+  BURTC_IntEnable(BURTC_IEN_OF);
   BURTC_Init(&burtcInit);
 }
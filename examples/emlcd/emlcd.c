@@ -37,9 +37,88 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "segmentlcd.h"
+#include "lcdfb.h"
 #include "lcdtest.h"
 #include "bsp_trace.h"
 
+#if defined(LCDFB_BENCHMARK)
+/** Core clock cycles of writing a string on the alphanumeric field,
+ *  averaged over the font scrolled through the field, measured at startup
+ *  for inspection with a debugger */
+typedef struct
+{
+  uint32_t segmentLcdWrite;   /**< SegmentLCD_Write() */
+  uint32_t lcdfbWrite;        /**< LCDFB_Write() */
+  uint32_t lcdfbUpdate;       /**< LCDFB_Update() after LCDFB_Write() */
+} WriteCycles_TypeDef;
+
+WriteCycles_TypeDef writeCycles;
+
+/** Strings of the benchmark */
+#define BENCHMARK_STRINGS   64
+
+/**************************************************************************//**
+ * @brief Make the string at step n of the font scrolled through the field
+ *****************************************************************************/
+static void benchmarkString(char *string, int n)
+{
+  int pos;
+
+  for (pos = 0; pos < 7; pos++)
+  {
+    string[pos] = ' ' + ((n + pos) % ('z' - ' ' + 1));
+  }
+  string[7] = '\0';
+}
+
+/**************************************************************************//**
+ * @brief Measure the cycles of SegmentLCD_Write() and of LCDFB_Write() with
+ *        LCDFB_Update() with the DWT cycle counter
+ * @note Both include the waits for the LCD register synchronization to the
+ *       low frequency clock, which the host emulator does not time.
+ *****************************************************************************/
+static void writeBenchmark(void)
+{
+  char     string[8];
+  uint32_t cycles[3] = { 0, 0, 0 };
+  uint32_t start;
+  int      i;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+  for (i = 0; i < BENCHMARK_STRINGS; i++)
+  {
+    benchmarkString(string, i);
+
+    start      = DWT->CYCCNT;
+    SegmentLCD_Write(string);
+    cycles[0] += DWT->CYCCNT - start;
+  }
+
+  /* SegmentLCD_Write() changed the segments behind the framebuffer */
+  LCDFB_Invalidate();
+  LCDFB_Update();
+
+  for (i = 0; i < BENCHMARK_STRINGS; i++)
+  {
+    benchmarkString(string, i);
+
+    start      = DWT->CYCCNT;
+    LCDFB_Write(string);
+    cycles[1] += DWT->CYCCNT - start;
+
+    start      = DWT->CYCCNT;
+    LCDFB_Update();
+    cycles[2] += DWT->CYCCNT - start;
+  }
+
+  writeCycles.segmentLcdWrite = cycles[0] / BENCHMARK_STRINGS;
+  writeCycles.lcdfbWrite      = cycles[1] / BENCHMARK_STRINGS;
+  writeCycles.lcdfbUpdate     = cycles[2] / BENCHMARK_STRINGS;
+}
+#endif
+
 /**************************************************************************//**
  * @brief  Main function
  *****************************************************************************/
@@ -53,6 +132,11 @@ int main(void)
 
   /* Enable LCD without voltage boost */
   SegmentLCD_Init(false);
+  LCDFB_Init();
+
+#if defined(LCDFB_BENCHMARK)
+  writeBenchmark();
+#endif
 
   /* Run Energy Mode with LCD demo, see lcdtest.c */
   Test();
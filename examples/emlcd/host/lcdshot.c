@@ -0,0 +1,748 @@
+/***************************************************************************//**
+ * @file
+ * @brief Display snapshots and register traffic of SegmentLCD examples
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lcdsim.h"
+#include "lcdfb.h"
+#include "lcdfont.h"
+#include "segmentlcd.h"
+
+/******************************************************************************
+ * Display updates of the examples are drawn on the emulated LCD twice: with
+ * the SegmentLCD driver, which writes the LCD on every call, and with the
+ * lcdfb.c framebuffer, which writes the LCD once per update. Both must show
+ * the same frames. For every scenario the register writes and panel frames
+ * of both are printed, and the frames can be written to a snapshot file, or
+ * compared with one.
+ *****************************************************************************/
+
+/* Drawing functions of the SegmentLCD driver or the framebuffer */
+typedef struct
+{
+  const char *name;
+  void       (*write)(const char *string);
+  void       (*number)(int value);
+  void       (*symbol)(lcdSymbol s, int on);
+  void       (*aring)(int anum, int on);
+  void       (*battery)(int batteryLevel);
+  void       (*energyMode)(int em, int on);
+  void       (*allOff)(void);
+  void       (*numberOff)(void);
+  void       (*update)(void);
+} ShotApi_TypeDef;
+
+typedef struct
+{
+  const char *name;
+  const char *description;
+  void       (*run)(const ShotApi_TypeDef *api);
+} ShotScenario_TypeDef;
+
+/* Result of drawing a scenario with one of the APIs */
+typedef struct
+{
+  uint32_t updates;
+  uint32_t writes;
+  uint32_t frames;
+  uint32_t maxWrites;
+  uint32_t maxFrames;
+  char     *text;      /* Rendered frame after every update */
+  size_t   length;
+} ShotResult_TypeDef;
+
+static ShotResult_TypeDef   *result;
+static LCDSIM_Stats_TypeDef lastStats;
+static char                 frameText[1024];
+
+
+/**************************************************************************//**
+ * @brief  End of a display update, record traffic and frame
+ *****************************************************************************/
+static void shotUpdate(const ShotApi_TypeDef *api)
+{
+  LCDSIM_Stats_TypeDef stats;
+  uint32_t             writes;
+  uint32_t             frames;
+  int                  len;
+
+  if (api->update != NULL)
+  {
+    api->update();
+  }
+
+  LCDSIM_StatsGet(&stats);
+  writes    = stats.writes - lastStats.writes;
+  frames    = stats.frames - lastStats.frames;
+  lastStats = stats;
+
+  result->updates++;
+  result->writes += writes;
+  result->frames += frames;
+  if (writes > result->maxWrites)
+  {
+    result->maxWrites = writes;
+  }
+  if (frames > result->maxFrames)
+  {
+    result->maxFrames = frames;
+  }
+
+  len = LCDSIM_Render(frameText, sizeof(frameText));
+  result->text = realloc(result->text, result->length + len + 1);
+  memcpy(result->text + result->length, frameText, len + 1);
+  result->length += len;
+}
+
+
+/******************************************************************************
+ * The drawing functions
+ *****************************************************************************/
+
+static void driverWrite(const char *string)
+{
+  char buf[8];
+
+  strncpy(buf, string, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+  SegmentLCD_Write(buf);
+}
+
+static const ShotApi_TypeDef driverApi =
+{
+  "SegmentLCD", driverWrite, SegmentLCD_Number, SegmentLCD_Symbol,
+  SegmentLCD_ARing, SegmentLCD_Battery, SegmentLCD_EnergyMode,
+  SegmentLCD_AllOff, SegmentLCD_NumberOff, NULL
+};
+
+static void fbUpdate(void)
+{
+  LCDFB_Update();
+}
+
+static const ShotApi_TypeDef fbApi =
+{
+  "LCDFB", LCDFB_Write, LCDFB_Number, LCDFB_Symbol,
+  LCDFB_ARing, LCDFB_Battery, LCDFB_EnergyMode,
+  LCDFB_AllOff, LCDFB_NumberOff, fbUpdate
+};
+
+
+/******************************************************************************
+ * Scenarios, with the drawing code of the examples
+ *
+ * The examples need their peripherals, so their drawing code is copied here,
+ * with the SegmentLCD calls replaced by the API. Every scenario names the
+ * function and the revision it was copied from. When that function changes,
+ * update the scenario and write lcdshot.snap again, see readme.txt.
+ *****************************************************************************/
+
+/* burtc/clockApp.c lcdTwoDigits(), as of revision 7fa1822 */
+static void lcdTwoDigits(char *str, int value)
+{
+  str[0] = '0' + (value / 10);
+  str[1] = '0' + (value % 10);
+}
+
+/* burtc/clockApp.c clockAppInit() and clockAppDisplay() over a change of
+   hour, as of revision 7fa1822 */
+static void scenarioClock(const ShotApi_TypeDef *api)
+{
+  char lcdString[7];
+  int  t;
+
+  api->symbol(LCD_SYMBOL_GECKO, true);
+  api->symbol(LCD_SYMBOL_COL3, true);
+  api->symbol(LCD_SYMBOL_COL5, true);
+  shotUpdate(api);
+
+  for (t = 12 * 3600 + 59 * 60 + 55; t <= 13 * 3600 + 5; t++)
+  {
+    lcdTwoDigits( &lcdString[0], t / 3600 );
+    lcdTwoDigits( &lcdString[2], (t / 60) % 60 );
+    lcdTwoDigits( &lcdString[4], t % 60 );
+    lcdString[6] = '\0';
+
+    api->write(lcdString);
+    shotUpdate(api);
+  }
+}
+
+/* touch/touchdemo.c capSenseScrollText() over the slider positions, as of
+   revision 6510635 */
+static void scenarioTouch(const ShotApi_TypeDef *api)
+{
+  const char *message = "CAPSENSE TOUCH DEMO  ";
+  char       msg[10];
+  int        sliderPos;
+  int        offset;
+  int        pos;
+
+  for (pos = -1; pos <= 48; pos += (pos < 0) ? 1 : 4)
+  {
+    sliderPos = pos;
+    api->number(sliderPos);
+
+    if (sliderPos == -1)
+      sliderPos = 0;
+
+    offset = ((strlen(message) - 7) * sliderPos) / 48;
+
+    snprintf(msg, 8, "%s", message + offset);
+    api->write(msg);
+    shotUpdate(api);
+  }
+}
+
+/* inttemp/inttemp.c main() display update in Celsius and in Fahrenheit, as
+   of revision fd36e8a. The temperatures are given in tenths of degrees. */
+static void scenarioInttemp(const ShotApi_TypeDef *api)
+{
+  static const int celsius10[] = { 235, 236, 236, 241, -52 };
+  char             string[8];
+  int              n;
+  int              i;
+  int              showFahrenheit;
+
+  for (showFahrenheit = 0; showFahrenheit < 2; showFahrenheit++)
+  {
+    for (n = 0; n < (int)(sizeof(celsius10) / sizeof(celsius10[0])); n++)
+    {
+      int fahrenheit10 = celsius10[n] * 9 / 5 + 320;
+
+      if (showFahrenheit)
+      {
+        i = fahrenheit10;
+        snprintf(string, 8, "%2d,%1d%%F", (int)(i/10), (int)abs(i%10));
+        i = celsius10[n];
+        api->number(i*10);
+        api->symbol(LCD_SYMBOL_DP10, 1);
+        api->symbol(LCD_SYMBOL_DEGC, 1);
+        api->symbol(LCD_SYMBOL_DEGF, 0);
+      }
+      else
+      {
+        i = celsius10[n];
+        snprintf(string, 8, "%2d,%1d%%C", (int)(i/10), (int)abs(i%10));
+        i = fahrenheit10;
+        api->number(i*10);
+        api->symbol(LCD_SYMBOL_DP10, 1);
+        api->symbol(LCD_SYMBOL_DEGC, 0);
+        api->symbol(LCD_SYMBOL_DEGF, 1);
+      }
+      api->write(string);
+      shotUpdate(api);
+    }
+  }
+}
+
+/* emlcd/lcdtest.c Test() and BlinkTest(), shortened to some of the count
+   down, ring, battery and blink screens, as of revision a9b5a8d */
+static void scenarioLcdtest(const ShotApi_TypeDef *api)
+{
+  int i;
+
+  api->allOff();
+  for (i = 100; i > 90; i--)
+  {
+    api->number(i);
+    shotUpdate(api);
+  }
+  api->numberOff();
+  api->symbol(LCD_SYMBOL_GECKO, 1);
+  api->symbol(LCD_SYMBOL_EFM32, 1);
+  api->write(" Giant ");
+  shotUpdate(api);
+  api->write(" Gecko ");
+  shotUpdate(api);
+
+  api->allOff();
+  for (i = 0; i < 8; i++)
+  {
+    api->number(i);
+    api->aring(i, 1);
+    shotUpdate(api);
+  }
+  for (i = 0; i < 5; i++)
+  {
+    api->number(i);
+    api->battery(i);
+    api->energyMode(i, 1);
+    shotUpdate(api);
+  }
+
+  api->energyMode(0, 1);
+  api->energyMode(1, 1);
+  api->energyMode(2, 1);
+  api->energyMode(3, 1);
+  api->energyMode(4, 1);
+  api->number(2358);
+  api->symbol(LCD_SYMBOL_COL10, 1);
+  api->symbol(LCD_SYMBOL_GECKO, 1);
+  api->symbol(LCD_SYMBOL_EFM32, 1);
+  api->write(" EFM32 ");
+  shotUpdate(api);
+}
+
+static const ShotScenario_TypeDef scenarios[] =
+{
+  { "clock",   "burtc clockAppDisplay()",         scenarioClock   },
+  { "touch",   "touch capSenseScrollText()",      scenarioTouch   },
+  { "inttemp", "inttemp temperature display",     scenarioInttemp },
+  { "lcdtest", "emlcd lcdtest.c screens",         scenarioLcdtest },
+};
+
+
+/**************************************************************************//**
+ * @brief  Draw a scenario with one of the APIs on a cleared LCD
+ *****************************************************************************/
+static void shotRun(const ShotScenario_TypeDef *scenario,
+                    const ShotApi_TypeDef *api, ShotResult_TypeDef *res)
+{
+  memset(res, 0, sizeof(*res));
+  result = res;
+
+  LCDSIM_Reset();
+  SegmentLCD_Init(false);
+  LCDFB_Init();
+  LCDFB_Update();
+  LCDSIM_StatsGet(&lastStats);
+
+  scenario->run(api);
+}
+
+
+/**************************************************************************//**
+ * @brief  Read a whole file
+ *****************************************************************************/
+static char *shotFileRead(const char *name)
+{
+  FILE   *f = fopen(name, "r");
+  char   *text;
+  long   size;
+
+  if (f == NULL)
+  {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  text = malloc(size + 1);
+  size = fread(text, 1, size, f);
+  text[size] = '\0';
+  fclose(f);
+  return text;
+}
+
+
+/**************************************************************************//**
+ * @brief  Print the frames which differ from the snapshot
+ *****************************************************************************/
+static int shotCompare(const char *snapshot, const char *frames)
+{
+  size_t i = 0;
+  int    line = 1;
+
+  while ((snapshot[i] != '\0') && (snapshot[i] == frames[i]))
+  {
+    if (snapshot[i++] == '\n')
+    {
+      line++;
+    }
+  }
+  if ((snapshot[i] == '\0') && (frames[i] == '\0'))
+  {
+    return 0;
+  }
+  printf("snapshot differs from line %d\n", line);
+  return 1;
+}
+
+
+/* Font of segmentlcd.c, for the per segment drawing */
+#define BENCH_FONT(c, pattern)    pattern,
+
+static const uint16_t              benchFont[] = { LCDFONT_TEXT(BENCH_FONT) };
+static const LCDFB_Display_TypeDef benchDisplay = EFM_DISPLAY_DEF;
+
+/* Text of the benchmark, the font scrolled through the alphanumeric field */
+#define BENCH_STRINGS  LCDFONT_TEXT_SIZE
+
+static char benchText[BENCH_STRINGS][8];
+
+/* Repetitions of the timed loops, the fastest of BENCH_RUNS is taken */
+#define BENCH_LOOPS    10000
+#define BENCH_RUNS     10
+
+
+/**************************************************************************//**
+ * @brief  Draw text the way SegmentLCD_Write() of segmentlcd.c does
+ *
+ * @details
+ *   Every segment of every character is looked up in the display layout
+ *   and set with a read-modify-write of its register. The registers are a
+ *   RAM frame here, so only the work of the core is measured, not the
+ *   waits for the LCD register synchronization of LCD_SegmentSet().
+ *****************************************************************************/
+static void benchTextDriver(const char *string, LCDFB_Frame_TypeDef *text)
+{
+  uint16_t pattern;
+  int      com;
+  int      bit;
+  int      pos;
+  int      i;
+  char     c;
+
+  memset(text, 0, sizeof(*text));
+
+  for (pos = 0; pos < 7; pos++)
+  {
+    c = *string;
+    if (c != '\0')
+    {
+      string++;
+    }
+    if ((c < ' ') || (c > 'z'))
+    {
+      c = ' ';
+    }
+    pattern = benchFont[c - ' '];
+
+    for (i = 0; i < 14; i++)
+    {
+      if (pattern & (1 << i))
+      {
+        com = benchDisplay.Text[pos].com[i];
+        bit = benchDisplay.Text[pos].bit[i];
+        if (bit < 32)
+        {
+          text->low[com] |= 1UL << bit;
+        }
+        else
+        {
+          text->high[com] |= 1UL << (bit - 32);
+        }
+      }
+    }
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Nanoseconds of the monotonic clock
+ *****************************************************************************/
+static double benchNow(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/**************************************************************************//**
+ * @brief  Time drawing benchText with one of the text functions
+ *****************************************************************************/
+static double benchTime(void (*draw)(const char *string,
+                                     LCDFB_Frame_TypeDef *text))
+{
+  static volatile uint32_t sink;
+  LCDFB_Frame_TypeDef      text;
+  unsigned                 run;
+  unsigned                 loop;
+  unsigned                 n;
+  double                   start;
+  double                   ns;
+  double                   best = 0;
+
+  for (run = 0; run < BENCH_RUNS; run++)
+  {
+    start = benchNow();
+    for (loop = 0; loop < BENCH_LOOPS; loop++)
+    {
+      for (n = 0; n < BENCH_STRINGS; n++)
+      {
+        draw(benchText[n], &text);
+        sink += text.low[loop & 7] ^ text.high[n & 7];
+      }
+    }
+    ns = (benchNow() - start) / ((double)BENCH_LOOPS * BENCH_STRINGS);
+    if ((run == 0) || (ns < best))
+    {
+      best = ns;
+    }
+  }
+  return best;
+}
+
+
+/**************************************************************************//**
+ * @brief  Compare the LCDFB font tables with per segment drawing
+ *
+ * @details
+ *   Every character of the font is drawn at every position with both, then
+ *   both are timed drawing the text of benchText.
+ *****************************************************************************/
+static int benchRun(void)
+{
+  LCDFB_Frame_TypeDef  driver;
+  LCDFB_Frame_TypeDef  fb;
+  LCDSIM_Stats_TypeDef start;
+  LCDSIM_Stats_TypeDef driverStats;
+  LCDSIM_Stats_TypeDef fbStart;
+  LCDSIM_Stats_TypeDef fbStats;
+  char                 string[8];
+  double               driverNs;
+  double               fbNs;
+  int                  failures = 0;
+  int                  pos;
+  int                  c;
+
+  for (c = 0; c < BENCH_STRINGS; c++)
+  {
+    for (pos = 0; pos < 7; pos++)
+    {
+      benchText[c][pos] = (char)(' ' + ((c + pos) % LCDFONT_TEXT_SIZE));
+    }
+    benchText[c][7] = '\0';
+  }
+
+  for (pos = 0; pos < 7; pos++)
+  {
+    for (c = ' '; c <= 'z'; c++)
+    {
+      memset(string, ' ', 7);
+      string[pos] = (char)c;
+      string[7]   = '\0';
+      benchTextDriver(string, &driver);
+      LCDFB_TextRender(string, &fb);
+      if (memcmp(&driver, &fb, sizeof(fb)) != 0)
+      {
+        printf("'%c' at %d: font tables differ\n", c, pos + 1);
+        failures++;
+      }
+    }
+  }
+
+  driverNs = benchTime(benchTextDriver);
+  fbNs     = benchTime(LCDFB_TextRender);
+
+  /* Segment register writes of every string on the emulated LCD */
+  LCDSIM_Reset();
+  SegmentLCD_Init(false);
+  LCDSIM_StatsGet(&start);
+  for (c = 0; c < BENCH_STRINGS; c++)
+  {
+    SegmentLCD_Write(benchText[c]);
+  }
+  LCDSIM_StatsGet(&driverStats);
+
+  LCDSIM_Reset();
+  SegmentLCD_Init(false);
+  LCDFB_Init();
+  LCDFB_Update();
+  LCDSIM_StatsGet(&fbStart);
+  for (c = 0; c < BENCH_STRINGS; c++)
+  {
+    LCDFB_Write(benchText[c]);
+    LCDFB_Update();
+  }
+  LCDSIM_StatsGet(&fbStats);
+
+  printf("\ntext drawing, per string:\n");
+  printf("%-18s %9s %9s %7s\n", "", "segment", "LCDFB", "ratio");
+  printf("%-18s %9.1f %9.1f %6.1fx\n", "host ns", driverNs, fbNs,
+         driverNs / fbNs);
+  printf("%-18s %9.1f %9.1f %6.1fx\n", "register writes",
+         (double)(driverStats.writes - start.writes) / BENCH_STRINGS,
+         (double)(fbStats.writes - fbStart.writes) / BENCH_STRINGS,
+         (double)(driverStats.writes - start.writes) /
+         (fbStats.writes - fbStart.writes));
+
+  return failures;
+}
+
+
+static void usage(const char *name)
+{
+  printf("Usage: %s [-s scenario] [-o snapshot] [-c snapshot] [-v] [-b]\n",
+         name);
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char         *only     = NULL;
+  const char         *outName  = NULL;
+  const char         *checkName = NULL;
+  bool               verbose   = false;
+  bool               bench     = false;
+  ShotResult_TypeDef driver;
+  ShotResult_TypeDef fb;
+  char               *frames   = NULL;
+  size_t             length    = 0;
+  int                failures  = 0;
+  int                opt;
+  unsigned           n;
+
+  while ((opt = getopt(argc, argv, "s:o:c:vb")) != -1)
+  {
+    switch (opt)
+    {
+    case 's':
+      only = optarg;
+      break;
+    case 'o':
+      outName = optarg;
+      break;
+    case 'c':
+      checkName = optarg;
+      break;
+    case 'v':
+      verbose = true;
+      break;
+    case 'b':
+      bench = true;
+      break;
+    default:
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  printf("%-8s %7s   %-23s   %-23s\n", "", "", "SegmentLCD", "LCDFB");
+  printf("%-8s %7s   %7s %7s %7s   %7s %7s %7s\n", "scenario", "updates",
+         "writes", "max", "frames", "writes", "max", "frames");
+
+  for (n = 0; n < sizeof(scenarios) / sizeof(scenarios[0]); n++)
+  {
+    const ShotScenario_TypeDef *scenario = &scenarios[n];
+    int                        header;
+
+    if ((only != NULL) && (strcmp(only, scenario->name) != 0))
+    {
+      continue;
+    }
+
+    shotRun(scenario, &driverApi, &driver);
+    shotRun(scenario, &fbApi, &fb);
+
+    printf("%-8s %7u   %7u %7u %7u   %7u %7u %7u\n", scenario->name,
+           (unsigned)fb.updates, (unsigned)driver.writes,
+           (unsigned)driver.maxWrites, (unsigned)driver.frames,
+           (unsigned)fb.writes, (unsigned)fb.maxWrites, (unsigned)fb.frames);
+
+    if ((driver.text == NULL) || (fb.text == NULL) ||
+        (strcmp(driver.text, fb.text) != 0))
+    {
+      printf("%s: SegmentLCD and LCDFB frames differ\n", scenario->name);
+      failures++;
+    }
+
+    /* Snapshot of every frame */
+    header = snprintf(frameText, sizeof(frameText), "== %s, %s\n",
+                      scenario->name, scenario->description);
+    frames = realloc(frames, length + header + fb.length + 1);
+    memcpy(frames + length, frameText, header);
+    memcpy(frames + length + header, fb.text, fb.length + 1);
+    length += header + fb.length;
+
+    if (verbose)
+    {
+      printf("%s%s", frameText, fb.text);
+    }
+
+    free(driver.text);
+    free(fb.text);
+  }
+
+  if (frames == NULL)
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  if (!verbose)
+  {
+    /* Last frame of the last scenario */
+    LCDSIM_Render(frameText, sizeof(frameText));
+    printf("\n%s", frameText);
+  }
+
+  if (outName != NULL)
+  {
+    FILE *f = fopen(outName, "w");
+
+    if ((f == NULL) || (fwrite(frames, 1, length, f) != length))
+    {
+      printf("%s: write failed\n", outName);
+      failures++;
+    }
+    if (f != NULL)
+    {
+      fclose(f);
+    }
+  }
+
+  if (checkName != NULL)
+  {
+    char *snapshot = shotFileRead(checkName);
+
+    if (snapshot == NULL)
+    {
+      printf("%s: read failed\n", checkName);
+      failures++;
+    }
+    else
+    {
+      failures += shotCompare(snapshot, frames);
+      free(snapshot);
+    }
+  }
+
+  free(frames);
+
+  if (bench)
+  {
+    failures += benchRun();
+  }
+
+  printf("%s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
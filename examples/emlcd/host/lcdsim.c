@@ -0,0 +1,342 @@
+/***************************************************************************//**
+ * @file
+ * @brief Emulated segment LCD of the STK3700
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "lcdsim.h"
+#include "lcdfb.h"
+
+/******************************************************************************
+ * The segment registers SEGD0L-SEGD7L and SEGD0H-SEGD7H are kept in RAM, and
+ * copied to the panel when they are written with the LCD not frozen, or when
+ * the LCD is unfrozen. Every change of the panel counts as a frame, as the
+ * LCD may show it. Several frames for one display update are seen as
+ * flicker or tearing.
+ *****************************************************************************/
+
+/* Cells of the ASCII art without a segment, and between the two middle
+   segments of a character */
+#define SIM_NONE      (-1)
+#define SIM_MIDDLE    (-2)
+
+/* Segment registers */
+static LCDFB_Frame_TypeDef regs;
+
+/* Segments shown on the panel */
+static LCDFB_Frame_TypeDef panel;
+
+static bool                 frozen;
+static uint32_t             primaskState;
+static LCDSIM_Stats_TypeDef stats;
+
+static const LCDFB_Display_TypeDef display = EFM_DISPLAY_DEF;
+
+/* Symbols in lcdSymbol order */
+static const struct
+{
+  const char *name;
+  int        com;
+  int        seg;
+} symbols[] =
+{
+  { "GECKO", LCD_SYMBOL_GECKO_COM, LCD_SYMBOL_GECKO_SEG },
+  { "ANT",   LCD_SYMBOL_ANT_COM,   LCD_SYMBOL_ANT_SEG   },
+  { "PAD0",  LCD_SYMBOL_PAD0_COM,  LCD_SYMBOL_PAD0_SEG  },
+  { "PAD1",  LCD_SYMBOL_PAD1_COM,  LCD_SYMBOL_PAD1_SEG  },
+  { "EFM32", LCD_SYMBOL_EFM32_COM, LCD_SYMBOL_EFM32_SEG },
+  { "MINUS", LCD_SYMBOL_MINUS_COM, LCD_SYMBOL_MINUS_SEG },
+  { "COL3",  LCD_SYMBOL_COL3_COM,  LCD_SYMBOL_COL3_SEG  },
+  { "COL5",  LCD_SYMBOL_COL5_COM,  LCD_SYMBOL_COL5_SEG  },
+  { "COL10", LCD_SYMBOL_COL10_COM, LCD_SYMBOL_COL10_SEG },
+  { "DEGC",  LCD_SYMBOL_DEGC_COM,  LCD_SYMBOL_DEGC_SEG  },
+  { "DEGF",  LCD_SYMBOL_DEGF_COM,  LCD_SYMBOL_DEGF_SEG  },
+  { "DP2",   LCD_SYMBOL_DP2_COM,   LCD_SYMBOL_DP2_SEG   },
+  { "DP3",   LCD_SYMBOL_DP3_COM,   LCD_SYMBOL_DP3_SEG   },
+  { "DP4",   LCD_SYMBOL_DP4_COM,   LCD_SYMBOL_DP4_SEG   },
+  { "DP5",   LCD_SYMBOL_DP5_COM,   LCD_SYMBOL_DP5_SEG   },
+  { "DP6",   LCD_SYMBOL_DP6_COM,   LCD_SYMBOL_DP6_SEG   },
+  { "DP10",  LCD_SYMBOL_DP10_COM,  LCD_SYMBOL_DP10_SEG  },
+};
+
+
+/**************************************************************************//**
+ * @brief  Interrupts are not emulated, the mask is only kept
+ *****************************************************************************/
+uint32_t __get_PRIMASK(void)
+{
+  return primaskState;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+  primaskState = primask;
+}
+
+void __disable_irq(void)
+{
+  primaskState = 1;
+}
+
+
+/**************************************************************************//**
+ * @brief  Copy the registers to the panel, count a frame if it changes
+ *****************************************************************************/
+static void simShow(void)
+{
+  if (memcmp(&panel, &regs, sizeof(panel)) != 0)
+  {
+    panel = regs;
+    stats.frames++;
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Write a segment register
+ *****************************************************************************/
+static void simWrite(uint32_t *reg, uint32_t mask, uint32_t bits)
+{
+  *reg = (*reg & ~mask) | (bits & mask);
+  stats.writes++;
+
+  if (!frozen)
+  {
+    simShow();
+  }
+}
+
+
+void LCD_FreezeEnable(bool enable)
+{
+  frozen = enable;
+
+  if (!frozen)
+  {
+    simShow();
+  }
+}
+
+void LCD_SegmentSet(int com, int bit, bool enable)
+{
+  assert((com >= 0) && (com < LCDFB_COMS) && (bit >= 0) && (bit < 40));
+
+  if (bit < 32)
+  {
+    simWrite(&regs.low[com], 1UL << bit, enable ? ~0UL : 0);
+  }
+  else
+  {
+    simWrite(&regs.high[com], 1UL << (bit - 32), enable ? ~0UL : 0);
+  }
+}
+
+void LCD_SegmentSetLow(int com, uint32_t mask, uint32_t bits)
+{
+  assert((com >= 0) && (com < LCDFB_COMS));
+  simWrite(&regs.low[com], mask, bits);
+}
+
+void LCD_SegmentSetHigh(int com, uint32_t mask, uint32_t bits)
+{
+  assert((com >= 0) && (com < LCDFB_COMS));
+  simWrite(&regs.high[com], mask, bits);
+}
+
+
+/**************************************************************************//**
+ * @brief  Clear the registers, the panel and the statistics
+ *****************************************************************************/
+void LCDSIM_Reset(void)
+{
+  memset(&regs, 0, sizeof(regs));
+  memset(&panel, 0, sizeof(panel));
+  memset(&stats, 0, sizeof(stats));
+  frozen = false;
+}
+
+
+/**************************************************************************//**
+ * @brief  Get the register traffic since LCDSIM_Reset()
+ *****************************************************************************/
+void LCDSIM_StatsGet(LCDSIM_Stats_TypeDef *copy)
+{
+  *copy = stats;
+}
+
+
+/**************************************************************************//**
+ * @brief  Check a segment of the panel
+ *****************************************************************************/
+static bool simOn(int com, int bit)
+{
+  if (bit < 32)
+  {
+    return (panel.low[com] >> bit) & 1;
+  }
+  return (panel.high[com] >> (bit - 32)) & 1;
+}
+
+
+/**************************************************************************//**
+ * @brief
+ *   Draw the panel as ASCII art.
+ *
+ * @details
+ *   Five lines show the 14 segment characters and the 7 segment digits, and
+ *   three lines list the symbols, the ring, the battery and the energy mode
+ *   indicators which are on.
+ *
+ * @return
+ *   Length of the text in buf, terminated by a newline.
+ *****************************************************************************/
+int LCDSIM_Render(char *buf, int size)
+{
+  /* Font bit shown in every cell of a 5x5 character, bits a-f = 0-5,
+     g/m = 6/10, h/j/k = 7/8/9 and n/p/q = 11/12/13 */
+  static const int8_t charMap[5][5] =
+  {
+    { SIM_NONE, 0, 0, 0, SIM_NONE },
+    { 5, 7, 8, 9, 1 },
+    { SIM_NONE, 6, SIM_MIDDLE, 10, SIM_NONE },
+    { 4, 13, 12, 11, 2 },
+    { SIM_NONE, 3, 3, 3, SIM_NONE }
+  };
+  static const char charGlyph[5][6] =
+  {
+    " --- ", "|\\|/|", " --- ", "|/|\\|", " --- "
+  };
+  /* The same for a 3x5 digit, bits a-g = 0-6 */
+  static const int8_t digitMap[5][3] =
+  {
+    { SIM_NONE, 0, SIM_NONE },
+    { 5, SIM_NONE, 1 },
+    { SIM_NONE, 6, SIM_NONE },
+    { 4, SIM_NONE, 2 },
+    { SIM_NONE, 3, SIM_NONE }
+  };
+  static const char digitGlyph[5][4] =
+  {
+    " - ", "| |", " - ", "| |", " - "
+  };
+  const LCDFB_Char_TypeDef  *ch;
+  const LCDFB_Digit_TypeDef *digit;
+  int                       len = 0;
+  int                       row;
+  int                       pos;
+  int                       col;
+  int                       i;
+  char                      c;
+
+#define RENDER(...) \
+  len += snprintf(buf + len, (len < size) ? size - len : 0, __VA_ARGS__)
+
+  for (row = 0; row < 5; row++)
+  {
+    for (pos = 0; pos < 7; pos++)
+    {
+      ch = &display.Text[pos];
+      for (col = 0; col < 5; col++)
+      {
+        i = charMap[row][col];
+        if (i == SIM_MIDDLE)
+        {
+          /* Joins the two middle segments */
+          c = (simOn(ch->com[6], ch->bit[6]) && simOn(ch->com[10], ch->bit[10])) ? '-' : ' ';
+        }
+        else if (i == SIM_NONE)
+        {
+          c = ' ';
+        }
+        else
+        {
+          c = simOn(ch->com[i], ch->bit[i]) ? charGlyph[row][col] : ' ';
+        }
+        RENDER("%c", c);
+      }
+      RENDER(" ");
+    }
+
+    /* Numeric field, most significant digit first */
+    RENDER("  ");
+    for (pos = 3; pos >= 0; pos--)
+    {
+      digit = &display.Number[pos];
+      for (col = 0; col < 3; col++)
+      {
+        i = digitMap[row][col];
+        if (i == SIM_NONE)
+        {
+          c = ' ';
+        }
+        else
+        {
+          c = simOn(digit->com[i], digit->bit[i]) ? digitGlyph[row][col] : ' ';
+        }
+        RENDER("%c", c);
+      }
+      RENDER(" ");
+    }
+    RENDER("\n");
+  }
+
+  RENDER("symbols:");
+  for (i = 0; i < (int)(sizeof(symbols) / sizeof(symbols[0])); i++)
+  {
+    if (simOn(symbols[i].com, symbols[i].seg))
+    {
+      RENDER(" %s", symbols[i].name);
+    }
+  }
+  RENDER("\nring: ");
+  for (i = 0; i < 8; i++)
+  {
+    RENDER("%c", simOn(display.ARing.com[i], display.ARing.bit[i]) ? '0' + i : '.');
+  }
+  RENDER("  battery: ");
+  for (i = 0; i < 4; i++)
+  {
+    RENDER("%c", simOn(display.Battery.com[i], display.Battery.bit[i]) ? '#' : '.');
+  }
+  RENDER("  em: ");
+  for (i = 0; i < 5; i++)
+  {
+    RENDER("%c", simOn(display.EMode.com[i], display.EMode.bit[i]) ? '0' + i : '.');
+  }
+  RENDER("\n");
+
+#undef RENDER
+
+  return len;
+}
@@ -0,0 +1,75 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host build support for the segment LCD emulator
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __LCDSIM_H
+#define __LCDSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Replaces em_assert.h */
+#define EFM_ASSERT(expr)    assert(expr)
+
+/* Interrupt mask of the emulated core, replaces the CMSIS functions */
+uint32_t __get_PRIMASK(void);
+void     __set_PRIMASK(uint32_t primask);
+void     __disable_irq(void);
+
+/* Segment functions of em_lcd.h, on the emulated LCD */
+void LCD_FreezeEnable(bool enable);
+void LCD_SegmentSet(int com, int bit, bool enable);
+void LCD_SegmentSetLow(int com, uint32_t mask, uint32_t bits);
+void LCD_SegmentSetHigh(int com, uint32_t mask, uint32_t bits);
+
+/* Register traffic since LCDSIM_Reset() */
+typedef struct
+{
+  uint32_t writes;     /* Segment register writes */
+  uint32_t frames;     /* Changes of the segments shown on the panel */
+} LCDSIM_Stats_TypeDef;
+
+void LCDSIM_Reset(void);
+void LCDSIM_StatsGet(LCDSIM_Stats_TypeDef *stats);
+int  LCDSIM_Render(char *buf, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
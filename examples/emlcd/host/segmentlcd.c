@@ -0,0 +1,233 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host build of the SegmentLCD driver on the emulated LCD
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <string.h>
+
+#include "lcdsim.h"
+#include "lcdfb.h"
+#include "segmentlcd.h"
+
+/******************************************************************************
+ * The display content is kept with the lcdfb.c drawing functions, and the
+ * segment registers of the emulated LCD are written the way segmentlcd.c of
+ * the kit drivers writes them: a field is cleared with the macros of
+ * segmentlcdconfig.h, and every segment which is on is then set with
+ * LCD_SegmentSet(), with the LCD frozen during text and number updates.
+ * Symbols, ring, battery and energy mode segments are written one by one.
+ * The register traffic of the emulated LCD is that of the driver.
+ *
+ * The framebuffer must not be used by the application at the same time.
+ *****************************************************************************/
+
+static const LCDFB_Display_TypeDef display = EFM_DISPLAY_DEF;
+
+/* Segments of the alphanumeric and numeric fields */
+static LCDFB_Frame_TypeDef alphaField;
+static LCDFB_Frame_TypeDef numberField;
+
+
+/**************************************************************************//**
+ * @brief  Set the segments of the field which are on in the framebuffer
+ *****************************************************************************/
+static void driverFieldSet(const LCDFB_Frame_TypeDef *field)
+{
+  LCDFB_Frame_TypeDef frame;
+  int                 com;
+  int                 bit;
+
+  LCDFB_FrameGet(&frame);
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    for (bit = 0; bit < 32; bit++)
+    {
+      if ((frame.low[com] & field->low[com]) & (1UL << bit))
+      {
+        LCD_SegmentSet(com, bit, true);
+      }
+    }
+    for (bit = 0; bit < 8; bit++)
+    {
+      if ((frame.high[com] & field->high[com]) & (1UL << bit))
+      {
+        LCD_SegmentSet(com, bit + 32, true);
+      }
+    }
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Write one segment from the framebuffer
+ *****************************************************************************/
+static void driverSegmentSet(int com, int bit)
+{
+  LCDFB_Frame_TypeDef frame;
+
+  LCDFB_FrameGet(&frame);
+  if (bit < 32)
+  {
+    LCD_SegmentSet(com, bit, (frame.low[com] >> bit) & 1);
+  }
+  else
+  {
+    LCD_SegmentSet(com, bit, (frame.high[com] >> (bit - 32)) & 1);
+  }
+}
+
+
+void SegmentLCD_Init(bool useBoost)
+{
+  LCDFB_Frame_TypeDef all;
+  int                 com;
+
+  (void)useBoost;
+
+  /* The fields are the segments cleared by the Off functions */
+  LCDFB_AllOn();
+  LCDFB_FrameGet(&all);
+  LCDFB_AlphaNumberOff();
+  LCDFB_FrameGet(&alphaField);
+  LCDFB_AllOn();
+  LCDFB_NumberOff();
+  LCDFB_FrameGet(&numberField);
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    alphaField.low[com]   = all.low[com] & ~alphaField.low[com];
+    alphaField.high[com]  = all.high[com] & ~alphaField.high[com];
+    numberField.low[com]  = all.low[com] & ~numberField.low[com];
+    numberField.high[com] = all.high[com] & ~numberField.high[com];
+  }
+
+  LCDFB_Init();
+  LCD_ALL_SEGMENTS_OFF();
+}
+
+void SegmentLCD_Disable(void)
+{
+}
+
+void SegmentLCD_AllOff(void)
+{
+  LCDFB_AllOff();
+  LCD_ALL_SEGMENTS_OFF();
+}
+
+void SegmentLCD_AllOn(void)
+{
+  LCDFB_AllOn();
+  LCD_ALL_SEGMENTS_ON();
+}
+
+void SegmentLCD_AlphaNumberOff(void)
+{
+  LCDFB_AlphaNumberOff();
+  LCD_ALPHA_NUMBER_OFF();
+}
+
+void SegmentLCD_NumberOff(void)
+{
+  LCDFB_NumberOff();
+  LCD_NUMBER_OFF();
+  driverSegmentSet(LCD_SYMBOL_MINUS_COM, LCD_SYMBOL_MINUS_SEG);
+}
+
+void SegmentLCD_Write(char *string)
+{
+  LCDFB_Write(string);
+
+  LCD_FreezeEnable(true);
+  LCD_ALPHA_NUMBER_OFF();
+  driverFieldSet(&alphaField);
+  LCD_FreezeEnable(false);
+}
+
+void SegmentLCD_Number(int value)
+{
+  LCDFB_Number(value);
+
+  LCD_FreezeEnable(true);
+  LCD_NUMBER_OFF();
+  driverFieldSet(&numberField);
+  LCD_FreezeEnable(false);
+}
+
+void SegmentLCD_Symbol(lcdSymbol s, int on)
+{
+  /* Same order as lcdSymbol */
+  static const uint8_t com[] =
+  {
+    LCD_SYMBOL_GECKO_COM, LCD_SYMBOL_ANT_COM,   LCD_SYMBOL_PAD0_COM,
+    LCD_SYMBOL_PAD1_COM,  LCD_SYMBOL_EFM32_COM, LCD_SYMBOL_MINUS_COM,
+    LCD_SYMBOL_COL3_COM,  LCD_SYMBOL_COL5_COM,  LCD_SYMBOL_COL10_COM,
+    LCD_SYMBOL_DEGC_COM,  LCD_SYMBOL_DEGF_COM,  LCD_SYMBOL_DP2_COM,
+    LCD_SYMBOL_DP3_COM,   LCD_SYMBOL_DP4_COM,   LCD_SYMBOL_DP5_COM,
+    LCD_SYMBOL_DP6_COM,   LCD_SYMBOL_DP10_COM
+  };
+  static const uint8_t seg[] =
+  {
+    LCD_SYMBOL_GECKO_SEG, LCD_SYMBOL_ANT_SEG,   LCD_SYMBOL_PAD0_SEG,
+    LCD_SYMBOL_PAD1_SEG,  LCD_SYMBOL_EFM32_SEG, LCD_SYMBOL_MINUS_SEG,
+    LCD_SYMBOL_COL3_SEG,  LCD_SYMBOL_COL5_SEG,  LCD_SYMBOL_COL10_SEG,
+    LCD_SYMBOL_DEGC_SEG,  LCD_SYMBOL_DEGF_SEG,  LCD_SYMBOL_DP2_SEG,
+    LCD_SYMBOL_DP3_SEG,   LCD_SYMBOL_DP4_SEG,   LCD_SYMBOL_DP5_SEG,
+    LCD_SYMBOL_DP6_SEG,   LCD_SYMBOL_DP10_SEG
+  };
+
+  LCDFB_Symbol(s, on);
+  driverSegmentSet(com[s], seg[s]);
+}
+
+void SegmentLCD_ARing(int anum, int on)
+{
+  LCDFB_ARing(anum, on);
+  driverSegmentSet(display.ARing.com[anum], display.ARing.bit[anum]);
+}
+
+void SegmentLCD_Battery(int batteryLevel)
+{
+  int i;
+
+  LCDFB_Battery(batteryLevel);
+  for (i = 0; i < 4; i++)
+  {
+    driverSegmentSet(display.Battery.com[i], display.Battery.bit[i]);
+  }
+}
+
+void SegmentLCD_EnergyMode(int em, int on)
+{
+  LCDFB_EnergyMode(em, on);
+  driverSegmentSet(display.EMode.com[em], display.EMode.bit[em]);
+}
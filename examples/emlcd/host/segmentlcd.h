@@ -0,0 +1,64 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host build of the SegmentLCD driver interface
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __SEGMENTLCD_H
+#define __SEGMENTLCD_H
+
+#include <stdbool.h>
+
+#include "segmentlcdconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Same functions as segmentlcd.h of the kit drivers */
+void SegmentLCD_AllOff(void);
+void SegmentLCD_AllOn(void);
+void SegmentLCD_AlphaNumberOff(void);
+void SegmentLCD_ARing(int anum, int on);
+void SegmentLCD_Battery(int batteryLevel);
+void SegmentLCD_Disable(void);
+void SegmentLCD_EnergyMode(int em, int on);
+void SegmentLCD_Init(bool useBoost);
+void SegmentLCD_Number(int value);
+void SegmentLCD_NumberOff(void);
+void SegmentLCD_Symbol(lcdSymbol s, int on);
+void SegmentLCD_Write(char *string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,712 @@
+/***************************************************************************//**
+ * @file
+ * @brief Segment LCD framebuffer with synchronized updates.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stddef.h>
+
+#if defined(LCDFB_HOST)
+#include "lcdsim.h"       /* Host build, see host/readme.txt */
+#else
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_lcd.h"
+#endif
+
+#include "lcdfb.h"
+#include "lcdfont.h"
+
+/***************************************************************************//**
+ * @addtogroup LCDFB
+ * @{
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/* Compile time check of the font tables */
+#define LCDFB_ASSERT(cond, name)  typedef char name[(cond) ? 1 : -1]
+
+/* Bit 0 of v in segment line seg of SEGDnL or SEGDnH, the segment lines are
+ * constants so this is a shift by a constant or 0 */
+#define LCDFB_BIT_LOW(seg, v)   (((seg) < 32) ? (((v) & 1UL) << ((seg) & 31)) : 0UL)
+#define LCDFB_BIT_HIGH(seg, v)  (((seg) < 32) ? 0UL : (((v) & 1UL) << ((seg) & 31)))
+
+/* Bit 0 and 1 of v in the two segment lines a and b of a character */
+#define LCDFB_TEXT_BITS(reg, a, b, v) \
+  (LCDFB_BIT_##reg(a, (v)) | LCDFB_BIT_##reg(b, (v) >> 1))
+
+#define LCDFB_COM_LIST(X) \
+  X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7)
+
+/* Draw the next character or digit of planes in the COM line of low and
+ * high, expanded for every position of the field */
+#define LCDFB_TEXT_COM(unused, layout, a, b) \
+  bits  = *plane++ >> shift; \
+  low  |= LCDFB_TEXT_BITS(LOW, a, b, bits); \
+  high |= LCDFB_TEXT_BITS(HIGH, a, b, bits);
+
+#define LCDFB_NUMBER_COM(unused, seg) \
+  bits  = *plane++ >> shift; \
+  low  |= LCDFB_BIT_LOW(seg, bits); \
+  high |= LCDFB_BIT_HIGH(seg, bits);
+
+/*******************************************************************************
+ *******************************   STATICS   ***********************************
+ ******************************************************************************/
+
+static const LCDFB_Display_TypeDef display = EFM_DISPLAY_DEF;
+
+/* Segments of the symbols, in lcdSymbol order */
+static const uint8_t symbolCom[] =
+{
+  LCD_SYMBOL_GECKO_COM, LCD_SYMBOL_ANT_COM,   LCD_SYMBOL_PAD0_COM,
+  LCD_SYMBOL_PAD1_COM,  LCD_SYMBOL_EFM32_COM, LCD_SYMBOL_MINUS_COM,
+  LCD_SYMBOL_COL3_COM,  LCD_SYMBOL_COL5_COM,  LCD_SYMBOL_COL10_COM,
+  LCD_SYMBOL_DEGC_COM,  LCD_SYMBOL_DEGF_COM,  LCD_SYMBOL_DP2_COM,
+  LCD_SYMBOL_DP3_COM,   LCD_SYMBOL_DP4_COM,   LCD_SYMBOL_DP5_COM,
+  LCD_SYMBOL_DP6_COM,   LCD_SYMBOL_DP10_COM
+};
+
+static const uint8_t symbolSeg[] =
+{
+  LCD_SYMBOL_GECKO_SEG, LCD_SYMBOL_ANT_SEG,   LCD_SYMBOL_PAD0_SEG,
+  LCD_SYMBOL_PAD1_SEG,  LCD_SYMBOL_EFM32_SEG, LCD_SYMBOL_MINUS_SEG,
+  LCD_SYMBOL_COL3_SEG,  LCD_SYMBOL_COL5_SEG,  LCD_SYMBOL_COL10_SEG,
+  LCD_SYMBOL_DEGC_SEG,  LCD_SYMBOL_DEGF_SEG,  LCD_SYMBOL_DP2_SEG,
+  LCD_SYMBOL_DP3_SEG,   LCD_SYMBOL_DP4_SEG,   LCD_SYMBOL_DP5_SEG,
+  LCD_SYMBOL_DP6_SEG,   LCD_SYMBOL_DP10_SEG
+};
+
+/* Every character of the font in the two layouts of the alphanumeric field,
+ * bit 2 * COM + segment line is set for every segment which is on */
+#define LCDFB_PLANES_N(c, pattern)   [(c) - ' '] = LCDFONT_PLANES_N(pattern),
+#define LCDFB_PLANES_S(c, pattern)   [(c) - ' '] = LCDFONT_PLANES_S(pattern),
+
+static const uint16_t textPlanesN[LCDFONT_TEXT_SIZE] = { LCDFONT_TEXT(LCDFB_PLANES_N) };
+static const uint16_t textPlanesS[LCDFONT_TEXT_SIZE] = { LCDFONT_TEXT(LCDFB_PLANES_S) };
+
+/* Font tables of the characters of the alphanumeric field */
+#define LCDFB_TEXT_PLANES(unused, layout, a, b)  textPlanes##layout,
+
+static const uint16_t *const textPlanes[] =
+{
+  LCDFONT_TEXT_POSITIONS(LCDFB_TEXT_PLANES, 0)
+};
+
+LCDFB_ASSERT(sizeof(textPlanes) / sizeof(textPlanes[0]) == 7, lcdfb_text_size);
+
+/* Every digit pattern, bit COM is set for every segment which is on */
+#define LCDFB_PLANES_DIGIT(pattern)  LCDFONT_PLANES_DIGIT(pattern),
+
+static const uint8_t numberPlanes[] = { LCDFONT_DIGITS(LCDFB_PLANES_DIGIT) };
+
+LCDFB_ASSERT(sizeof(numberPlanes) == LCDFONT_MINUS + 1, lcdfb_digits_size);
+
+/* Segments of the alphanumeric field in every COM line */
+#define LCDFB_TEXT_MASK_LOW(com) \
+  (0UL LCDFONT_TEXT_POSITIONS(LCDFB_TEXT_ALL_LOW, com)),
+#define LCDFB_TEXT_MASK_HIGH(com) \
+  (0UL LCDFONT_TEXT_POSITIONS(LCDFB_TEXT_ALL_HIGH, com)),
+#define LCDFB_TEXT_ALL_LOW(com, layout, a, b) \
+  | LCDFB_TEXT_BITS(LOW, a, b, LCDFONT_PLANES_##layout(LCDFONT_TEXT_ALL) >> (2 * (com)))
+#define LCDFB_TEXT_ALL_HIGH(com, layout, a, b) \
+  | LCDFB_TEXT_BITS(HIGH, a, b, LCDFONT_PLANES_##layout(LCDFONT_TEXT_ALL) >> (2 * (com)))
+
+static const LCDFB_Frame_TypeDef textMask =
+{
+  { LCDFB_COM_LIST(LCDFB_TEXT_MASK_LOW) },
+  { LCDFB_COM_LIST(LCDFB_TEXT_MASK_HIGH) }
+};
+
+/* Segments of the numeric field in every COM line */
+#define LCDFB_NUMBER_MASK_LOW(com) \
+  (0UL LCDFONT_NUMBER_POSITIONS(LCDFB_NUMBER_ALL_LOW, com)),
+#define LCDFB_NUMBER_MASK_HIGH(com) \
+  (0UL LCDFONT_NUMBER_POSITIONS(LCDFB_NUMBER_ALL_HIGH, com)),
+#define LCDFB_NUMBER_ALL_LOW(com, seg) \
+  | LCDFB_BIT_LOW(seg, LCDFONT_PLANES_DIGIT(LCDFONT_DIGIT_ALL) >> (com))
+#define LCDFB_NUMBER_ALL_HIGH(com, seg) \
+  | LCDFB_BIT_HIGH(seg, LCDFONT_PLANES_DIGIT(LCDFONT_DIGIT_ALL) >> (com))
+
+static const LCDFB_Frame_TypeDef numberMask =
+{
+  { LCDFB_COM_LIST(LCDFB_NUMBER_MASK_LOW) },
+  { LCDFB_COM_LIST(LCDFB_NUMBER_MASK_HIGH) }
+};
+
+/* Frame drawn by the LCDFB functions */
+static LCDFB_Frame_TypeDef frame;
+
+/* Frame last written to the LCD */
+static LCDFB_Frame_TypeDef written;
+
+
+/* false if the LCD registers are not known to hold written */
+static bool writtenValid;
+
+/** @endcond */
+
+/*******************************************************************************
+ **************************   LOCAL FUNCTIONS   ********************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Turn a segment on or off in a frame.
+ ******************************************************************************/
+static void segmentSet(LCDFB_Frame_TypeDef *target, int com, int bit, bool on)
+{
+  uint32_t *reg;
+
+  if (bit < 32)
+  {
+    reg = &target->low[com];
+  }
+  else
+  {
+    reg  = &target->high[com];
+    bit -= 32;
+  }
+
+  if (on)
+  {
+    *reg |= 1UL << bit;
+  }
+  else
+  {
+    *reg &= ~(1UL << bit);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Draw text on the alphanumeric field of a frame.
+ *
+ * @details
+ *   The font tables give the segments of every character per COM line, and
+ *   the segment lines of every position are constants, so a COM line takes
+ *   a few shifts and ORs per character.
+ ******************************************************************************/
+static void textDraw(LCDFB_Frame_TypeDef *target, const char *string)
+{
+  uint16_t       planes[7];
+  const uint16_t *plane;
+  uint32_t       shift;
+  uint32_t       low;
+  uint32_t       high;
+  uint32_t       bits;
+  int            com;
+  int            pos;
+  char           c;
+
+  for (pos = 0; pos < 7; pos++)
+  {
+    c = *string;
+    if (c != '\0')
+    {
+      string++;
+    }
+    if ((c < ' ') || (c > 'z'))
+    {
+      c = ' ';
+    }
+    planes[pos] = textPlanes[pos][c - ' '];
+  }
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    plane = planes;
+    shift = 2 * com;
+    low   = target->low[com] & ~textMask.low[com];
+    high  = target->high[com] & ~textMask.high[com];
+    LCDFONT_TEXT_POSITIONS(LCDFB_TEXT_COM, 0)
+    target->low[com]  = low;
+    target->high[com] = high;
+  }
+}
+
+/***************************************************************************//**
+ * @brief Draw the digits of the numeric field, 0 is a digit with all off.
+ ******************************************************************************/
+static void numberDraw(const uint8_t *planes)
+{
+  const uint8_t *plane;
+  uint32_t      shift;
+  uint32_t      low;
+  uint32_t      high;
+  uint32_t      bits;
+  int           com;
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    plane = planes;
+    shift = com;
+    low   = frame.low[com] & ~numberMask.low[com];
+    high  = frame.high[com] & ~numberMask.high[com];
+    LCDFONT_NUMBER_POSITIONS(LCDFB_NUMBER_COM, 0)
+    frame.low[com]  = low;
+    frame.high[com] = high;
+  }
+}
+
+#if defined(DEBUG_EFM)
+/* Layout of the font tables */
+#define LCDFB_LAYOUT_COM(p, bit, com, line)   com,
+#define LCDFB_LAYOUT_LINE(p, bit, com, line)  line,
+#define LCDFB_TEXT_SEGS(unused, layout, a, b) { a, b },
+#define LCDFB_NUMBER_SEG(unused, seg)         seg,
+
+/***************************************************************************//**
+ * @brief Check that the font tables have the layout of EFM_DISPLAY_DEF.
+ ******************************************************************************/
+static void layoutCheck(void)
+{
+  static const uint8_t comN[14]   = { LCDFONT_LAYOUT_N(LCDFB_LAYOUT_COM, 0) };
+  static const uint8_t lineN[14]  = { LCDFONT_LAYOUT_N(LCDFB_LAYOUT_LINE, 0) };
+  static const uint8_t comS[14]   = { LCDFONT_LAYOUT_S(LCDFB_LAYOUT_COM, 0) };
+  static const uint8_t lineS[14]  = { LCDFONT_LAYOUT_S(LCDFB_LAYOUT_LINE, 0) };
+  static const uint8_t comD[7]    = { LCDFONT_LAYOUT_DIGIT(LCDFB_LAYOUT_COM, 0) };
+  static const uint8_t segs[7][2] = { LCDFONT_TEXT_POSITIONS(LCDFB_TEXT_SEGS, 0) };
+  static const uint8_t digitSegs[4] = { LCDFONT_NUMBER_POSITIONS(LCDFB_NUMBER_SEG, 0) };
+  LCDFB_Frame_TypeDef text   = { { 0 }, { 0 } };
+  LCDFB_Frame_TypeDef number = { { 0 }, { 0 } };
+  const uint8_t       *com;
+  const uint8_t       *line;
+  int                 pos;
+  int                 i;
+
+  for (pos = 0; pos < 7; pos++)
+  {
+    com  = (textPlanes[pos] == textPlanesN) ? comN : comS;
+    line = (textPlanes[pos] == textPlanesN) ? lineN : lineS;
+    for (i = 0; i < 14; i++)
+    {
+      EFM_ASSERT(display.Text[pos].com[i] == com[i]);
+      EFM_ASSERT(display.Text[pos].bit[i] == segs[pos][line[i]]);
+      segmentSet(&text, display.Text[pos].com[i], display.Text[pos].bit[i], true);
+    }
+  }
+  for (pos = 0; pos < 4; pos++)
+  {
+    for (i = 0; i < 7; i++)
+    {
+      EFM_ASSERT(display.Number[pos].com[i] == comD[i]);
+      EFM_ASSERT(display.Number[pos].bit[i] == digitSegs[pos]);
+      segmentSet(&number, display.Number[pos].com[i], display.Number[pos].bit[i], true);
+    }
+  }
+  for (i = 0; i < LCDFB_COMS; i++)
+  {
+    EFM_ASSERT((text.low[i] == textMask.low[i]) && (text.high[i] == textMask.high[i]));
+    EFM_ASSERT((number.low[i] == numberMask.low[i]) && (number.high[i] == numberMask.high[i]));
+  }
+}
+#endif
+
+/*******************************************************************************
+ **************************   GLOBAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Initialize the framebuffer with all segments off.
+ *
+ * @details
+ *   Call after SegmentLCD_Init(). The next LCDFB_Update() writes all
+ *   segment registers.
+ ******************************************************************************/
+void LCDFB_Init(void)
+{
+  uint32_t primask;
+  int      com;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    frame.low[com]  = 0;
+    frame.high[com] = 0;
+  }
+  writtenValid = false;
+
+#if defined(DEBUG_EFM)
+  layoutCheck();
+#endif
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Write the whole frame on the next update.
+ *
+ * @details
+ *   Call when the segment registers have been changed outside the
+ *   framebuffer, for example after SegmentLCD_Init() to change the boost
+ *   setting.
+ ******************************************************************************/
+void LCDFB_Invalidate(void)
+{
+  writtenValid = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Write the changes in the frame to the LCD.
+ *
+ * @details
+ *   The LCD is frozen while the changed registers are written, so they are
+ *   shown in the same frame. Nothing is written if the frame is unchanged.
+ *   Can be called from interrupt handlers, interrupts are disabled while the
+ *   registers are written.
+ *
+ * @return
+ *   Number of segment registers written.
+ ******************************************************************************/
+int LCDFB_Update(void)
+{
+  uint32_t primask;
+  int      com;
+  int      writes = 0;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    if (!writtenValid || (frame.low[com] != written.low[com]))
+    {
+      if (writes++ == 0)
+      {
+        LCD_FreezeEnable(true);
+      }
+      LCD_SegmentSetLow(com, LCDFB_LOW_MASK, frame.low[com]);
+    }
+    if (!writtenValid || (frame.high[com] != written.high[com]))
+    {
+      if (writes++ == 0)
+      {
+        LCD_FreezeEnable(true);
+      }
+      LCD_SegmentSetHigh(com, LCDFB_HIGH_MASK, frame.high[com]);
+    }
+  }
+
+  if (writes > 0)
+  {
+    LCD_FreezeEnable(false);
+  }
+
+  written      = frame;
+  writtenValid = true;
+
+  __set_PRIMASK(primask);
+
+  return writes;
+}
+
+/***************************************************************************//**
+ * @brief Get a copy of the frame, as it will be written by LCDFB_Update().
+ ******************************************************************************/
+void LCDFB_FrameGet(LCDFB_Frame_TypeDef *copy)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  *copy = frame;
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief Turn all segments off.
+ ******************************************************************************/
+void LCDFB_AllOff(void)
+{
+  uint32_t primask;
+  int      com;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    frame.low[com]  = 0;
+    frame.high[com] = 0;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief Turn all segments on.
+ ******************************************************************************/
+void LCDFB_AllOn(void)
+{
+  uint32_t primask;
+  int      com;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    frame.low[com]  = LCDFB_LOW_MASK;
+    frame.high[com] = LCDFB_HIGH_MASK;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief Turn all segments of the alphanumeric field off.
+ ******************************************************************************/
+void LCDFB_AlphaNumberOff(void)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  textDraw(&frame, "");
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief Turn all segments of the numeric field off.
+ ******************************************************************************/
+void LCDFB_NumberOff(void)
+{
+  static const uint8_t off[4] = { 0, 0, 0, 0 };
+  uint32_t             primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  numberDraw(off);
+  segmentSet(&frame, LCD_SYMBOL_MINUS_COM, LCD_SYMBOL_MINUS_SEG, false);
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Write text on the alphanumeric field.
+ *
+ * @param[in] string
+ *   Text, the first 7 characters are shown. Shorter text is padded with
+ *   spaces, characters without a glyph are shown as spaces.
+ ******************************************************************************/
+void LCDFB_Write(const char *string)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  textDraw(&frame, string);
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Render text of the alphanumeric field into a separate frame.
+ *
+ * @details
+ *   The text is rendered as by LCDFB_Write(), with all other segments off.
+ *   It is shown with LCDFB_TextSet(), so text can be rendered ahead of time.
+ *
+ * @param[in] string
+ *   Text, as for LCDFB_Write().
+ *
+ * @param[out] text
+ *   Rendered text.
+ ******************************************************************************/
+void LCDFB_TextRender(const char *string, LCDFB_Frame_TypeDef *text)
+{
+  int com;
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    text->low[com]  = 0;
+    text->high[com] = 0;
+  }
+
+  textDraw(text, string);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Replace the alphanumeric field with text from LCDFB_TextRender().
+ *
+ * @details
+ *   Only the segments of the alphanumeric field are changed, from interrupt
+ *   handlers as well.
+ ******************************************************************************/
+void LCDFB_TextSet(const LCDFB_Frame_TypeDef *text)
+{
+  uint32_t primask;
+  int      com;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  for (com = 0; com < LCDFB_COMS; com++)
+  {
+    frame.low[com]  = (frame.low[com] & ~textMask.low[com]) | text->low[com];
+    frame.high[com] = (frame.high[com] & ~textMask.high[com]) | text->high[com];
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Write a number on the numeric field.
+ *
+ * @param[in] value
+ *   Number, -999 to 9999. Values outside the range are limited.
+ ******************************************************************************/
+void LCDFB_Number(int value)
+{
+  uint8_t  planes[4];
+  uint32_t primask;
+  bool     negative = false;
+  int      pos;
+
+  if (value > 9999)
+  {
+    value = 9999;
+  }
+  if (value < -999)
+  {
+    value = -999;
+  }
+  if (value < 0)
+  {
+    value    = -value;
+    negative = true;
+  }
+
+  /* Digit 0 is the least significant, the minus takes digit 3 */
+  for (pos = 0; pos < 4; pos++)
+  {
+    if (negative && (pos == 3))
+    {
+      planes[pos] = numberPlanes[LCDFONT_MINUS];
+    }
+    else
+    {
+      planes[pos] = numberPlanes[value % 10];
+    }
+    value /= 10;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  numberDraw(planes);
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief Turn a symbol on or off.
+ ******************************************************************************/
+void LCDFB_Symbol(lcdSymbol s, int on)
+{
+  uint32_t primask;
+
+  EFM_ASSERT((unsigned)s < sizeof(symbolCom));
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  segmentSet(&frame, symbolCom[s], symbolSeg[s], on != 0);
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief Turn a segment of the ring, 0-7, on or off.
+ ******************************************************************************/
+void LCDFB_ARing(int anum, int on)
+{
+  uint32_t primask;
+
+  EFM_ASSERT((anum >= 0) && (anum < 8));
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  segmentSet(&frame, display.ARing.com[anum], display.ARing.bit[anum], on != 0);
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief Show a battery level, 0-4 segments.
+ ******************************************************************************/
+void LCDFB_Battery(int batteryLevel)
+{
+  uint32_t primask;
+  int      i;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  for (i = 0; i < 4; i++)
+  {
+    segmentSet(&frame, display.Battery.com[i], display.Battery.bit[i], i < batteryLevel);
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief Turn an energy mode indicator, 0-4, on or off.
+ ******************************************************************************/
+void LCDFB_EnergyMode(int em, int on)
+{
+  uint32_t primask;
+
+  EFM_ASSERT((em >= 0) && (em < 5));
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  segmentSet(&frame, display.EMode.com[em], display.EMode.bit[em], on != 0);
+  __set_PRIMASK(primask);
+}
+
+/** @} (end addtogroup LCDFB) */
@@ -0,0 +1,159 @@
+/***************************************************************************//**
+ * @file
+ * @brief Segment LCD framebuffer with synchronized updates.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __LCDFB_H
+#define __LCDFB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "segmentlcdconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup LCDFB
+ * @brief RAM framebuffer for the STK3700 segment LCD.
+ * @details
+ *   The drawing functions have the same arguments as the SegmentLCD
+ *   functions, but only change a RAM copy of the LCD segment registers.
+ *   LCDFB_Update() writes the registers which differ from what was last
+ *   written, with the LCD frozen, so all changes since the previous update
+ *   show up in the same LCD frame.
+ *
+ *   SegmentLCD writes every segment with a read-modify-write of its
+ *   register, waiting for the low frequency domain each time. A display
+ *   update of text, number and a few symbols costs more than a hundred such
+ *   writes, with the framebuffer it is at most one write per register, only
+ *   for registers which have changed.
+ *
+ *   The segment registers must not be written by other code while the
+ *   framebuffer is in use, except by SegmentLCD_Init(), after which
+ *   LCDFB_Invalidate() must be called. The drawing functions and
+ *   LCDFB_Update() may be called from interrupt handlers.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/** Number of COM lines. */
+#define LCDFB_COMS              8
+
+/** Segments 0-31 in use, in the SEGDnL registers. */
+#define LCDFB_LOW_MASK          0xF00FF000UL
+
+/** Segments 32-39 in use, in the SEGDnH registers. */
+#define LCDFB_HIGH_MASK         0x000000FFUL
+
+/*******************************************************************************
+ ******************************   TYPEDEFS   ***********************************
+ ******************************************************************************/
+
+/** Segments of a character of the alphanumeric field, in font bit order. */
+typedef struct
+{
+  uint8_t com[14];             /**< COM line of every segment. */
+  uint8_t bit[14];             /**< Segment line of every segment. */
+} LCDFB_Char_TypeDef;
+
+/** Segments of a digit of the numeric field, in font bit order. */
+typedef struct
+{
+  uint8_t com[7];              /**< COM line of every segment. */
+  uint8_t bit[7];              /**< Segment line of every segment. */
+} LCDFB_Digit_TypeDef;
+
+/** Segment layout of the display, initialized with EFM_DISPLAY_DEF of
+ *  segmentlcdconfig.h. */
+typedef struct
+{
+  LCDFB_Char_TypeDef  Text[7];   /**< Alphanumeric field, left to right. */
+  LCDFB_Digit_TypeDef Number[4]; /**< Numeric field, least significant first. */
+  struct
+  {
+    uint8_t com[5];
+    uint8_t bit[5];
+  } EMode;                       /**< Energy mode indicators 0-4. */
+  struct
+  {
+    uint8_t com[8];
+    uint8_t bit[8];
+  } ARing;                       /**< Segments of the ring. */
+  struct
+  {
+    uint8_t com[4];
+    uint8_t bit[4];
+  } Battery;                     /**< Battery level segments. */
+} LCDFB_Display_TypeDef;
+
+/** Segment register contents. */
+typedef struct
+{
+  uint32_t low[LCDFB_COMS];    /**< SEGD0L - SEGD7L, segments 0-31.  */
+  uint32_t high[LCDFB_COMS];   /**< SEGD0H - SEGD7H, segments 32-39. */
+} LCDFB_Frame_TypeDef;
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+void LCDFB_Init(void);
+void LCDFB_Invalidate(void);
+int  LCDFB_Update(void);
+void LCDFB_FrameGet(LCDFB_Frame_TypeDef *frame);
+
+void LCDFB_AllOff(void);
+void LCDFB_AllOn(void);
+void LCDFB_AlphaNumberOff(void);
+void LCDFB_NumberOff(void);
+void LCDFB_Write(const char *string);
+void LCDFB_TextRender(const char *string, LCDFB_Frame_TypeDef *text);
+void LCDFB_TextSet(const LCDFB_Frame_TypeDef *text);
+void LCDFB_Number(int value);
+void LCDFB_Symbol(lcdSymbol s, int on);
+void LCDFB_ARing(int anum, int on);
+void LCDFB_Battery(int batteryLevel);
+void LCDFB_EnergyMode(int em, int on);
+
+/** @} (end addtogroup LCDFB) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCDFB_H */
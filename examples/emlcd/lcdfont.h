@@ -0,0 +1,143 @@
+/***************************************************************************//**
+ * @file
+ * @brief Font and segment layout of the STK3700 segment LCD.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __LCDFONT_H
+#define __LCDFONT_H
+
+#include <stdint.h>
+
+/***************************************************************************//**
+ * @addtogroup LCDFB
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/** Characters of the font, from SPACE (0x20) to 'z'. */
+#define LCDFONT_TEXT_SIZE       ('z' - ' ' + 1)
+
+/** Patterns of the font, X(character, pattern). Font bits 0-13 are the
+ *  segments a-f, g, h, j, k, m, n, p and q of a character. */
+#define LCDFONT_TEXT(X) \
+  X(' ',  0x0000) X('!',  0x1100) X('"',  0x0280) X('#',  0x0000) \
+  X('$',  0x0000) X('%',  0x0602) X('&',  0x0000) X('\'', 0x0020) \
+  X('(',  0x0039) X(')',  0x000f) X('*',  0x0000) X('+',  0x1540) \
+  X(',',  0x2000) X('-',  0x0440) X('.',  0x1000) X('/',  0x2200) \
+  X('0',  0x003f) X('1',  0x0006) X('2',  0x045b) X('3',  0x044f) \
+  X('4',  0x0466) X('5',  0x046d) X('6',  0x047d) X('7',  0x0007) \
+  X('8',  0x047f) X('9',  0x046f) X(':',  0x0000) X(';',  0x0000) \
+  X('<',  0x0a00) X('=',  0x0000) X('>',  0x2080) X('?',  0x0000) \
+  X('@',  0xffff) X('A',  0x0477) X('B',  0x0a79) X('C',  0x0039) \
+  X('D',  0x20b0) X('E',  0x0079) X('F',  0x0071) X('G',  0x047d) \
+  X('H',  0x0476) X('I',  0x0006) X('J',  0x000e) X('K',  0x0a70) \
+  X('L',  0x0038) X('M',  0x02b6) X('N',  0x08b6) X('O',  0x003f) \
+  X('P',  0x0473) X('Q',  0x083f) X('R',  0x0c73) X('S',  0x046d) \
+  X('T',  0x1101) X('U',  0x003e) X('V',  0x2230) X('W',  0x2836) \
+  X('X',  0x2a80) X('Y',  0x046e) X('Z',  0x2209) X('[',  0x0039) \
+  X('\\', 0x0880) X(']',  0x000f) X('^',  0x0001) X('_',  0x0008) \
+  X('`',  0x0100) X('a',  0x1058) X('b',  0x047c) X('c',  0x0058) \
+  X('d',  0x045e) X('e',  0x2058) X('f',  0x0471) X('g',  0x0c0c) \
+  X('h',  0x0474) X('i',  0x0004) X('j',  0x000e) X('k',  0x0c70) \
+  X('l',  0x0038) X('m',  0x1454) X('n',  0x0454) X('o',  0x045c) \
+  X('p',  0x0473) X('q',  0x0467) X('r',  0x0450) X('s',  0x0c08) \
+  X('t',  0x0078) X('u',  0x001c) X('v',  0x2010) X('w',  0x2814) \
+  X('x',  0x2a80) X('y',  0x080c) X('z',  0x2048)
+
+/** Patterns of the numeric field, digits 0-9 and minus, X(pattern). Font
+ *  bits 0-6 are the segments a-g of a digit. */
+#define LCDFONT_DIGITS(X) \
+  X(0x3f) X(0x06) X(0x5b) X(0x4f) X(0x66) X(0x6d) X(0x7d) X(0x07) X(0x7f) \
+  X(0x6f) X(0x40)
+
+/** Index of the minus in LCDFONT_DIGITS. */
+#define LCDFONT_MINUS           10
+
+/** Segments of the font bits of characters 1-4 and 7, X(pattern, font bit,
+ *  COM line, segment line), where segment line 0 is the first and 1 the
+ *  second of the two segment lines of the character. */
+#define LCDFONT_LAYOUT_N(X, p) \
+  X(p, 0, 1, 0)  X(p, 1, 1, 1)  X(p, 2, 5, 1)  X(p, 3, 7, 1)  \
+  X(p, 4, 7, 0)  X(p, 5, 3, 0)  X(p, 6, 4, 0)  X(p, 7, 2, 0)  \
+  X(p, 8, 3, 1)  X(p, 9, 2, 1)  X(p, 10, 4, 1) X(p, 11, 6, 1) \
+  X(p, 12, 5, 0) X(p, 13, 6, 0)
+
+/** Segments of the font bits of characters 5 and 6, as LCDFONT_LAYOUT_N. */
+#define LCDFONT_LAYOUT_S(X, p) \
+  X(p, 0, 0, 0)  X(p, 1, 1, 1)  X(p, 2, 5, 1)  X(p, 3, 7, 1)  \
+  X(p, 4, 6, 0)  X(p, 5, 2, 0)  X(p, 6, 3, 0)  X(p, 7, 1, 0)  \
+  X(p, 8, 3, 1)  X(p, 9, 2, 1)  X(p, 10, 4, 1) X(p, 11, 6, 1) \
+  X(p, 12, 4, 0) X(p, 13, 5, 0)
+
+/** Segments of the font bits of the digits, X(pattern, font bit, COM line,
+ *  segment line). A digit has a single segment line. */
+#define LCDFONT_LAYOUT_DIGIT(X, p) \
+  X(p, 0, 7, 0) X(p, 1, 5, 0) X(p, 2, 2, 0) X(p, 3, 1, 0) \
+  X(p, 4, 3, 0) X(p, 5, 6, 0) X(p, 6, 4, 0)
+
+/** Characters of the alphanumeric field, left to right, X(a, layout, first
+ *  segment line, second segment line), where a is passed on. */
+#define LCDFONT_TEXT_POSITIONS(X, a) \
+  X(a, N, 13, 14) X(a, N, 15, 16) X(a, N, 17, 18) X(a, N, 19, 28) \
+  X(a, S, 29, 30) X(a, S, 31, 32) X(a, N, 33, 34)
+
+/** Digits of the numeric field, least significant first, X(a, segment
+ *  line), where a is passed on. */
+#define LCDFONT_NUMBER_POSITIONS(X, a) \
+  X(a, 35) X(a, 36) X(a, 37) X(a, 38)
+
+/** Segments of a pattern per COM line: bit 2 * COM + segment line of a
+ *  character, bit COM of a digit. */
+#define LCDFONT_PLANE_BIT(p, bit, com, line) \
+  | ((((uint32_t)(p) >> (bit)) & 1UL) << (2 * (com) + (line)))
+#define LCDFONT_DIGIT_BIT(p, bit, com, line) \
+  | ((((uint32_t)(p) >> (bit)) & 1UL) << (com))
+
+/** Segments per COM line of a character pattern with LCDFONT_LAYOUT_N. */
+#define LCDFONT_PLANES_N(p)     ((uint16_t)(0 LCDFONT_LAYOUT_N(LCDFONT_PLANE_BIT, p)))
+
+/** Segments per COM line of a character pattern with LCDFONT_LAYOUT_S. */
+#define LCDFONT_PLANES_S(p)     ((uint16_t)(0 LCDFONT_LAYOUT_S(LCDFONT_PLANE_BIT, p)))
+
+/** Font pattern with all segments of a character or digit. */
+#define LCDFONT_TEXT_ALL        0x3fff
+#define LCDFONT_DIGIT_ALL       0x7f
+
+/** COM lines of the segments of a digit pattern. */
+#define LCDFONT_PLANES_DIGIT(p) ((uint8_t)(0 LCDFONT_LAYOUT_DIGIT(LCDFONT_DIGIT_BIT, p)))
+
+/** @} (end addtogroup LCDFB) */
+
+#endif /* __LCDFONT_H */
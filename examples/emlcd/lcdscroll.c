@@ -0,0 +1,240 @@
+/***************************************************************************//**
+ * @file
+ * @brief Segment LCD text scrolling from the LCD frame counter.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <string.h>
+
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_lcd.h"
+
+#include "lcdfb.h"
+#include "lcdscroll.h"
+
+/***************************************************************************//**
+ * @addtogroup LCDSCROLL
+ * @{
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/* Frame counter TOP is 6 bits */
+#define LCDSCROLL_TOP_MAX        63
+
+/*******************************************************************************
+ *******************************   STATICS   ***********************************
+ ******************************************************************************/
+
+/* Frame counter prescalers, by log2 of the division */
+static const LCD_FCPreScale_TypeDef prescale[] =
+{
+  lcdFCPrescDiv1, lcdFCPrescDiv2, lcdFCPrescDiv4, lcdFCPrescDiv8
+};
+
+/* Copy of the message, every step shows 7 characters from offset step */
+static char text[LCDSCROLL_MAX_LENGTH + 1];
+
+static volatile int  stepCount;
+static volatile int  step;
+static volatile bool running;
+static bool          repeating;
+
+/** @endcond */
+
+/*******************************************************************************
+ **************************   LOCAL FUNCTIONS   ********************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Set the frame counter to give an event every stepMs.
+ *
+ * @details
+ *   The step time is rounded to whole LCD frames. Up to 64 frames are
+ *   counted without prescaling, longer steps are prescaled by up to 8.
+ ******************************************************************************/
+static void frameCountSetup(uint32_t stepMs)
+{
+  LCD_FrameCountInit_TypeDef frameInit;
+  uint32_t                   frames;
+  uint32_t                   presc = 0;
+
+  frames = (stepMs * LCDSCROLL_FRAME_RATE + 500) / 1000;
+  if (frames == 0)
+  {
+    frames = 1;
+  }
+  while ((presc < 3) && (frames > ((LCDSCROLL_TOP_MAX + 1UL) << presc)))
+  {
+    presc++;
+  }
+  frames = (frames + (1 << presc) / 2) >> presc;
+  if (frames > LCDSCROLL_TOP_MAX + 1)
+  {
+    frames = LCDSCROLL_TOP_MAX + 1;
+  }
+  if (frames == 0)
+  {
+    frames = 1;
+  }
+
+  frameInit.enable   = true;
+  frameInit.top      = frames - 1;
+  frameInit.prescale = prescale[presc];
+  LCD_FrameCountInit(&frameInit);
+}
+
+/*******************************************************************************
+ **************************   GLOBAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief LCD interrupt handler, shows the next step at a frame counter event.
+ ******************************************************************************/
+void LCD_IRQHandler(void)
+{
+  LCD_IntClear(LCD_IF_FC);
+
+  if (!running)
+  {
+    return;
+  }
+
+  if (++step >= stepCount)
+  {
+    if (!repeating)
+    {
+      /* The last step stays on the display */
+      LCDSCROLL_Stop();
+      return;
+    }
+    step = 0;
+  }
+
+  /* Written now, shown at the next frame counter event */
+  LCDFB_Write(&text[step]);
+  LCDFB_Update();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start scrolling a message on the alphanumeric field.
+ *
+ * @details
+ *   The first 7 characters are shown immediately, and the message moves one
+ *   character to the left every step until its last 7 characters are
+ *   shown. A message shorter than 7 characters is shown without scrolling.
+ *   A scrolling message is replaced. A message longer than
+ *   LCDSCROLL_MAX_LENGTH is an error, in a release build it is cut off
+ *   after LCDSCROLL_MAX_LENGTH characters.
+ *
+ * @param[in] message
+ *   Message, copied, so it is only used during this call.
+ *
+ * @param[in] stepMs
+ *   Time of every step in ms, rounded to LCD frames, 31 ms to 16 s.
+ *
+ * @param[in] repeat
+ *   Start over after the last step until LCDSCROLL_Stop() is called.
+ ******************************************************************************/
+void LCDSCROLL_Start(const char *message, uint32_t stepMs, bool repeat)
+{
+  int len = strlen(message);
+
+  EFM_ASSERT(len <= LCDSCROLL_MAX_LENGTH);
+
+  LCDSCROLL_Stop();
+
+  if (len > LCDSCROLL_MAX_LENGTH)
+  {
+    len = LCDSCROLL_MAX_LENGTH;
+  }
+  memcpy(text, message, len);
+  text[len] = '\0';
+
+  stepCount = (len > 7) ? len - 6 : 1;
+  step      = 0;
+  repeating = repeat;
+
+  /* First step right away */
+  LCDFB_Write(text);
+  LCDFB_Update();
+
+  if (stepCount > 1)
+  {
+    running = true;
+    LCD_UpdateCtrl(lcdUpdateCtrlFCEvent);
+    frameCountSetup(stepMs);
+    LCD_IntClear(LCD_IF_FC);
+    LCD_IntEnable(LCD_IF_FC);
+    NVIC_ClearPendingIRQ(LCD_IRQn);
+    NVIC_EnableIRQ(LCD_IRQn);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop scrolling.
+ *
+ * @details
+ *   The current step stays on the display, and the LCD takes register
+ *   updates immediately again.
+ ******************************************************************************/
+void LCDSCROLL_Stop(void)
+{
+  if (!running)
+  {
+    return;
+  }
+
+  running = false;
+  LCD_IntDisable(LCD_IF_FC);
+  LCD_FrameCountEnable(false);
+  LCD_UpdateCtrl(lcdUpdateCtrlRegular);
+  LCD_IntClear(LCD_IF_FC);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check if a message is scrolling.
+ ******************************************************************************/
+bool LCDSCROLL_Running(void)
+{
+  return running;
+}
+
+/** @} (end addtogroup LCDSCROLL) */
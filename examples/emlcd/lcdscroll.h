@@ -0,0 +1,94 @@
+/***************************************************************************//**
+ * @file
+ * @brief Segment LCD text scrolling from the LCD frame counter.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __LCDSCROLL_H
+#define __LCDSCROLL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup LCDSCROLL
+ * @brief Scrolling text on the alphanumeric field, timed by the LCD.
+ * @details
+ *   LCDSCROLL_Start() keeps a copy of the message. The LCD frame counter
+ *   then gives an interrupt for every step, and the interrupt handler draws
+ *   the next 7 characters of the message with LCDFB_Write(), which only
+ *   takes a font table lookup per character, and writes the changed segment
+ *   registers. The core sleeps in EM2 in between, and is not woken by any
+ *   other timer for the scrolling.
+ *
+ *   While scrolling, the LCD takes register updates at frame counter events
+ *   only, so every step is shown at an exact multiple of the LCD frame
+ *   period, independent of interrupt latency. Other drawing through
+ *   the framebuffer is shown at the next step.
+ *
+ *   The framebuffer must be initialized with LCDFB_Init(). The LCD frame
+ *   counter and interrupt are used while scrolling.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ ****************************   CONFIGURATION   ********************************
+ ******************************************************************************/
+
+/** Longest message in characters, the copy takes one byte more. */
+#ifndef LCDSCROLL_MAX_LENGTH
+#define LCDSCROLL_MAX_LENGTH    128
+#endif
+
+/** LCD frame rate in Hz, from the LCD clock setup in segmentlcdconfig.h. */
+#ifndef LCDSCROLL_FRAME_RATE
+#define LCDSCROLL_FRAME_RATE    32
+#endif
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+void LCDSCROLL_Start(const char *message, uint32_t stepMs, bool repeat);
+void LCDSCROLL_Stop(void);
+bool LCDSCROLL_Running(void);
+
+/** @} (end addtogroup LCDSCROLL) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCDSCROLL_H */
@@ -40,6 +40,8 @@
 #include "em_lcd.h"
 #include "em_gpio.h"
 #include "segmentlcd.h"
+#include "lcdfb.h"
+#include "lcdscroll.h"
 #include "lcdtest.h"
 #include "rtcdrv.h"
 
@@ -79,14 +81,14 @@ void GPIO_EVEN_IRQHandler(void)
   if (inEM3)
   {
     emMode = DEMO_MODE_NONE;
-    SegmentLCD_Symbol(LCD_SYMBOL_PAD0, 0);
-    SegmentLCD_Symbol(LCD_SYMBOL_PAD1, 0);
+    LCDFB_Symbol(LCD_SYMBOL_PAD0, 0);
+    LCDFB_Symbol(LCD_SYMBOL_PAD1, 0);
   }
   else
   {
     emMode = DEMO_MODE_EM4;
-    SegmentLCD_Symbol(LCD_SYMBOL_PAD0, 1);
-    SegmentLCD_Symbol(LCD_SYMBOL_PAD1, 1);
+    LCDFB_Symbol(LCD_SYMBOL_PAD0, 1);
+    LCDFB_Symbol(LCD_SYMBOL_PAD1, 1);
   }
 }
 
@@ -97,8 +99,8 @@ void GPIO_ODD_IRQHandler(void)
 {
   GPIO_IntClear(1 << 9);
 
-  SegmentLCD_Symbol(LCD_SYMBOL_PAD0, 1);
-  SegmentLCD_Symbol(LCD_SYMBOL_PAD1, 1);
+  LCDFB_Symbol(LCD_SYMBOL_PAD0, 1);
+  LCDFB_Symbol(LCD_SYMBOL_PAD1, 1);
 
   emMode = DEMO_MODE_EM3;
 }
@@ -134,7 +136,7 @@ void GPIO_IRQInit(void)
 void RtcTrigger(void)
 {
   /* Just a few No-OPerations to have a place to put a breakpoint */
-  SegmentLCD_Symbol(LCD_SYMBOL_EFM32, 1);
+  LCDFB_Symbol(LCD_SYMBOL_EFM32, 1);
 }
 
 
@@ -145,6 +147,9 @@ void RtcTrigger(void)
  *****************************************************************************/
 void EM1Sleep(uint32_t msec)
 {
+  /* Show what has been drawn since the last sleep */
+  LCDFB_Update();
+
   /* Wake us up after msec (or joystick pressed) */
   NVIC_DisableIRQ(LCD_IRQn);
 
@@ -161,6 +166,9 @@ void EM1Sleep(uint32_t msec)
  *****************************************************************************/
 void EM2Sleep(uint32_t msec)
 {
+  /* Show what has been drawn since the last sleep */
+  LCDFB_Update();
+
   /* Wake us up after msec (or joystick pressed) */
   NVIC_DisableIRQ(LCD_IRQn);
   RTCDRV_Trigger(msec, NULL);
@@ -178,6 +186,7 @@ void EM3Sleep(void)
   SegmentLCD_Disable();
   EMU_EnterEM3(true);
   SegmentLCD_Init(false);
+  LCDFB_Invalidate();
   inEM3 = false;
 }
 
@@ -187,27 +196,28 @@ void EM3Sleep(void)
  *****************************************************************************/
 void EM4Sleep(void)
 {
+  LCDFB_Update();
   EMU_EnterEM4();
   /* we will never wake up again here - reset required */
 }
 
 
 /**************************************************************************//**
- * @brief LCD scrolls a text over the display, sort of "polled printf"
+ * @brief LCD scrolls a text over the display, stepped by the LCD frame counter
  *****************************************************************************/
 void ScrollText(char *scrolltext)
 {
-  int  i, len;
-  char buffer[8];
+  LCDSCROLL_Start(scrolltext, 200, false);
 
-  buffer[7] = 0x00;
-  len       = strlen(scrolltext);
-  if (len < 7) return;
-  for (i = 0; i < (len - 7); i++)
+  /* Sleep in EM2 until the last step, the LCD interrupt does the steps */
+  while (LCDSCROLL_Running())
   {
-    memcpy(buffer, scrolltext + i, 7);
-    SegmentLCD_Write(buffer);
-    EM2Sleep(200);
+    __disable_irq();
+    if (LCDSCROLL_Running())
+    {
+      EMU_EnterEM2(true);
+    }
+    __enable_irq();
   }
 }
 
@@ -216,30 +226,30 @@ void ScrollText(char *scrolltext)
  *****************************************************************************/
 void BlinkTest(void)
 {
-  SegmentLCD_EnergyMode(0, 1);
-  SegmentLCD_EnergyMode(1, 1);
-  SegmentLCD_EnergyMode(2, 1);
-  SegmentLCD_EnergyMode(3, 1);
-  SegmentLCD_EnergyMode(4, 1);
+  LCDFB_EnergyMode(0, 1);
+  LCDFB_EnergyMode(1, 1);
+  LCDFB_EnergyMode(2, 1);
+  LCDFB_EnergyMode(3, 1);
+  LCDFB_EnergyMode(4, 1);
 
   /* 2 minutes to midnight */
-  SegmentLCD_Number(2358);
-  SegmentLCD_Symbol(LCD_SYMBOL_COL10, 1);
-  SegmentLCD_Symbol(LCD_SYMBOL_GECKO, 1);
-  SegmentLCD_Symbol(LCD_SYMBOL_EFM32, 1);
-  SegmentLCD_Write(" EFM32 ");
+  LCDFB_Number(2358);
+  LCDFB_Symbol(LCD_SYMBOL_COL10, 1);
+  LCDFB_Symbol(LCD_SYMBOL_GECKO, 1);
+  LCDFB_Symbol(LCD_SYMBOL_EFM32, 1);
+  LCDFB_Write(" EFM32 ");
   LCD->BACTRL |= LCD_BACTRL_BLINKEN;
   while (LCD->SYNCBUSY) ;
   EM2Sleep(2000);
-  SegmentLCD_EnergyMode(4, 0);
+  LCDFB_EnergyMode(4, 0);
   EM2Sleep(62);
-  SegmentLCD_EnergyMode(3, 0);
+  LCDFB_EnergyMode(3, 0);
   EM2Sleep(62);
-  SegmentLCD_EnergyMode(2, 0);
+  LCDFB_EnergyMode(2, 0);
   EM2Sleep(62);
-  SegmentLCD_EnergyMode(1, 0);
+  LCDFB_EnergyMode(1, 0);
   EM2Sleep(62);
-  SegmentLCD_EnergyMode(0, 0);
+  LCDFB_EnergyMode(0, 0);
   LCD->BACTRL &= ~LCD_BACTRL_BLINKEN;
   while (LCD->SYNCBUSY) ;
 }
@@ -272,9 +282,10 @@ void checkVoltage(void)
   if (vboost != oldBoost)
   {
     SegmentLCD_Init(vboost);
+    LCDFB_Invalidate();
 
     /* Use Antenna symbol to signify enabling of vboost */
-    SegmentLCD_Symbol(LCD_SYMBOL_ANT, vboost);
+    LCDFB_Symbol(LCD_SYMBOL_ANT, vboost);
     oldBoost = vboost;
   }
 }
@@ -295,168 +306,172 @@ void Test(void)
   /* Loop through funny pattern */
   while (1)
   {
-    SegmentLCD_AllOff();
+    LCDFB_AllOff();
 #if VBOOST_SUPPORT
     checkVoltage();
 #endif
 
     if (emMode != DEMO_MODE_NONE)
     {
-      SegmentLCD_Symbol(LCD_SYMBOL_PAD0, 1);
-      SegmentLCD_Symbol(LCD_SYMBOL_PAD1, 1);
+      LCDFB_Symbol(LCD_SYMBOL_PAD0, 1);
+      LCDFB_Symbol(LCD_SYMBOL_PAD1, 1);
     }
     else
     {
       for (i = 100; i > 0; i--)
       {
-        SegmentLCD_Number(i);
+        LCDFB_Number(i);
         EM2Sleep(10);
       }
-      SegmentLCD_NumberOff();
+      LCDFB_NumberOff();
 
-      SegmentLCD_Symbol(LCD_SYMBOL_GECKO, 1);
-      SegmentLCD_Symbol(LCD_SYMBOL_EFM32, 1);
-      SegmentLCD_Write(" Giant ");
+      LCDFB_Symbol(LCD_SYMBOL_GECKO, 1);
+      LCDFB_Symbol(LCD_SYMBOL_EFM32, 1);
+      LCDFB_Write(" Giant ");
       EM2Sleep(500);
-      SegmentLCD_Write(" Gecko ");
+      LCDFB_Write(" Gecko ");
       EM2Sleep(1000);
-      SegmentLCD_AllOn();
+      LCDFB_AllOn();
       EM2Sleep(1000);
 
-      SegmentLCD_AllOff();
+      LCDFB_AllOff();
     }
     if (emMode != DEMO_MODE_NONE)
     {
-      SegmentLCD_Symbol(LCD_SYMBOL_PAD0, 1);
-      SegmentLCD_Symbol(LCD_SYMBOL_PAD1, 1);
+      LCDFB_Symbol(LCD_SYMBOL_PAD0, 1);
+      LCDFB_Symbol(LCD_SYMBOL_PAD1, 1);
     }
     else
     {
-      SegmentLCD_Write("OOOOOOO");
+      LCDFB_Write("OOOOOOO");
       EM2Sleep(62);
-      SegmentLCD_Write("XXXXXXX");
+      LCDFB_Write("XXXXXXX");
       EM2Sleep(62);
-      SegmentLCD_Write("+++++++");
+      LCDFB_Write("+++++++");
       EM2Sleep(62);
-      SegmentLCD_Write("@@@@@@@");
+      LCDFB_Write("@@@@@@@");
       EM2Sleep(62);
-      SegmentLCD_Write("ENERGY ");
+      LCDFB_Write("ENERGY ");
       EM2Sleep(250);
-      SegmentLCD_Write("@@ERGY ");
+      LCDFB_Write("@@ERGY ");
       EM2Sleep(62);
-      SegmentLCD_Write(" @@RGY ");
+      LCDFB_Write(" @@RGY ");
       EM2Sleep(62);
-      SegmentLCD_Write(" M@@GY ");
+      LCDFB_Write(" M@@GY ");
       EM2Sleep(62);
-      SegmentLCD_Write(" MI@@Y ");
+      LCDFB_Write(" MI@@Y ");
       EM2Sleep(62);
-      SegmentLCD_Write(" MIC@@ ");
+      LCDFB_Write(" MIC@@ ");
       EM2Sleep(62);
-      SegmentLCD_Write(" MICR@@");
+      LCDFB_Write(" MICR@@");
       EM2Sleep(62);
-      SegmentLCD_Write(" MICRO@");
+      LCDFB_Write(" MICRO@");
       EM2Sleep(62);
-      SegmentLCD_Write(" MICRO ");
+      LCDFB_Write(" MICRO ");
       EM2Sleep(250);
-      SegmentLCD_Write("-EFM32-");
+      LCDFB_Write("-EFM32-");
       EM2Sleep(250);
 
       /* Various eye candy */
-      SegmentLCD_AllOff();
+      LCDFB_AllOff();
       if (emMode != DEMO_MODE_NONE)
       {
-        SegmentLCD_Symbol(LCD_SYMBOL_PAD0, 1);
-        SegmentLCD_Symbol(LCD_SYMBOL_PAD1, 1);
+        LCDFB_Symbol(LCD_SYMBOL_PAD0, 1);
+        LCDFB_Symbol(LCD_SYMBOL_PAD1, 1);
       }
       for (i = 0; i < 8; i++)
       {
-        SegmentLCD_Number(numberOfIterations + i);
-        SegmentLCD_ARing(i, 1);
+        LCDFB_Number(numberOfIterations + i);
+        LCDFB_ARing(i, 1);
         EM2Sleep(20);
       }
       for (i = 0; i < 8; i++)
       {
-        SegmentLCD_Number(numberOfIterations + i);
-        SegmentLCD_ARing(i, 0);
+        LCDFB_Number(numberOfIterations + i);
+        LCDFB_ARing(i, 0);
         EM2Sleep(100);
       }
 
       for (i = 0; i < 5; i++)
       {
-        SegmentLCD_Number(numberOfIterations + i);
-        SegmentLCD_Battery(i);
-        SegmentLCD_EnergyMode(i, 1);
+        LCDFB_Number(numberOfIterations + i);
+        LCDFB_Battery(i);
+        LCDFB_EnergyMode(i, 1);
         EM2Sleep(100);
-        SegmentLCD_EnergyMode(i, 0);
+        LCDFB_EnergyMode(i, 0);
         EM2Sleep(100);
       }
-      SegmentLCD_Symbol(LCD_SYMBOL_ANT, 1);
+      LCDFB_Symbol(LCD_SYMBOL_ANT, 1);
       for (i = 0; i < 4; i++)
       {
-        SegmentLCD_EnergyMode(i, 1);
+        LCDFB_EnergyMode(i, 1);
         EM2Sleep(100);
       }
-      SegmentLCD_Symbol(LCD_SYMBOL_ANT, 0);
-      SegmentLCD_Battery(0);
+      LCDFB_Symbol(LCD_SYMBOL_ANT, 0);
+      LCDFB_Battery(0);
     }
     /* Energy Modes */
-    SegmentLCD_NumberOff();
-    SegmentLCD_Symbol(LCD_SYMBOL_GECKO, 1);
-    SegmentLCD_Symbol(LCD_SYMBOL_EFM32, 1);
+    LCDFB_NumberOff();
+    LCDFB_Symbol(LCD_SYMBOL_GECKO, 1);
+    LCDFB_Symbol(LCD_SYMBOL_EFM32, 1);
     if ((emMode != DEMO_MODE_EM3) && (emMode != DEMO_MODE_EM4))
     {
       ScrollText("Energy Mode demo, Press PB0 for EM3 or PB1 for EM4       ");
     }
-    SegmentLCD_Write("  EM0  ");
-    SegmentLCD_Number(0);
-    SegmentLCD_EnergyMode(0, 1);
-    SegmentLCD_EnergyMode(1, 1);
-    SegmentLCD_EnergyMode(2, 1);
-    SegmentLCD_EnergyMode(3, 1);
-    SegmentLCD_EnergyMode(4, 1);
+    LCDFB_Write("  EM0  ");
+    LCDFB_Number(0);
+    LCDFB_EnergyMode(0, 1);
+    LCDFB_EnergyMode(1, 1);
+    LCDFB_EnergyMode(2, 1);
+    LCDFB_EnergyMode(3, 1);
+    LCDFB_EnergyMode(4, 1);
+    LCDFB_Update();
     RTCDRV_Delay(4000, false);
-    SegmentLCD_Write("  EM1  ");
-    SegmentLCD_Number(1111);
-    SegmentLCD_EnergyMode(0, 0);
+    LCDFB_Write("  EM1  ");
+    LCDFB_Number(1111);
+    LCDFB_EnergyMode(0, 0);
     EM1Sleep(4000);
-    SegmentLCD_Write("  EM2  ");
-    SegmentLCD_Number(2222);
-    SegmentLCD_EnergyMode(1, 0);
+    LCDFB_Write("  EM2  ");
+    LCDFB_Number(2222);
+    LCDFB_EnergyMode(1, 0);
     EM2Sleep(4000);
 
     /* Check if somebody has pressed one of the buttons */
     if (emMode == DEMO_MODE_EM3)
     {
       ScrollText("Going down to EM3, press PB0 to wake up    ");
-      SegmentLCD_Write("  EM3  ");
-      SegmentLCD_Number(3333);
+      LCDFB_Write("  EM3  ");
+      LCDFB_Number(3333);
+      LCDFB_Update();
       RTCDRV_Delay(1000, false);
 
       /* Wake up on GPIO interrupt */
       EM3Sleep();
-      SegmentLCD_Number(0000);
-      SegmentLCD_Write("--EM0--");
+      LCDFB_Number(0000);
+      LCDFB_Write("--EM0--");
+      LCDFB_Update();
       RTCDRV_Delay(500, false);
-      SegmentLCD_Symbol(LCD_SYMBOL_PAD0, 0);
-      SegmentLCD_Symbol(LCD_SYMBOL_PAD1, 0);
+      LCDFB_Symbol(LCD_SYMBOL_PAD0, 0);
+      LCDFB_Symbol(LCD_SYMBOL_PAD1, 0);
       emMode = DEMO_MODE_NONE;
     }
     /* Check if somebody's joystick down */
     if (emMode == DEMO_MODE_EM4)
     {
       ScrollText("Going down to EM4, press reset to restart    ");
-      SegmentLCD_Write("  EM4  ");
-      SegmentLCD_Number(4444);
+      LCDFB_Write("  EM4  ");
+      LCDFB_Number(4444);
+      LCDFB_Update();
       RTCDRV_Delay(1000, false);
 
       /* Wake up on reset */
       EM4Sleep();
     }
-    SegmentLCD_EnergyMode(0, 0);
-    SegmentLCD_EnergyMode(1, 0);
-    SegmentLCD_EnergyMode(2, 0);
-    SegmentLCD_EnergyMode(3, 0);
-    SegmentLCD_EnergyMode(4, 0);
+    LCDFB_EnergyMode(0, 0);
+    LCDFB_EnergyMode(1, 0);
+    LCDFB_EnergyMode(2, 0);
+    LCDFB_EnergyMode(3, 0);
+    LCDFB_EnergyMode(4, 0);
 
     /* Scrolltext */
     ScrollText(stext);
@@ -0,0 +1,562 @@
+/***************************************************************************//**
+ * @file
+ * @brief Timer triggered ADC sampling with a DMA ring buffer.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stddef.h>
+
+#if defined(ADCPIPE_HOST)
+#include "pipesim.h"      /* Host build, see host/readme.txt */
+#else
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_adc.h"
+#include "em_cmu.h"
+#include "em_dma.h"
+#include "em_prs.h"
+#include "em_timer.h"
+#include "dmactrl.h"
+#endif
+
+#include "adcpipe.h"
+
+/***************************************************************************//**
+ * @addtogroup ADCPIPE
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/* Slot of a block in the ring, from its sequence number. */
+#define ADCPIPE_SLOT(block)      ((block) & (ADCPIPE_RING_BLOCKS - 1))
+
+/* SINGLECTRL fields set for every input. */
+#define ADCPIPE_INPUT_MASK       (_ADC_SINGLECTRL_INPUTSEL_MASK | _ADC_SINGLECTRL_REF_MASK)
+
+/* Sequence numbers wrap around, so the ring must be a power of 2. Two blocks
+   are in the DMA descriptors, so at least 4 are needed to process one. */
+typedef char adcpipeRingCheck[((ADCPIPE_RING_BLOCKS >= 4) &&
+                               ((ADCPIPE_RING_BLOCKS & (ADCPIPE_RING_BLOCKS - 1)) == 0))
+                              ? 1 : -1];
+
+/** @endcond */
+
+/*******************************************************************************
+ *******************************   STATICS   ***********************************
+ ******************************************************************************/
+
+/* Ring buffer, and the input of the block in every slot. */
+static uint16_t ring[ADCPIPE_RING_BLOCKS][ADCPIPE_BLOCK_SAMPLES];
+static uint8_t  ringInput[ADCPIPE_RING_BLOCKS];
+static bool     ringMixed[ADCPIPE_RING_BLOCKS];
+
+/* Sequence numbers of blocks. Blocks before blockTail are processed, blocks
+   before blockHead are full, and blocks before blockNext are set up in a DMA
+   descriptor. */
+static volatile uint32_t blockTail;
+static volatile uint32_t blockHead;
+static uint32_t          blockNext;
+
+/* Blocks of the run still to set up, unless it is continuous. */
+static uint32_t blocksLeft;
+static bool     continuous;
+
+/* True from ADCPIPE_Start() until the last block is full. */
+static volatile bool running;
+
+/* SINGLECTRL input and reference of every input, and the input of the next
+   block set up. */
+static uint32_t inputCtrl[ADCPIPE_MAX_INPUTS];
+static int      inputCount;
+static int      inputNext;
+
+/* Samples of every input since the last ADCPIPE_Read(). */
+static uint32_t sampleSum[ADCPIPE_MAX_INPUTS];
+static uint32_t sampleCount[ADCPIPE_MAX_INPUTS];
+
+static ADCPIPE_Stats_TypeDef blockStats;
+
+static DMA_CB_TypeDef dmaCallback;
+
+/*******************************************************************************
+ **************************   LOCAL FUNCTIONS   ********************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Take the next slot of the ring for a block of the next input.
+ *
+ * @details
+ *   If the slot still holds a full block which is not processed, that block
+ *   is discarded. Must be called with interrupts disabled.
+ *
+ * @return
+ *   Slot of the block.
+ ******************************************************************************/
+static uint32_t blockSetup(void)
+{
+  uint32_t slot = ADCPIPE_SLOT(blockNext);
+
+  if ((blockNext - blockTail) >= ADCPIPE_RING_BLOCKS)
+  {
+    blockTail++;
+    blockStats.overrun++;
+  }
+
+  ringInput[slot] = (uint8_t)inputNext;
+  ringMixed[slot] = false;
+  if (++inputNext == inputCount)
+  {
+    inputNext = 0;
+  }
+
+  blockNext++;
+  if (!continuous)
+  {
+    blocksLeft--;
+  }
+  return slot;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Select the ADC input of a block.
+ *
+ * @param[in] slot
+ *   Slot of the block.
+ ******************************************************************************/
+static void inputSelect(uint32_t slot)
+{
+  ADC0->SINGLECTRL = (ADC0->SINGLECTRL & ~ADCPIPE_INPUT_MASK)
+                     | inputCtrl[ringInput[slot]];
+}
+
+/***************************************************************************//**
+ * @brief
+ *   DMA callback at the end of a block.
+ *
+ * @details
+ *   The DMA has already switched to the other descriptor, and the next
+ *   conversion is the first of the next block. The ADC is switched to the
+ *   input of that block, and the completed descriptor is set up for the
+ *   block after it.
+ *
+ * @param[in] channel
+ *   DMA channel.
+ *
+ * @param[in] primary
+ *   True if the primary descriptor completed.
+ *
+ * @param[in] user
+ *   Not used.
+ ******************************************************************************/
+static void blockDone(unsigned int channel, bool primary, void *user)
+{
+  DMA_DESCRIPTOR_TypeDef *next;
+  uint32_t               slot;
+  uint32_t               left;
+
+  (void)user;
+
+  blockHead++;
+  blockStats.blocks++;
+
+  if (blockHead == blockNext)
+  {
+    /* Last block of the run */
+    TIMER_Enable(TIMER0, false);
+    running = false;
+    return;
+  }
+
+  slot = ADCPIPE_SLOT(blockHead);
+  inputSelect(slot);
+
+  /* A conversion started before the input was switched belongs to the old
+     input. The input is switched before the check, so a conversion starting
+     right after the switch may discard a good block, never keep a mixed one. */
+  if (primary)
+  {
+    next = ((DMA_DESCRIPTOR_TypeDef *)DMA->ALTCTRLBASE) + channel;
+  }
+  else
+  {
+    next = ((DMA_DESCRIPTOR_TypeDef *)DMA->CTRLBASE) + channel;
+  }
+  left = ((next->CTRL & _DMA_CTRL_N_MINUS_1_MASK) >> _DMA_CTRL_N_MINUS_1_SHIFT) + 1;
+  if ((left != ADCPIPE_BLOCK_SAMPLES) || (ADC0->STATUS & ADC_STATUS_SINGLEACT))
+  {
+    ringMixed[slot] = true;
+  }
+
+  if (continuous || (blocksLeft > 0))
+  {
+    slot = blockSetup();
+    DMA_RefreshPingPong(channel, primary, false, ring[slot], NULL,
+                        ADCPIPE_BLOCK_SAMPLES - 1,
+                        !continuous && (blocksLeft == 0));
+  }
+}
+
+/*******************************************************************************
+ **************************   GLOBAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Initialize the ADC, TIMER0, PRS and DMA for sampling.
+ *
+ * @param[in] inputs
+ *   Inputs, sampled in this order, copied.
+ *
+ * @param[in] count
+ *   Number of inputs, at most ADCPIPE_MAX_INPUTS.
+ *
+ * @param[in] rate
+ *   Samples per second.
+ ******************************************************************************/
+void ADCPIPE_Init(const ADCPIPE_Input_TypeDef *inputs, int count, uint32_t rate)
+{
+  ADC_Init_TypeDef       adcInit    = ADC_INIT_DEFAULT;
+  ADC_InitSingle_TypeDef singleInit = ADC_INITSINGLE_DEFAULT;
+  TIMER_Init_TypeDef     timerInit  = TIMER_INIT_DEFAULT;
+  DMA_Init_TypeDef       dmaInit;
+  DMA_CfgChannel_TypeDef channelCfg;
+  DMA_CfgDescr_TypeDef   descrCfg;
+  uint32_t               freq;
+  uint32_t               presc;
+  int                    i;
+
+  EFM_ASSERT((count > 0) && (count <= ADCPIPE_MAX_INPUTS));
+  EFM_ASSERT(rate > 0);
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_ADC0, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_DMA, true);
+
+  for (i = 0; i < count; i++)
+  {
+    inputCtrl[i] = ((uint32_t)inputs[i].input << _ADC_SINGLECTRL_INPUTSEL_SHIFT)
+                   | ((uint32_t)inputs[i].reference << _ADC_SINGLECTRL_REF_SHIFT);
+    sampleSum[i]   = 0;
+    sampleCount[i] = 0;
+  }
+  inputCount = count;
+  inputNext  = 0;
+
+  blockTail          = 0;
+  blockHead          = 0;
+  blockNext          = 0;
+  running            = false;
+  blockStats.blocks  = 0;
+  blockStats.mixed   = 0;
+  blockStats.overrun = 0;
+
+  /* Oversampled single conversions, started by PRS */
+  adcInit.ovsRateSel = ADCPIPE_OVS_RATE;
+  adcInit.timebase   = ADC_TimebaseCalc(0);
+  adcInit.prescale   = ADC_PrescaleCalc(ADCPIPE_ADC_FREQ, 0);
+  ADC_Init(ADC0, &adcInit);
+
+  singleInit.prsSel     = (ADC_PRSSEL_TypeDef)ADCPIPE_PRS_CHANNEL;
+  singleInit.prsEnable  = true;
+  singleInit.acqTime    = ADCPIPE_ACQ_TIME;
+  singleInit.resolution = adcResOVS;
+  singleInit.input      = inputs[0].input;
+  singleInit.reference  = inputs[0].reference;
+  ADC_InitSingle(ADC0, &singleInit);
+
+  /* TIMER0 overflow pulses on the PRS channel */
+  PRS_SourceSignalSet(ADCPIPE_PRS_CHANNEL,
+                      PRS_CH_CTRL_SOURCESEL_TIMER0,
+                      PRS_CH_CTRL_SIGSEL_TIMER0OF,
+                      prsEdgeOff);
+
+  /* Prescale HFPERCLK until the period fits the 16 bit counter */
+  freq  = CMU_ClockFreqGet(cmuClock_HFPER);
+  presc = 0;
+  while (((freq >> presc) / rate > 0x10000) && (presc < timerPrescale1024))
+  {
+    presc++;
+  }
+  EFM_ASSERT((freq >> presc) / rate >= 2);
+
+  timerInit.enable   = false;
+  timerInit.prescale = (TIMER_Prescale_TypeDef)presc;
+  TIMER_Init(TIMER0, &timerInit);
+  TIMER_TopSet(TIMER0, (freq >> presc) / rate - 1);
+
+  /* Half words from SINGLEDATA to the ring, ping-pong between blocks */
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  dmaCallback.cbFunc  = blockDone;
+  dmaCallback.userPtr = NULL;
+
+  channelCfg.highPri   = false;
+  channelCfg.enableInt = true;
+  channelCfg.select    = DMAREQ_ADC0_SINGLE;
+  channelCfg.cb        = &dmaCallback;
+  DMA_CfgChannel(ADCPIPE_DMA_CHANNEL, &channelCfg);
+
+  descrCfg.dstInc  = dmaDataInc2;
+  descrCfg.srcInc  = dmaDataIncNone;
+  descrCfg.size    = dmaDataSize2;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(ADCPIPE_DMA_CHANNEL, true, &descrCfg);
+  DMA_CfgDescr(ADCPIPE_DMA_CHANNEL, false, &descrCfg);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start sampling.
+ *
+ * @details
+ *   The first block is of the first input, and the first sample is taken
+ *   one sample period after the start.
+ *
+ * @param[in] blocks
+ *   Blocks to sample, 0 to sample until ADCPIPE_Stop().
+ ******************************************************************************/
+void ADCPIPE_Start(uint32_t blocks)
+{
+  void     *src = (void *)&ADC0->SINGLEDATA;
+  uint32_t primask;
+  uint32_t first;
+  uint32_t second;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  EFM_ASSERT(!running);
+
+  continuous = (blocks == 0);
+  blocksLeft = blocks;
+  inputNext  = 0;
+
+  /* Drop a conversion started after the end of the last run, before the
+     DMA request is enabled */
+  ADC0->CMD = ADC_CMD_SINGLESTOP;
+  (void)ADC0->SINGLEDATA;
+
+  first = blockSetup();
+  inputSelect(first);
+
+  if (blocks == 1)
+  {
+    DMA_ActivateBasic(ADCPIPE_DMA_CHANNEL, true, false, ring[first],
+                      src, ADCPIPE_BLOCK_SAMPLES - 1);
+  }
+  else
+  {
+    second = blockSetup();
+    DMA_ActivatePingPong(ADCPIPE_DMA_CHANNEL, false,
+                         ring[first], src, ADCPIPE_BLOCK_SAMPLES - 1,
+                         ring[second], src, ADCPIPE_BLOCK_SAMPLES - 1);
+    if (!continuous && (blocksLeft == 0))
+    {
+      /* Stop after the alternate block */
+      DMA_RefreshPingPong(ADCPIPE_DMA_CHANNEL, false, false, NULL, NULL,
+                          ADCPIPE_BLOCK_SAMPLES - 1, true);
+    }
+  }
+
+  running = true;
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_Enable(TIMER0, true);
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop sampling.
+ *
+ * @details
+ *   Blocks which are not full are dropped. Full blocks are kept for
+ *   ADCPIPE_Process().
+ ******************************************************************************/
+void ADCPIPE_Stop(void)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  TIMER_Enable(TIMER0, false);
+  DMA_ChannelEnable(ADCPIPE_DMA_CHANNEL, false);
+
+  /* A block completed with interrupts disabled is dropped as well */
+  DMA->IFC  = 1 << ADCPIPE_DMA_CHANNEL;
+  blockNext = blockHead;
+  running   = false;
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check if sampling, which needs EM1.
+ *
+ * @return
+ *   True from ADCPIPE_Start() until the last block is full.
+ ******************************************************************************/
+bool ADCPIPE_Busy(void)
+{
+  return running;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check for full blocks to process.
+ *
+ * @return
+ *   True if ADCPIPE_Process() has work to do.
+ ******************************************************************************/
+bool ADCPIPE_Pending(void)
+{
+  return blockTail != blockHead;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Average the full blocks, and add them to the samples of their input.
+ *
+ * @details
+ *   Call from the main loop when ADCPIPE_Pending(), at the latest before
+ *   the DMA has filled ADCPIPE_RING_BLOCKS - 2 more blocks.
+ ******************************************************************************/
+void ADCPIPE_Process(void)
+{
+  uint32_t block;
+  uint32_t slot;
+  uint32_t sum;
+  uint32_t primask;
+  int      input;
+  bool     mixed;
+  bool     taken;
+  int      i;
+
+  while (blockTail != blockHead)
+  {
+    block = blockTail;
+    slot  = ADCPIPE_SLOT(block);
+
+    sum = 0;
+    for (i = 0; i < ADCPIPE_BLOCK_SAMPLES; i++)
+    {
+      sum += ring[slot][i];
+    }
+
+    /* The block is only valid if it was not discarded while summing */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    taken = (blockTail == block);
+    input = ringInput[slot];
+    mixed = ringMixed[slot];
+    if (taken)
+    {
+      blockTail = block + 1;
+      if (mixed)
+      {
+        blockStats.mixed++;
+      }
+    }
+    __set_PRIMASK(primask);
+
+    if (taken && !mixed)
+    {
+      EFM_ASSERT(sampleCount[input] <= 0x10000 - ADCPIPE_BLOCK_SAMPLES);
+      sampleSum[input]   += sum;
+      sampleCount[input] += ADCPIPE_BLOCK_SAMPLES;
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Read the average of the samples of an input since the last read.
+ *
+ * @details
+ *   Must be called at least once every 65536 samples of the input.
+ *
+ * @param[in] input
+ *   Index of the input in the table given to ADCPIPE_Init().
+ *
+ * @param[out] result
+ *   Average and number of samples.
+ *
+ * @return
+ *   false if there are no samples.
+ ******************************************************************************/
+bool ADCPIPE_Read(int input, ADCPIPE_Result_TypeDef *result)
+{
+  uint32_t count;
+
+  EFM_ASSERT((input >= 0) && (input < inputCount));
+
+  count           = sampleCount[input];
+  result->samples = count;
+  result->average = (count > 0) ? (sampleSum[input] + count / 2) / count : 0;
+
+  sampleSum[input]   = 0;
+  sampleCount[input] = 0;
+
+  return count > 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the block statistics.
+ *
+ * @param[out] stats
+ *   Blocks since ADCPIPE_Init().
+ ******************************************************************************/
+void ADCPIPE_StatsGet(ADCPIPE_Stats_TypeDef *stats)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  *stats = blockStats;
+  __set_PRIMASK(primask);
+}
+
+/** @} (end addtogroup ADCPIPE) */
@@ -0,0 +1,173 @@
+/***************************************************************************//**
+ * @file
+ * @brief Timer triggered ADC sampling with a DMA ring buffer.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __ADCPIPE_H
+#define __ADCPIPE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(ADCPIPE_HOST)
+#include "pipesim.h"      /* Host build, see host/readme.txt */
+#else
+#include "em_adc.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup ADCPIPE
+ * @brief Timer triggered ADC sampling of several inputs, with a DMA ring
+ *   buffer.
+ * @details
+ *   TIMER0 overflows at the sample rate and starts an ADC0 single conversion
+ *   through PRS channel ADCPIPE_PRS_CHANNEL, without the CPU. The ADC
+ *   oversamples every conversion ADCPIPE_OVS_RATE times in hardware, giving
+ *   16 bit samples, 12 bit with 4 fraction bits. DMA channel
+ *   ADCPIPE_DMA_CHANNEL moves the samples to a ring of ADCPIPE_RING_BLOCKS
+ *   blocks of ADCPIPE_BLOCK_SAMPLES samples, alternating between the
+ *   primary and the alternate descriptor (ping-pong).
+ *
+ *   Every block holds the samples of one input, and the inputs are sampled
+ *   in turn, one block each. The only interrupt is the DMA interrupt at the
+ *   end of a block, which switches the ADC to the input of the next block.
+ *   If a conversion of the next block has started before, the block holds
+ *   samples of two inputs and is discarded.
+ *
+ *   ADCPIPE_Process() averages the full blocks, outside of the interrupt,
+ *   and accumulates the averages of every input until ADCPIPE_Read(). A
+ *   block not processed before the ring wraps around is discarded.
+ *
+ *   Sampling runs for a number of blocks or until stopped. The timer, ADC
+ *   and DMA need EM1 while sampling, see ADCPIPE_Busy().
+ *
+ *   ADCPIPE_Init() initializes the DMA controller with the control block of
+ *   dmactrl.c.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ ****************************   CONFIGURATION   ********************************
+ ******************************************************************************/
+
+/** Samples per block, averaged together. */
+#ifndef ADCPIPE_BLOCK_SAMPLES
+#define ADCPIPE_BLOCK_SAMPLES    16
+#endif
+
+/** Blocks in the ring buffer, a power of 2, at least 2. */
+#ifndef ADCPIPE_RING_BLOCKS
+#define ADCPIPE_RING_BLOCKS      4
+#endif
+
+/** Maximum number of inputs. */
+#ifndef ADCPIPE_MAX_INPUTS
+#define ADCPIPE_MAX_INPUTS       4
+#endif
+
+/** DMA channel. */
+#ifndef ADCPIPE_DMA_CHANNEL
+#define ADCPIPE_DMA_CHANNEL      0
+#endif
+
+/** PRS channel from TIMER0 to the ADC. */
+#ifndef ADCPIPE_PRS_CHANNEL
+#define ADCPIPE_PRS_CHANNEL      0
+#endif
+
+/** ADC clock frequency. */
+#ifndef ADCPIPE_ADC_FREQ
+#define ADCPIPE_ADC_FREQ         2000000
+#endif
+
+/** Hardware oversampling rate, for 16 bit samples. A conversion takes
+ *  16 * (acquisition time + 13) ADC clock cycles, which must be shorter
+ *  than a sample period. */
+#ifndef ADCPIPE_OVS_RATE
+#define ADCPIPE_OVS_RATE         adcOvsRateSel16
+#endif
+
+/** Acquisition time, in ADC clock cycles. */
+#ifndef ADCPIPE_ACQ_TIME
+#define ADCPIPE_ACQ_TIME         adcAcqTime16
+#endif
+
+/*******************************************************************************
+ ******************************   TYPEDEFS   ***********************************
+ ******************************************************************************/
+
+/** Input sampled by the pipeline. */
+typedef struct
+{
+  ADC_SingleInput_TypeDef input;      /**< ADC input.                       */
+  ADC_Ref_TypeDef         reference;  /**< Reference of the input.          */
+} ADCPIPE_Input_TypeDef;
+
+/** Samples of an input since the last ADCPIPE_Read(). */
+typedef struct
+{
+  uint32_t average;    /**< Average, 16 bit, 12 bit with 4 fraction bits.   */
+  uint32_t samples;    /**< Samples in the average.                         */
+} ADCPIPE_Result_TypeDef;
+
+/** Blocks since ADCPIPE_Init(). */
+typedef struct
+{
+  uint32_t blocks;     /**< Full blocks.                                    */
+  uint32_t mixed;      /**< Blocks discarded with samples of two inputs.    */
+  uint32_t overrun;    /**< Blocks discarded before they were processed.    */
+} ADCPIPE_Stats_TypeDef;
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+void ADCPIPE_Init(const ADCPIPE_Input_TypeDef *inputs, int count, uint32_t rate);
+void ADCPIPE_Start(uint32_t blocks);
+void ADCPIPE_Stop(void);
+bool ADCPIPE_Busy(void);
+bool ADCPIPE_Pending(void);
+void ADCPIPE_Process(void);
+bool ADCPIPE_Read(int input, ADCPIPE_Result_TypeDef *result);
+void ADCPIPE_StatsGet(ADCPIPE_Stats_TypeDef *stats);
+
+/** @} (end addtogroup ADCPIPE) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADCPIPE_H */
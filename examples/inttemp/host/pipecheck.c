@@ -0,0 +1,277 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the ADC sampling pipeline of the inttemp example.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "pipesim.h"
+#include "adcpipe.h"
+
+/******************************************************************************
+ * adcpipe.c is run on the simulation of pipesim.c, with a constant sample
+ * on every input, so the average of a block with samples of two inputs is
+ * never exact. Every scenario checks that all averages are exact, and that
+ * every full block is either read or counted as mixed or overrun.
+ *****************************************************************************/
+
+/* Inputs of the inttemp example */
+static const ADCPIPE_Input_TypeDef inputs[] =
+{
+  { adcSingleInpTemp,    adcRef1V25 },
+  { adcSingleInpVDDDiv3, adcRef1V25 },
+  { adcSingleInpCh6,     adcRefVDD  }
+};
+
+#define INPUTS      ((int)(sizeof(inputs) / sizeof(inputs[0])))
+
+/* Sample rate */
+#define RATE        2000
+
+/* Blocks read, and blocks expected per input or -1 */
+static uint32_t blocksRead;
+static int      failures;
+
+
+/**************************************************************************//**
+ * @brief  Read all inputs and check the averages
+ *****************************************************************************/
+static void checkRead(const char *scenario, const int *expected)
+{
+  ADCPIPE_Result_TypeDef result;
+  int                    i;
+
+  ADCPIPE_Process();
+
+  for (i = 0; i < INPUTS; i++)
+  {
+    ADCPIPE_Read(i, &result);
+    if ((result.samples > 0) &&
+        (result.average != pipesimInputValue[inputs[i].input]))
+    {
+      printf("%s: input %d average %u, expected %u\n", scenario, i,
+             (unsigned)result.average,
+             (unsigned)pipesimInputValue[inputs[i].input]);
+      failures++;
+    }
+    if ((expected != NULL) &&
+        (result.samples != (uint32_t)expected[i] * ADCPIPE_BLOCK_SAMPLES))
+    {
+      printf("%s: input %d %u samples, expected %u\n", scenario, i,
+             (unsigned)result.samples,
+             (unsigned)(expected[i] * ADCPIPE_BLOCK_SAMPLES));
+      failures++;
+    }
+    blocksRead += result.samples / ADCPIPE_BLOCK_SAMPLES;
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Check that every full block is accounted for
+ *****************************************************************************/
+static void checkStats(const char *scenario)
+{
+  ADCPIPE_Stats_TypeDef stats;
+
+  ADCPIPE_StatsGet(&stats);
+  printf("%-22s %6u blocks, %4u mixed, %4u overrun\n", scenario,
+         (unsigned)stats.blocks, (unsigned)stats.mixed,
+         (unsigned)stats.overrun);
+
+  if (ADCPIPE_Busy() || ADCPIPE_Pending() ||
+      (stats.blocks != blocksRead + stats.mixed + stats.overrun))
+  {
+    printf("%s: blocks not accounted for\n", scenario);
+    failures++;
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Sample until the run is complete
+ *****************************************************************************/
+static void runComplete(void)
+{
+  int timeout = 1000000;
+
+  while (ADCPIPE_Busy() && (--timeout > 0))
+  {
+    PIPESIM_Sample(pipesimIrqOnTime);
+    if (ADCPIPE_Pending())
+    {
+      ADCPIPE_Process();
+    }
+  }
+  if (timeout == 0)
+  {
+    printf("run did not complete\n");
+    failures++;
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Start and reset the statistics
+ *****************************************************************************/
+static void init(void)
+{
+  ADCPIPE_Init(inputs, INPUTS, RATE);
+  blocksRead = 0;
+}
+
+
+/**************************************************************************//**
+ * @brief  One block of every input every 250 ms, as the inttemp example,
+ *         and runs of fewer blocks than inputs
+ *****************************************************************************/
+static void checkRounds(void)
+{
+  static const int perRead[] = { 8, 8, 8 };
+  static const int one[]     = { 1, 0, 0 };
+  static const int two[]     = { 1, 1, 0 };
+  int              round;
+
+  init();
+  for (round = 0; round < 400; round++)
+  {
+    ADCPIPE_Start(INPUTS);
+    runComplete();
+    if ((round % 8) == 7)
+    {
+      checkRead("rounds", perRead);
+    }
+  }
+
+  ADCPIPE_Start(1);
+  runComplete();
+  checkRead("one block", one);
+
+  ADCPIPE_Start(2);
+  runComplete();
+  checkRead("two blocks", two);
+
+  checkStats("rounds");
+}
+
+
+/**************************************************************************//**
+ * @brief  Continuous sampling, with late interrupts and late processing
+ *****************************************************************************/
+static void checkContinuous(const char *scenario, PIPESIM_Irq_TypeDef late,
+                            int lateEvery, int processEvery)
+{
+  PIPESIM_Irq_TypeDef irq;
+  ADCPIPE_Stats_TypeDef stats;
+  int                 block;
+  int                 i;
+
+  init();
+  ADCPIPE_Start(0);
+
+  for (block = 0; block < 3000; block++)
+  {
+    irq = ((lateEvery > 0) && ((block % lateEvery) == lateEvery - 1))
+          ? late : pipesimIrqOnTime;
+    for (i = 0; i < ADCPIPE_BLOCK_SAMPLES; i++)
+    {
+      PIPESIM_Sample(irq);
+    }
+    if ((block % processEvery) == processEvery - 1)
+    {
+      ADCPIPE_Process();
+    }
+    if ((block % 100) == 99)
+    {
+      checkRead(scenario, NULL);
+    }
+  }
+
+  /* Stop in the middle of a block */
+  for (i = 0; i < ADCPIPE_BLOCK_SAMPLES / 2; i++)
+  {
+    PIPESIM_Sample(pipesimIrqOnTime);
+  }
+  ADCPIPE_Stop();
+  checkRead(scenario, NULL);
+  checkStats(scenario);
+
+  ADCPIPE_StatsGet(&stats);
+  if ((lateEvery > 0) && (stats.mixed != (uint32_t)(3000 / lateEvery)))
+  {
+    printf("%s: %u mixed blocks, expected %u\n", scenario,
+           (unsigned)stats.mixed, (unsigned)(3000 / lateEvery));
+    failures++;
+  }
+  if ((processEvery <= ADCPIPE_RING_BLOCKS - 2) && (stats.overrun > 0))
+  {
+    printf("%s: overrun, expected none\n", scenario);
+    failures++;
+  }
+  if ((processEvery > ADCPIPE_RING_BLOCKS) && (stats.overrun == 0))
+  {
+    printf("%s: no overrun, expected some\n", scenario);
+    failures++;
+  }
+
+  /* A run after the stop starts with the first input */
+  {
+    static const int expected[] = { 1, 1, 1 };
+
+    blocksRead = 0;
+    ADCPIPE_Start(INPUTS);
+    runComplete();
+    checkRead(scenario, expected);
+  }
+}
+
+
+int main(void)
+{
+  pipesimInputValue[adcSingleInpTemp]    = 30400;
+  pipesimInputValue[adcSingleInpVDDDiv3] = 42000;
+  pipesimInputValue[adcSingleInpCh6]     = 12345;
+
+  checkRounds();
+  checkContinuous("continuous", pipesimIrqOnTime, 0, 1);
+  checkContinuous("interrupt during next", pipesimIrqDuringNext, 7, 1);
+  checkContinuous("interrupt after next", pipesimIrqAfterNext, 11, 1);
+  checkContinuous("processing late", pipesimIrqOnTime, 0, 6);
+
+  if (PIPESIM_Failed())
+  {
+    failures++;
+  }
+
+  printf("%s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,405 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host simulation of the ADC, TIMER0 and DMA used by adcpipe.c.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "pipesim.h"
+
+/******************************************************************************
+ * Every PIPESIM_Sample() is one overflow of TIMER0: a conversion of the
+ * input selected in SINGLECTRL starts, completes, and the DMA moves the
+ * sample with the descriptor the controller is on, as the ping-pong mode of
+ * the DMA controller does. At the end of a block the done flag of the
+ * channel is set, and the interrupt is taken as em_dma.c does, before the
+ * next conversion, while it is active or after it.
+ *****************************************************************************/
+
+#define PIPESIM_CHANNELS    16
+
+/* Cycle types of a descriptor */
+#define PIPESIM_CYCLE_STOP      0
+#define PIPESIM_CYCLE_BASIC     1
+#define PIPESIM_CYCLE_PINGPONG  3
+
+uint32_t              pipesimPrimask;
+PIPESIM_ADC_TypeDef   pipesimAdc;
+PIPESIM_TIMER_TypeDef pipesimTimer;
+PIPESIM_DMA_TypeDef   pipesimDma;
+uint16_t              pipesimInputValue[16];
+
+/* Primary descriptors, followed by the alternate descriptors */
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[2 * PIPESIM_CHANNELS];
+
+/* State of the DMA channel, only one is simulated */
+static unsigned int        dmaChannel;
+static DMA_CB_TypeDef      *dmaCb;
+static bool                dmaEnabled;
+static bool                dmaOnAlt;
+static bool                dmaDone;
+static PIPESIM_Irq_TypeDef dmaIrq;
+
+static bool failed;
+
+
+static void fail(const char *what)
+{
+  if (!failed)
+  {
+    printf("simulation error: %s\n", what);
+  }
+  failed = true;
+}
+
+
+void ADC_Init(PIPESIM_ADC_TypeDef *adc, const ADC_Init_TypeDef *init)
+{
+  (void)init;
+  adc->STATUS = 0;
+}
+
+
+void ADC_InitSingle(PIPESIM_ADC_TypeDef *adc, const ADC_InitSingle_TypeDef *init)
+{
+  if (!init->prsEnable || (init->resolution != adcResOVS))
+  {
+    fail("ADC not in oversampling mode triggered by PRS");
+  }
+  adc->SINGLECTRL = ((uint32_t)init->input << _ADC_SINGLECTRL_INPUTSEL_SHIFT)
+                    | ((uint32_t)init->reference << _ADC_SINGLECTRL_REF_SHIFT);
+}
+
+
+uint8_t ADC_TimebaseCalc(uint32_t hfperFreq)
+{
+  (void)hfperFreq;
+  return 13;
+}
+
+
+uint8_t ADC_PrescaleCalc(uint32_t adcFreq, uint32_t hfperFreq)
+{
+  (void)hfperFreq;
+  return (uint8_t)(14000000 / adcFreq - 1);
+}
+
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable)
+{
+  (void)clock;
+  (void)enable;
+}
+
+
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock)
+{
+  (void)clock;
+  return 14000000;
+}
+
+
+void PRS_SourceSignalSet(unsigned int ch, uint32_t source, uint32_t signal,
+                         PRS_Edge_TypeDef edge)
+{
+  (void)ch;
+  if ((source != PRS_CH_CTRL_SOURCESEL_TIMER0) ||
+      (signal != PRS_CH_CTRL_SIGSEL_TIMER0OF) || (edge != prsEdgeOff))
+  {
+    fail("PRS source is not the TIMER0 overflow");
+  }
+}
+
+
+void TIMER_Init(PIPESIM_TIMER_TypeDef *timer, const TIMER_Init_TypeDef *init)
+{
+  timer->running  = init->enable;
+  timer->prescale = init->prescale;
+}
+
+
+void TIMER_TopSet(PIPESIM_TIMER_TypeDef *timer, uint32_t val)
+{
+  if (val > 0xFFFF)
+  {
+    fail("TIMER0 top does not fit 16 bits");
+  }
+  timer->top = val;
+}
+
+
+void TIMER_CounterSet(PIPESIM_TIMER_TypeDef *timer, uint32_t val)
+{
+  (void)timer;
+  (void)val;
+}
+
+
+void TIMER_Enable(PIPESIM_TIMER_TypeDef *timer, bool enable)
+{
+  timer->running = enable;
+}
+
+
+static DMA_DESCRIPTOR_TypeDef *dmaDescr(bool primary)
+{
+  return &dmaControlBlock[dmaChannel + (primary ? 0 : PIPESIM_CHANNELS)];
+}
+
+
+static void dmaDescrSet(bool primary, void *dst, unsigned int nMinus1, uint32_t cycle)
+{
+  DMA_DESCRIPTOR_TypeDef *descr = dmaDescr(primary);
+
+  if (dst != NULL)
+  {
+    descr->DSTEND = (uint16_t *)dst + nMinus1;
+  }
+  descr->CTRL = (nMinus1 << _DMA_CTRL_N_MINUS_1_SHIFT) | cycle;
+}
+
+
+void DMA_Init(DMA_Init_TypeDef *init)
+{
+  pipesimDma.CTRLBASE    = (uintptr_t)&init->controlBlock[0];
+  pipesimDma.ALTCTRLBASE = (uintptr_t)&init->controlBlock[PIPESIM_CHANNELS];
+  pipesimDma.IFC         = 0;
+  dmaEnabled = false;
+  dmaDone    = false;
+}
+
+
+void DMA_CfgChannel(unsigned int channel, DMA_CfgChannel_TypeDef *cfg)
+{
+  if (!cfg->enableInt || (cfg->select != DMAREQ_ADC0_SINGLE))
+  {
+    fail("DMA channel not requested by the ADC");
+  }
+  dmaChannel = channel;
+  dmaCb      = cfg->cb;
+}
+
+
+void DMA_CfgDescr(unsigned int channel, bool primary, DMA_CfgDescr_TypeDef *cfg)
+{
+  (void)channel;
+  (void)primary;
+  if ((cfg->size != dmaDataSize2) || (cfg->dstInc != dmaDataInc2) ||
+      (cfg->srcInc != dmaDataIncNone))
+  {
+    fail("DMA descriptor does not move half words to the ring");
+  }
+}
+
+
+void DMA_ActivateBasic(unsigned int channel, bool primary, bool useBurst,
+                       void *dst, void *src, unsigned int nMinus1)
+{
+  (void)channel;
+  (void)useBurst;
+  (void)src;
+  dmaDescrSet(primary, dst, nMinus1, PIPESIM_CYCLE_BASIC);
+  dmaOnAlt       = !primary;
+  dmaEnabled     = true;
+  dmaCb->primary = primary;
+}
+
+
+void DMA_ActivatePingPong(unsigned int channel, bool useBurst,
+                          void *primDst, void *primSrc, unsigned int primNMinus1,
+                          void *altDst, void *altSrc, unsigned int altNMinus1)
+{
+  (void)channel;
+  (void)useBurst;
+  (void)primSrc;
+  (void)altSrc;
+  dmaDescrSet(true, primDst, primNMinus1, PIPESIM_CYCLE_PINGPONG);
+  dmaDescrSet(false, altDst, altNMinus1, PIPESIM_CYCLE_PINGPONG);
+  dmaOnAlt       = false;
+  dmaEnabled     = true;
+  dmaCb->primary = true;
+}
+
+
+void DMA_RefreshPingPong(unsigned int channel, bool primary, bool useBurst,
+                         void *dst, void *src, unsigned int nMinus1, bool stop)
+{
+  (void)channel;
+  (void)useBurst;
+  (void)src;
+  if (dmaEnabled && (dmaOnAlt == !primary) &&
+      ((dmaDescr(primary)->CTRL & _DMA_CTRL_CYCLE_CTRL_MASK) != PIPESIM_CYCLE_STOP))
+  {
+    fail("refresh of the active descriptor");
+  }
+  dmaDescrSet(primary, dst, nMinus1,
+              stop ? PIPESIM_CYCLE_BASIC : PIPESIM_CYCLE_PINGPONG);
+}
+
+
+void DMA_ChannelEnable(unsigned int channel, bool enable)
+{
+  (void)channel;
+  dmaEnabled = enable;
+}
+
+
+/* The DMA interrupt handler of em_dma.c */
+static void dmaIrqTake(void)
+{
+  bool primary;
+
+  if (pipesimDma.IFC & (1UL << dmaChannel))
+  {
+    /* Cleared by ADCPIPE_Stop() */
+    pipesimDma.IFC = 0;
+    dmaDone        = false;
+    return;
+  }
+  if (!dmaDone || pipesimPrimask)
+  {
+    return;
+  }
+  dmaDone        = false;
+  primary        = dmaCb->primary;
+  dmaCb->primary = !primary;
+  dmaCb->cbFunc(dmaChannel, primary, dmaCb->userPtr);
+}
+
+
+/* Move a sample, returns true at the end of a block */
+static bool dmaTransfer(uint16_t sample)
+{
+  DMA_DESCRIPTOR_TypeDef *descr;
+  uint32_t               cycle;
+  uint32_t               left;
+
+  if (!dmaEnabled)
+  {
+    return false;
+  }
+
+  descr = dmaDescr(!dmaOnAlt);
+  cycle = descr->CTRL & _DMA_CTRL_CYCLE_CTRL_MASK;
+  if (cycle == PIPESIM_CYCLE_STOP)
+  {
+    fail("DMA request on a stopped descriptor");
+    return false;
+  }
+
+  left = (descr->CTRL & _DMA_CTRL_N_MINUS_1_MASK) >> _DMA_CTRL_N_MINUS_1_SHIFT;
+  *((uint16_t *)descr->DSTEND - left) = sample;
+  if (left > 0)
+  {
+    descr->CTRL -= 1UL << _DMA_CTRL_N_MINUS_1_SHIFT;
+    return false;
+  }
+
+  descr->CTRL = PIPESIM_CYCLE_STOP;
+  if (cycle == PIPESIM_CYCLE_PINGPONG)
+  {
+    dmaOnAlt = !dmaOnAlt;
+  }
+  else
+  {
+    dmaEnabled = false;
+  }
+
+  if (dmaDone)
+  {
+    fail("DMA interrupt of a block lost");
+  }
+  dmaDone        = true;
+  pipesimDma.IFC = 0;
+  return true;
+}
+
+
+/******************************************************************************
+ * @brief  One overflow of TIMER0, a conversion if running
+ * @param  irq  When the interrupt of a block completed by this conversion
+ *              is taken
+ *****************************************************************************/
+void PIPESIM_Sample(PIPESIM_Irq_TypeDef irq)
+{
+  uint32_t input;
+  bool     late;
+
+  if (!pipesimTimer.running)
+  {
+    return;
+  }
+
+  /* The input is sampled at the start of the conversion */
+  late  = dmaDone && (dmaIrq != pipesimIrqOnTime);
+  input = (pipesimAdc.SINGLECTRL & _ADC_SINGLECTRL_INPUTSEL_MASK)
+          >> _ADC_SINGLECTRL_INPUTSEL_SHIFT;
+  pipesimAdc.STATUS |= ADC_STATUS_SINGLEACT;
+
+  if (late && (dmaIrq == pipesimIrqDuringNext))
+  {
+    dmaIrqTake();
+    late = false;
+  }
+
+  pipesimAdc.STATUS    &= ~ADC_STATUS_SINGLEACT;
+  pipesimAdc.SINGLEDATA = pipesimInputValue[input];
+
+  if (late)
+  {
+    /* Taken after the next sample was moved */
+    dmaDone = false;
+    if (dmaTransfer((uint16_t)pipesimAdc.SINGLEDATA))
+    {
+      fail("DMA interrupt of a block lost");
+    }
+    dmaDone = true;
+    dmaIrqTake();
+    return;
+  }
+
+  if (dmaTransfer((uint16_t)pipesimAdc.SINGLEDATA))
+  {
+    dmaIrq = irq;
+    if (irq == pipesimIrqOnTime)
+    {
+      dmaIrqTake();
+    }
+  }
+}
+
+
+bool PIPESIM_Failed(void)
+{
+  return failed;
+}
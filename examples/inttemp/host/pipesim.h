@@ -0,0 +1,288 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host replacement of the device headers and emlib used by adcpipe.c.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __PIPESIM_H
+#define __PIPESIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Replaces em_assert.h */
+#define EFM_ASSERT(expr)    assert(expr)
+
+/* Interrupts are only taken in PIPESIM_Sample(), when not masked */
+extern uint32_t pipesimPrimask;
+
+static inline uint32_t __get_PRIMASK(void)
+{
+  return pipesimPrimask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+  pipesimPrimask = primask;
+}
+
+static inline void __disable_irq(void)
+{
+  pipesimPrimask = 1;
+}
+
+/* ADC registers and fields used by adcpipe.c, as in the EFM32GG device
+   headers */
+typedef struct
+{
+  uint32_t CMD;
+  uint32_t STATUS;
+  uint32_t SINGLECTRL;
+  uint32_t SINGLEDATA;
+} PIPESIM_ADC_TypeDef;
+
+extern PIPESIM_ADC_TypeDef pipesimAdc;
+
+#define ADC0                                 (&pipesimAdc)
+
+#define ADC_CMD_SINGLESTOP                   (0x1UL << 1)
+#define ADC_STATUS_SINGLEACT                 (0x1UL << 0)
+#define _ADC_SINGLECTRL_INPUTSEL_SHIFT       8
+#define _ADC_SINGLECTRL_INPUTSEL_MASK        0xF00UL
+#define _ADC_SINGLECTRL_REF_SHIFT            16
+#define _ADC_SINGLECTRL_REF_MASK             0x70000UL
+
+/* em_adc.h */
+typedef enum
+{
+  adcSingleInpCh6     = 6,
+  adcSingleInpCh7     = 7,
+  adcSingleInpTemp    = 8,
+  adcSingleInpVDDDiv3 = 9
+} ADC_SingleInput_TypeDef;
+
+typedef enum
+{
+  adcRef1V25 = 0,
+  adcRef2V5  = 1,
+  adcRefVDD  = 2
+} ADC_Ref_TypeDef;
+
+typedef enum { adcOvsRateSel16 = 3 }  ADC_OvsRateSel_TypeDef;
+typedef enum { adcAcqTime16 = 4 }     ADC_AcqTime_TypeDef;
+typedef enum { adcRes12Bit = 0, adcResOVS = 3 } ADC_Res_TypeDef;
+typedef enum { adcPRSSELCh0 = 0 }     ADC_PRSSEL_TypeDef;
+
+typedef struct
+{
+  ADC_OvsRateSel_TypeDef ovsRateSel;
+  uint8_t                timebase;
+  uint8_t                prescale;
+} ADC_Init_TypeDef;
+
+typedef struct
+{
+  ADC_PRSSEL_TypeDef      prsSel;
+  ADC_AcqTime_TypeDef     acqTime;
+  ADC_Ref_TypeDef         reference;
+  ADC_Res_TypeDef         resolution;
+  ADC_SingleInput_TypeDef input;
+  bool                    prsEnable;
+} ADC_InitSingle_TypeDef;
+
+#define ADC_INIT_DEFAULT        { adcOvsRateSel16, 1, 0 }
+#define ADC_INITSINGLE_DEFAULT  { adcPRSSELCh0, adcAcqTime16, adcRef1V25, \
+                                  adcRes12Bit, adcSingleInpCh6, false }
+
+void    ADC_Init(PIPESIM_ADC_TypeDef *adc, const ADC_Init_TypeDef *init);
+void    ADC_InitSingle(PIPESIM_ADC_TypeDef *adc, const ADC_InitSingle_TypeDef *init);
+uint8_t ADC_TimebaseCalc(uint32_t hfperFreq);
+uint8_t ADC_PrescaleCalc(uint32_t adcFreq, uint32_t hfperFreq);
+
+/* em_cmu.h */
+typedef enum
+{
+  cmuClock_HFPER,
+  cmuClock_ADC0,
+  cmuClock_TIMER0,
+  cmuClock_PRS,
+  cmuClock_DMA
+} CMU_Clock_TypeDef;
+
+void     CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock);
+
+/* em_prs.h */
+#define PRS_CH_CTRL_SOURCESEL_TIMER0         (0x1CUL << 16)
+#define PRS_CH_CTRL_SIGSEL_TIMER0OF          (0x0UL << 0)
+
+typedef enum { prsEdgeOff } PRS_Edge_TypeDef;
+
+void PRS_SourceSignalSet(unsigned int ch, uint32_t source, uint32_t signal,
+                         PRS_Edge_TypeDef edge);
+
+/* em_timer.h, the timer runs while enabled and is stepped by
+   PIPESIM_Sample() */
+typedef struct
+{
+  bool     running;
+  uint32_t top;
+  uint32_t prescale;
+} PIPESIM_TIMER_TypeDef;
+
+extern PIPESIM_TIMER_TypeDef pipesimTimer;
+
+#define TIMER0                               (&pipesimTimer)
+
+typedef enum
+{
+  timerPrescale1    = 0,
+  timerPrescale1024 = 10
+} TIMER_Prescale_TypeDef;
+
+typedef struct
+{
+  bool                   enable;
+  TIMER_Prescale_TypeDef prescale;
+} TIMER_Init_TypeDef;
+
+#define TIMER_INIT_DEFAULT  { true, timerPrescale1 }
+
+void TIMER_Init(PIPESIM_TIMER_TypeDef *timer, const TIMER_Init_TypeDef *init);
+void TIMER_TopSet(PIPESIM_TIMER_TypeDef *timer, uint32_t val);
+void TIMER_CounterSet(PIPESIM_TIMER_TypeDef *timer, uint32_t val);
+void TIMER_Enable(PIPESIM_TIMER_TypeDef *timer, bool enable);
+
+/* DMA descriptors and registers used by adcpipe.c. The control block is in
+   host memory, so the base registers hold pointers. */
+typedef struct
+{
+  void     *SRCEND;
+  void     *DSTEND;
+  uint32_t CTRL;
+  uint32_t USER;
+} DMA_DESCRIPTOR_TypeDef;
+
+typedef struct
+{
+  uintptr_t CTRLBASE;
+  uintptr_t ALTCTRLBASE;
+  uint32_t  IFC;
+} PIPESIM_DMA_TypeDef;
+
+extern PIPESIM_DMA_TypeDef pipesimDma;
+
+#define DMA                                  (&pipesimDma)
+
+#define _DMA_CTRL_CYCLE_CTRL_MASK            0x7UL
+#define _DMA_CTRL_N_MINUS_1_SHIFT            4
+#define _DMA_CTRL_N_MINUS_1_MASK             0x3FF0UL
+
+#define DMAREQ_ADC0_SINGLE                   0x080000UL
+
+/* em_dma.h */
+typedef void (*DMA_FuncPtr_TypeDef)(unsigned int channel, bool primary, void *user);
+
+typedef struct
+{
+  DMA_FuncPtr_TypeDef cbFunc;
+  void                *userPtr;
+  uint8_t             primary;
+} DMA_CB_TypeDef;
+
+typedef struct
+{
+  uint8_t                hprot;
+  DMA_DESCRIPTOR_TypeDef *controlBlock;
+} DMA_Init_TypeDef;
+
+typedef struct
+{
+  bool           highPri;
+  bool           enableInt;
+  uint32_t       select;
+  DMA_CB_TypeDef *cb;
+} DMA_CfgChannel_TypeDef;
+
+typedef enum { dmaDataInc2 = 1, dmaDataIncNone = 3 } DMA_DataInc_TypeDef;
+typedef enum { dmaDataSize2 = 1 }                    DMA_DataSize_TypeDef;
+typedef enum { dmaArbitrate1 = 0 }                   DMA_ArbiterConfig_TypeDef;
+
+typedef struct
+{
+  DMA_DataInc_TypeDef       dstInc;
+  DMA_DataInc_TypeDef       srcInc;
+  DMA_DataSize_TypeDef      size;
+  DMA_ArbiterConfig_TypeDef arbRate;
+  uint8_t                   hprot;
+} DMA_CfgDescr_TypeDef;
+
+extern DMA_DESCRIPTOR_TypeDef dmaControlBlock[];
+
+void DMA_Init(DMA_Init_TypeDef *init);
+void DMA_CfgChannel(unsigned int channel, DMA_CfgChannel_TypeDef *cfg);
+void DMA_CfgDescr(unsigned int channel, bool primary, DMA_CfgDescr_TypeDef *cfg);
+void DMA_ActivateBasic(unsigned int channel, bool primary, bool useBurst,
+                       void *dst, void *src, unsigned int nMinus1);
+void DMA_ActivatePingPong(unsigned int channel, bool useBurst,
+                          void *primDst, void *primSrc, unsigned int primNMinus1,
+                          void *altDst, void *altSrc, unsigned int altNMinus1);
+void DMA_RefreshPingPong(unsigned int channel, bool primary, bool useBurst,
+                         void *dst, void *src, unsigned int nMinus1, bool stop);
+void DMA_ChannelEnable(unsigned int channel, bool enable);
+
+/* Simulation */
+
+/* When the DMA interrupt of a full block is taken */
+typedef enum
+{
+  pipesimIrqOnTime,      /**< Before the next conversion.                  */
+  pipesimIrqDuringNext,  /**< While the next conversion is active.         */
+  pipesimIrqAfterNext    /**< After the next conversion completed.         */
+} PIPESIM_Irq_TypeDef;
+
+/* Sample of every ADC input, 16 bit */
+extern uint16_t pipesimInputValue[16];
+
+void PIPESIM_Sample(PIPESIM_Irq_TypeDef irq);
+bool PIPESIM_Failed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,249 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the fixed point temperature conversion
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "tempsim.h"
+#include "tempconv.h"
+
+/******************************************************************************
+ * TEMPCONV_CentiCelsius() and TEMPCONV_CentiFahrenheit() are compared with
+ * the floating point formula of the reference manual, computed in double
+ * precision, for every 12 bit sample and a grid of calibration values,
+ * without and with the rev. D errata offset. Both must be within 0.01
+ * degree. The single precision conversion the inttemp example used before
+ * is compared with the same formula, for reference.
+ *
+ * TEMPCONV_CentiCelsiusOvs() and TEMPCONV_CentiFahrenheitOvs() are compared
+ * in the same way, for every CHECK_OVS_STEP oversampled sample.
+ *
+ * TEMPCONV_Init() is checked to read the calibration from the device
+ * information page, and to apply the errata offset on product revision 16
+ * and 17 only.
+ *****************************************************************************/
+
+TEMPSIM_DevInfo_TypeDef tempsimDevInfo;
+
+/* Calibration grid */
+#define CHECK_TEMP_STEP     5
+#define CHECK_VALUE_MIN     256
+#define CHECK_VALUE_STEP    17
+
+/* Oversampled samples compared */
+#define CHECK_OVS_STEP      7
+#define CHECK_OVS_MAX       (4095UL << TEMPCONV_OVS_BITS)
+
+/* Largest error of the conversion, in hundredths of a degree */
+#define CHECK_MAX_ERROR     1.0
+
+/* Largest errors found */
+typedef struct
+{
+  double celsius;
+  double fahrenheit;
+  double celsiusOvs;
+  double fahrenheitOvs;
+} CheckError_TypeDef;
+
+
+/**************************************************************************//**
+ * @brief  The formula of the reference manual, in degrees Celsius
+ *****************************************************************************/
+static double refCelsius(uint32_t calTemp, uint32_t calValue, uint32_t offset,
+                         double sample)
+{
+  double celsius;
+
+  celsius = calTemp - ((double)calValue - (sample + offset)) / -6.27;
+  if (celsius < -273.15)
+  {
+    celsius = -273.15;
+  }
+  return celsius;
+}
+
+
+/**************************************************************************//**
+ * @brief  Single precision conversion of the inttemp example before
+ *         tempconv.c, with the offset added to the sample
+ *****************************************************************************/
+static float floatCelsius(uint32_t calTemp, uint32_t calValue, int32_t adcSample)
+{
+  float cal_temp_0  = (float)calTemp;
+  float cal_value_0 = (float)calValue;
+  float t_grad      = -6.27;
+
+  return cal_temp_0 - ((cal_value_0 - adcSample) / t_grad);
+}
+
+
+/**************************************************************************//**
+ * @brief  Compare one calibration for every sample
+ *****************************************************************************/
+static void checkCalibration(uint32_t calTemp, uint32_t calValue,
+                             uint32_t offset, CheckError_TypeDef *fixed,
+                             CheckError_TypeDef *single)
+{
+  double   celsius;
+  double   err;
+  uint32_t sample;
+
+  TEMPCONV_Calibrate(calTemp, calValue, offset);
+
+  for (sample = 0; sample < 4096; sample++)
+  {
+    celsius = refCelsius(calTemp, calValue, offset, sample);
+
+    err = fabs(TEMPCONV_CentiCelsius(sample) - celsius * 100);
+    if (err > fixed->celsius)
+    {
+      fixed->celsius = err;
+    }
+    err = fabs(TEMPCONV_CentiFahrenheit(sample) - (celsius * 1.8 + 32) * 100);
+    if (err > fixed->fahrenheit)
+    {
+      fixed->fahrenheit = err;
+    }
+
+    if (celsius > -273.15)
+    {
+      err = fabs(floatCelsius(calTemp, calValue, sample + offset) - celsius) * 100;
+      if (err > single->celsius)
+      {
+        single->celsius = err;
+      }
+    }
+  }
+
+  for (sample = 0; sample <= CHECK_OVS_MAX; sample += CHECK_OVS_STEP)
+  {
+    celsius = refCelsius(calTemp, calValue, offset,
+                         (double)sample / (1 << TEMPCONV_OVS_BITS));
+
+    err = fabs(TEMPCONV_CentiCelsiusOvs(sample) - celsius * 100);
+    if (err > fixed->celsiusOvs)
+    {
+      fixed->celsiusOvs = err;
+    }
+    err = fabs(TEMPCONV_CentiFahrenheitOvs(sample) - (celsius * 1.8 + 32) * 100);
+    if (err > fixed->fahrenheitOvs)
+    {
+      fixed->fahrenheitOvs = err;
+    }
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Check TEMPCONV_Init() with a device information page
+ *****************************************************************************/
+static int checkInit(uint32_t prodRev, uint32_t offset)
+{
+  const uint32_t calTemp  = 25;
+  const uint32_t calValue = 1900;
+  int32_t        celsius;
+  int32_t        fahrenheit;
+  uint32_t       sample;
+  int            failures = 0;
+
+  tempsimDevInfo.CAL      = 0xAA00FFFFUL | (calTemp << _DEVINFO_CAL_TEMP_SHIFT);
+  tempsimDevInfo.ADC0CAL2 = 0x000ABCDEUL | (calValue << _DEVINFO_ADC0CAL2_TEMP1V25_SHIFT);
+  tempsimDevInfo.PART     = 0x00FFFFFFUL | (prodRev << _DEVINFO_PART_PROD_REV_SHIFT);
+
+  for (sample = 0; sample < 4096; sample += 15)
+  {
+    TEMPCONV_Init();
+    celsius    = TEMPCONV_CentiCelsius(sample);
+    fahrenheit = TEMPCONV_CentiFahrenheit(sample);
+    TEMPCONV_Calibrate(calTemp, calValue, offset);
+    if ((celsius != TEMPCONV_CentiCelsius(sample)) ||
+        (fahrenheit != TEMPCONV_CentiFahrenheit(sample)))
+    {
+      failures++;
+    }
+  }
+
+  if (failures > 0)
+  {
+    printf("TEMPCONV_Init() with product revision %u differs\n",
+           (unsigned)prodRev);
+  }
+  return failures;
+}
+
+
+int main(void)
+{
+  CheckError_TypeDef fixed  = { 0, 0, 0, 0 };
+  CheckError_TypeDef single = { 0, 0, 0, 0 };
+  uint32_t           calTemp;
+  uint32_t           calValue;
+  uint32_t           calibrations = 0;
+  int                failures     = 0;
+
+  for (calTemp = 0; calTemp <= 255; calTemp += CHECK_TEMP_STEP)
+  {
+    for (calValue = CHECK_VALUE_MIN; calValue <= 4095; calValue += CHECK_VALUE_STEP)
+    {
+      checkCalibration(calTemp, calValue, 0, &fixed, &single);
+      checkCalibration(calTemp, calValue, TEMPCONV_REVD_OFFSET, &fixed, &single);
+      calibrations += 2;
+    }
+  }
+
+  printf("%u calibrations, 4096 samples each\n", (unsigned)calibrations);
+  printf("largest error, hundredths of a degree:\n");
+  printf("  TEMPCONV_CentiCelsius()        %.3f\n", fixed.celsius);
+  printf("  TEMPCONV_CentiFahrenheit()     %.3f\n", fixed.fahrenheit);
+  printf("  TEMPCONV_CentiCelsiusOvs()     %.3f\n", fixed.celsiusOvs);
+  printf("  TEMPCONV_CentiFahrenheitOvs()  %.3f\n", fixed.fahrenheitOvs);
+  printf("  single precision Celsius       %.3f\n", single.celsius);
+
+  if ((fixed.celsius >= CHECK_MAX_ERROR) || (fixed.fahrenheit >= CHECK_MAX_ERROR) ||
+      (fixed.celsiusOvs >= CHECK_MAX_ERROR) || (fixed.fahrenheitOvs >= CHECK_MAX_ERROR))
+  {
+    printf("conversion error too large\n");
+    failures++;
+  }
+
+  failures += checkInit(15, 0);
+  failures += checkInit(16, TEMPCONV_REVD_OFFSET);
+  failures += checkInit(17, TEMPCONV_REVD_OFFSET);
+  failures += checkInit(18, 0);
+
+  printf("%s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
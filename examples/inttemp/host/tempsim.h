@@ -0,0 +1,72 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host build support for the temperature conversion test
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __TEMPSIM_H
+#define __TEMPSIM_H
+
+#include <stdint.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Replaces em_assert.h */
+#define EFM_ASSERT(expr)    assert(expr)
+
+/* Device information page fields used by tempconv.c, as in the EFM32GG
+   device headers */
+typedef struct
+{
+  uint32_t CAL;
+  uint32_t ADC0CAL2;
+  uint32_t PART;
+} TEMPSIM_DevInfo_TypeDef;
+
+extern TEMPSIM_DevInfo_TypeDef tempsimDevInfo;
+
+#define DEVINFO                              (&tempsimDevInfo)
+
+#define _DEVINFO_CAL_TEMP_SHIFT              16
+#define _DEVINFO_CAL_TEMP_MASK               0xFF0000UL
+#define _DEVINFO_ADC0CAL2_TEMP1V25_SHIFT     20
+#define _DEVINFO_ADC0CAL2_TEMP1V25_MASK      0xFFF00000UL
+#define _DEVINFO_PART_PROD_REV_SHIFT         24
+#define _DEVINFO_PART_PROD_REV_MASK          0xFF000000UL
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
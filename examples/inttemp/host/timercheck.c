@@ -0,0 +1,374 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the multiplexed RTC timers.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "timersim.h"
+#include "rtctimer.h"
+
+/******************************************************************************
+ * rtctimer.c is run on the simulated RTC of timersim.c. Every callback is
+ * checked against the expiry computed from the start time of its timer:
+ * it must not be early, it must be at most the interrupt latency late, and
+ * the lateness recorded by the timer must be the measured one. A running
+ * timer which is not called back in time is missed. The lateness of all
+ * callbacks of a scenario is printed in RTC ticks.
+ *****************************************************************************/
+
+/* RTC ticks per second, LFRCO divided by 32 as in the inttemp example */
+#define FREQ           1024
+
+/* Periods of the inttemp example */
+#define SAMPLE_MS      250
+#define DISPLAY_MS     2000
+
+/* Timers of the random scenario */
+#define TIMERS         6
+
+/* Longest period of the random scenario, longer than the step of COMP0 */
+#define LONG_MS        5000000
+
+/* Counter value at start, a few seconds before the first wrap */
+#define COUNTER_START  (_RTC_CNT_MASK - 5000)
+
+/* Timer under test */
+typedef struct
+{
+  RTCTIMER_Timer_TypeDef timer;
+  bool                   running;   /* Started and not stopped            */
+  bool                   periodic;
+  uint32_t               ms;
+  uint64_t               start;     /* Tick the timer was started on      */
+  uint32_t               count;     /* Callbacks since the start          */
+  RTCTIMER_Stats_TypeDef measured;  /* Lateness measured since the start  */
+} Check_TypeDef;
+
+static Check_TypeDef checks[TIMERS];
+
+/* Lateness of all callbacks of a scenario */
+static RTCTIMER_Stats_TypeDef total;
+
+static uint32_t maxLatency;
+static bool     randomActions;
+static int      failures;
+
+
+/**************************************************************************//**
+ * @brief  Record a failure, the first few are printed
+ *****************************************************************************/
+static void fail(const char *what, int timer, uint32_t count)
+{
+  if (failures < 10)
+  {
+    printf("timer %d, callback %u: %s\n", timer, (unsigned)count, what);
+  }
+  failures++;
+}
+
+
+/**************************************************************************//**
+ * @brief  Tick of the next expiry of a timer
+ *****************************************************************************/
+static uint64_t checkDue(const Check_TypeDef *check)
+{
+  if (check->periodic)
+  {
+    return check->start
+           + (uint64_t)(check->count + 1) * check->ms * FREQ / 1000;
+  }
+  return check->start + ((uint64_t)check->ms * FREQ + 999) / 1000;
+}
+
+
+static void statsAdd(RTCTIMER_Stats_TypeDef *stats, uint32_t late)
+{
+  if ((stats->count == 0) || (late < stats->lateMin))
+  {
+    stats->lateMin = late;
+  }
+  if (late > stats->lateMax)
+  {
+    stats->lateMax = late;
+  }
+  stats->lateSum += late;
+  stats->count++;
+}
+
+
+static void checkCallback(void *user);
+
+
+static void checkStart(Check_TypeDef *check, uint32_t ms, bool periodic)
+{
+  check->running  = true;
+  check->periodic = periodic;
+  check->ms       = ms;
+  check->start    = TIMERSIM_Now();
+  check->count    = 0;
+  check->measured.count   = 0;
+  check->measured.lateMin = 0;
+  check->measured.lateMax = 0;
+  check->measured.lateSum = 0;
+  RTCTIMER_Start(&check->timer, ms, periodic, checkCallback, check);
+}
+
+
+static void checkStop(Check_TypeDef *check)
+{
+  if (RTCTIMER_Stop(&check->timer) != check->running)
+  {
+    fail("RTCTIMER_Stop() of a timer in the wrong state",
+         (int)(check - checks), check->count);
+  }
+  check->running = false;
+}
+
+
+/**************************************************************************//**
+ * @brief  Timer callback, checks the expiry and takes random actions
+ *****************************************************************************/
+static void checkCallback(void *user)
+{
+  Check_TypeDef          *check = user;
+  int                    id     = (int)(check - checks);
+  uint64_t               due    = checkDue(check);
+  uint64_t               now    = TIMERSIM_Now();
+  RTCTIMER_Stats_TypeDef stats;
+  uint32_t               late;
+
+  if (!check->running)
+  {
+    fail("called back when stopped", id, check->count);
+    return;
+  }
+  if (now < due)
+  {
+    fail("early", id, check->count);
+    return;
+  }
+
+  late = (uint32_t)(now - due);
+  if (late > maxLatency + 2)
+  {
+    fail("later than the interrupt latency", id, check->count);
+  }
+
+  statsAdd(&check->measured, late);
+  statsAdd(&total, late);
+  check->count++;
+  check->running = check->periodic;
+
+  RTCTIMER_StatsGet(&check->timer, &stats);
+  if ((stats.count != check->measured.count)
+      || (stats.lateMin != check->measured.lateMin)
+      || (stats.lateMax != check->measured.lateMax)
+      || (stats.lateSum != check->measured.lateSum))
+  {
+    fail("recorded lateness differs from the measured", id, check->count);
+  }
+
+  if (!randomActions || (id == 0))
+  {
+    return;
+  }
+
+  /* Restart a one-shot timer, restart a periodic one with a new period, or
+     stop any timer but the long one */
+  if (!check->periodic && (TIMERSIM_Random(2) == 0))
+  {
+    checkStart(check, TIMERSIM_Random(3000), false);
+  }
+  else if (check->periodic && (TIMERSIM_Random(100) == 0))
+  {
+    checkStart(check, 1 + TIMERSIM_Random(5000), true);
+  }
+  if (TIMERSIM_Random(200) == 0)
+  {
+    id = 1 + (int)TIMERSIM_Random(TIMERS - 1);
+    checkStop(&checks[id]);
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Check that no running timer is overdue
+ *****************************************************************************/
+static void checkMissed(int timers)
+{
+  int i;
+
+  for (i = 0; i < timers; i++)
+  {
+    if (checks[i].running
+        && (checkDue(&checks[i]) + maxLatency + 2 < TIMERSIM_Now()))
+    {
+      fail("missed", i, checks[i].count);
+      checks[i].running = false;
+    }
+    if (checks[i].running != RTCTIMER_Running(&checks[i].timer))
+    {
+      fail("running state differs", i, checks[i].count);
+      checks[i].running = RTCTIMER_Running(&checks[i].timer);
+    }
+  }
+}
+
+
+static void scenarioBegin(uint32_t latency, uint32_t seed)
+{
+  int i;
+
+  TIMERSIM_Init(COUNTER_START, latency, seed);
+  RTCTIMER_Init(cmuSelect_LFRCO, cmuClkDiv_32);
+
+  for (i = 0; i < TIMERS; i++)
+  {
+    /* Timers are not zero-initialized, as on the stack or heap */
+    memset(&checks[i].timer, 0xA5, sizeof(checks[i].timer));
+    checks[i].running = false;
+    RTCTIMER_TimerInit(&checks[i].timer);
+  }
+
+  maxLatency    = latency;
+  randomActions = false;
+  total.count   = 0;
+  total.lateMin = 0;
+  total.lateMax = 0;
+  total.lateSum = 0;
+}
+
+
+static void scenarioEnd(const char *scenario, int timers)
+{
+  int i;
+
+  checkMissed(timers);
+  printf("%-24s %8u %8u %8u %8.2f\n", scenario, (unsigned)total.count,
+         (unsigned)total.lateMin, (unsigned)total.lateMax,
+         total.count ? (double)total.lateSum / total.count : 0.0);
+
+  for (i = 0; i < timers; i++)
+  {
+    RTCTIMER_Stop(&checks[i].timer);
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  The two periodic timers of the inttemp example, for an hour
+ *****************************************************************************/
+static void scenarioInttemp(const char *scenario, uint32_t latency)
+{
+  uint32_t tick;
+
+  scenarioBegin(latency, 1);
+  checkStart(&checks[0], SAMPLE_MS, true);
+  checkStart(&checks[1], DISPLAY_MS, true);
+
+  for (tick = 0; tick < 3600 * FREQ; tick++)
+  {
+    TIMERSIM_Tick();
+    if ((tick % FREQ) == 0)
+    {
+      checkMissed(2);
+    }
+  }
+
+  scenarioEnd(scenario, 2);
+}
+
+
+/**************************************************************************//**
+ * @brief  Timers started and stopped at random, over several counter wraps
+ *****************************************************************************/
+static void scenarioRandom(const char *scenario, uint32_t latency)
+{
+  uint32_t tick;
+  int      i;
+
+  scenarioBegin(latency, 2);
+  randomActions = true;
+
+  checkStart(&checks[0], LONG_MS, true);
+  for (i = 1; i < TIMERS; i++)
+  {
+    checkStart(&checks[i], (i < 4) ? 1 + TIMERSIM_Random(3000)
+                                   : TIMERSIM_Random(2000), i < 4);
+  }
+
+  for (tick = 0; tick < 60000000; tick++)
+  {
+    TIMERSIM_Tick();
+
+    /* Start stopped timers from the main loop */
+    i = (int)TIMERSIM_Random(200000);
+    if ((i > 0) && (i < TIMERS) && !checks[i].running)
+    {
+      checkStart(&checks[i], TIMERSIM_Random(4000), false);
+    }
+    if ((tick % FREQ) == 0)
+    {
+      checkMissed(TIMERS);
+    }
+  }
+
+  if (checks[0].count < 10)
+  {
+    fail("long period not kept", 0, checks[0].count);
+  }
+
+  scenarioEnd(scenario, TIMERS);
+}
+
+
+int main(void)
+{
+  printf("%-24s %8s %8s %8s %8s\n", "lateness in ticks", "calls", "min",
+         "max", "average");
+
+  scenarioInttemp("inttemp, no latency", 0);
+  scenarioInttemp("inttemp, 0-7 ticks", 7);
+  scenarioRandom("random, no latency", 0);
+  scenarioRandom("random, 0-7 ticks", 7);
+
+  if (TIMERSIM_Failed() || (failures > 0))
+  {
+    printf("FAILED, %d errors\n", failures);
+    return 1;
+  }
+
+  printf("OK\n");
+  return 0;
+}
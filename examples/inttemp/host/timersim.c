@@ -0,0 +1,294 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host simulation of the RTC and CMU used by rtctimer.c.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "timersim.h"
+
+/******************************************************************************
+ * Every TIMERSIM_Tick() is one tick of the 24 bit RTC counter. When the
+ * counter matches COMP0 the interrupt flag is set, and an enabled interrupt
+ * is taken after a random latency of 0 to maxLatency ticks, unless masked.
+ * A compare value is synchronized to the low frequency domain of the RTC,
+ * and only takes effect after the next tick, so it must be at least 2 ticks
+ * ahead of the counter to match.
+ *****************************************************************************/
+
+/* LFRCO and LFXO frequency */
+#define TIMERSIM_LF_FREQ    32768
+
+uint32_t timersimPrimask;
+
+static uint32_t rtcCounter;
+static uint32_t rtcComp0;
+static uint32_t rtcComp0Sync;
+static bool     rtcSyncBusy;
+static uint32_t rtcIen;
+static uint32_t rtcIf;
+static bool     rtcEnabled;
+static bool     rtcClocked;
+static bool     irqEnabled;
+static uint32_t rtcDiv;
+
+/* Ticks since TIMERSIM_Init(), and ticks until a pending interrupt is
+   taken, -1 if none */
+static uint64_t now;
+static int32_t  irqCountdown;
+static uint32_t irqMaxLatency;
+
+static uint32_t randomState;
+
+static bool failed;
+
+
+static void fail(const char *what)
+{
+  if (!failed)
+  {
+    printf("simulation error: %s\n", what);
+  }
+  failed = true;
+}
+
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+  (void)irq;
+  irqCountdown = -1;
+}
+
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+  (void)irq;
+  irqEnabled = true;
+}
+
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable)
+{
+  if (clock == cmuClock_RTC)
+  {
+    rtcClocked = enable;
+  }
+}
+
+
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref)
+{
+  (void)ref;
+  if (clock != cmuClock_LFA)
+  {
+    fail("clock source of other clock than LFA");
+  }
+}
+
+
+void CMU_ClockDivSet(CMU_Clock_TypeDef clock, CMU_ClkDiv_TypeDef div)
+{
+  if (clock == cmuClock_RTC)
+  {
+    rtcDiv = div;
+  }
+}
+
+
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock)
+{
+  if (clock != cmuClock_RTC)
+  {
+    fail("frequency of other clock than RTC");
+  }
+  return TIMERSIM_LF_FREQ / rtcDiv;
+}
+
+
+void RTC_Init(const RTC_Init_TypeDef *init)
+{
+  if (init->comp0Top)
+  {
+    fail("RTC restarted on COMP0");
+  }
+  rtcEnabled = init->enable;
+}
+
+
+void RTC_Enable(bool enable)
+{
+  if (enable && !rtcClocked)
+  {
+    fail("RTC enabled without clock");
+  }
+  rtcEnabled = enable;
+}
+
+
+uint32_t RTC_CounterGet(void)
+{
+  return rtcCounter;
+}
+
+
+void RTC_CompareSet(unsigned int comp, uint32_t value)
+{
+  if ((comp != 0) || (value > _RTC_CNT_MASK))
+  {
+    fail("invalid compare value");
+  }
+  rtcComp0Sync = value;
+  rtcSyncBusy  = true;
+}
+
+
+void RTC_IntEnable(uint32_t flags)
+{
+  rtcIen |= flags;
+}
+
+
+void RTC_IntDisable(uint32_t flags)
+{
+  rtcIen &= ~flags;
+}
+
+
+void RTC_IntSet(uint32_t flags)
+{
+  rtcIf |= flags;
+}
+
+
+void RTC_IntClear(uint32_t flags)
+{
+  rtcIf &= ~flags;
+}
+
+
+/**************************************************************************//**
+ * @brief  Start the simulation
+ *
+ * @param[in] counter     Initial RTC counter value
+ * @param[in] maxLatency  Largest interrupt latency, in ticks
+ * @param[in] seed        Seed of the random latency, not 0
+ *****************************************************************************/
+void TIMERSIM_Init(uint32_t counter, uint32_t maxLatency, uint32_t seed)
+{
+  rtcCounter      = counter & _RTC_CNT_MASK;
+  rtcComp0        = 0;
+  rtcSyncBusy     = false;
+  rtcIen          = 0;
+  rtcIf           = 0;
+  rtcEnabled      = false;
+  rtcClocked      = false;
+  irqEnabled      = false;
+  rtcDiv          = 1;
+  now             = 0;
+  irqCountdown    = -1;
+  irqMaxLatency   = maxLatency;
+  randomState     = seed;
+  timersimPrimask = 0;
+}
+
+
+/**************************************************************************//**
+ * @brief  Advance the RTC by one tick, and take a pending interrupt
+ *****************************************************************************/
+void TIMERSIM_Tick(void)
+{
+  if (rtcEnabled)
+  {
+    rtcCounter = (rtcCounter + 1) & _RTC_CNT_MASK;
+    now++;
+    if (rtcCounter == rtcComp0)
+    {
+      rtcIf |= RTC_IFS_COMP0;
+    }
+  }
+
+  if (rtcSyncBusy)
+  {
+    rtcComp0    = rtcComp0Sync;
+    rtcSyncBusy = false;
+  }
+
+  if (!irqEnabled || !(rtcIf & rtcIen) || (timersimPrimask != 0))
+  {
+    return;
+  }
+
+  if (irqCountdown < 0)
+  {
+    irqCountdown = (int32_t)TIMERSIM_Random(irqMaxLatency + 1);
+  }
+  if (irqCountdown > 0)
+  {
+    irqCountdown--;
+    return;
+  }
+
+  irqCountdown = -1;
+  RTC_IRQHandler();
+  if (timersimPrimask != 0)
+  {
+    fail("interrupts masked on return from the RTC interrupt");
+  }
+}
+
+
+/**************************************************************************//**
+ * @brief  Ticks since TIMERSIM_Init()
+ *****************************************************************************/
+uint64_t TIMERSIM_Now(void)
+{
+  return now;
+}
+
+
+/**************************************************************************//**
+ * @brief  Random number from 0 to range - 1, same sequence on every host
+ *****************************************************************************/
+uint32_t TIMERSIM_Random(uint32_t range)
+{
+  /* xorshift32 */
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState % range;
+}
+
+
+bool TIMERSIM_Failed(void)
+{
+  return failed;
+}
@@ -0,0 +1,143 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host simulation of the RTC and CMU used by rtctimer.c.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __TIMERSIM_H
+#define __TIMERSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Replaces em_assert.h */
+#define EFM_ASSERT(expr)    assert(expr)
+
+/* Interrupts are only taken in TIMERSIM_Tick(), when not masked */
+extern uint32_t timersimPrimask;
+
+static inline uint32_t __get_PRIMASK(void)
+{
+  return timersimPrimask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+  timersimPrimask = primask;
+}
+
+static inline void __disable_irq(void)
+{
+  timersimPrimask = 1;
+}
+
+/* NVIC, only the RTC interrupt is simulated */
+typedef enum
+{
+  RTC_IRQn = 14
+} IRQn_Type;
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_EnableIRQ(IRQn_Type irq);
+
+/* em_cmu.h */
+typedef enum
+{
+  cmuClock_CORELE,
+  cmuClock_LFA,
+  cmuClock_RTC
+} CMU_Clock_TypeDef;
+
+typedef enum
+{
+  cmuSelect_LFXO,
+  cmuSelect_LFRCO
+} CMU_Select_TypeDef;
+
+typedef uint32_t CMU_ClkDiv_TypeDef;
+
+#define cmuClkDiv_1     1
+#define cmuClkDiv_2     2
+#define cmuClkDiv_4     4
+#define cmuClkDiv_8     8
+#define cmuClkDiv_16    16
+#define cmuClkDiv_32    32
+
+void     CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+void     CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref);
+void     CMU_ClockDivSet(CMU_Clock_TypeDef clock, CMU_ClkDiv_TypeDef div);
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock);
+
+/* RTC fields used by rtctimer.c, as in the EFM32GG device headers */
+#define _RTC_CNT_MASK       0xFFFFFFUL
+#define RTC_IEN_COMP0       (0x1UL << 1)
+#define RTC_IFS_COMP0       (0x1UL << 1)
+#define RTC_IFC_COMP0       (0x1UL << 1)
+
+/* em_rtc.h */
+typedef struct
+{
+  bool enable;
+  bool debugRun;
+  bool comp0Top;
+} RTC_Init_TypeDef;
+
+#define RTC_INIT_DEFAULT    { true, false, true }
+
+void     RTC_Init(const RTC_Init_TypeDef *init);
+void     RTC_Enable(bool enable);
+uint32_t RTC_CounterGet(void);
+void     RTC_CompareSet(unsigned int comp, uint32_t value);
+void     RTC_IntEnable(uint32_t flags);
+void     RTC_IntDisable(uint32_t flags);
+void     RTC_IntSet(uint32_t flags);
+void     RTC_IntClear(uint32_t flags);
+
+/* Interrupt handler of rtctimer.c */
+void RTC_IRQHandler(void);
+
+/* Simulation */
+void     TIMERSIM_Init(uint32_t counter, uint32_t maxLatency, uint32_t seed);
+void     TIMERSIM_Tick(void);
+uint64_t TIMERSIM_Now(void);
+uint32_t TIMERSIM_Random(uint32_t range);
+bool     TIMERSIM_Failed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
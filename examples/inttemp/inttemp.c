@@ -51,12 +51,70 @@
 #include "em_adc.h"
 #include "em_cmu.h"
 #include "segmentlcd.h"
-#include "rtcdrv.h"
+#include "rtctimer.h"
+#include "tempconv.h"
+#include "adcpipe.h"
 #include "bsp_trace.h"
 
 /** Flag used to indicate if displaying in Celsius or Fahrenheit */
 static int showFahrenheit;
 
+/** Interval between temperature samples, in ms */
+#define SAMPLE_INTERVAL     250
+
+/** Interval between display updates, in ms. The average of the samples
+ *  taken since the last update is shown. */
+#define DISPLAY_INTERVAL    2000
+
+/** Samples per second while sampling. Every sample is an oversampled
+ *  conversion of 232 us, see ADCPIPE_ADC_FREQ and ADCPIPE_ACQ_TIME. */
+#define SAMPLE_RATE         2000
+
+/** Inputs sampled by the ADC pipeline, one block of each every sample
+ *  interval */
+static const ADCPIPE_Input_TypeDef inputs[] =
+{
+  { adcSingleInpTemp,    adcRef1V25 },  /* Temperature sensor */
+  { adcSingleInpVDDDiv3, adcRef1V25 },  /* Supply voltage / 3 */
+  { adcSingleInpCh6,     adcRefVDD  }   /* External sensor on PD6 */
+};
+
+#define INPUT_TEMP          0
+#define INPUT_VDD           1
+#define INPUT_EXTERNAL      2
+#define INPUTS              ((int)(sizeof(inputs) / sizeof(inputs[0])))
+
+/** Other inputs at the last display update, for inspection with a
+ *  debugger */
+typedef struct
+{
+  uint32_t              vddMv;     /**< Supply voltage, in mV.              */
+  uint32_t              external;  /**< External sensor, VDD full scale.    */
+  ADCPIPE_Stats_TypeDef stats;     /**< Blocks of the pipeline.             */
+} AdcLog_TypeDef;
+
+AdcLog_TypeDef adcLog;
+
+/** Timers sharing the RTC */
+static RTCTIMER_Timer_TypeDef sampleTimer;
+static RTCTIMER_Timer_TypeDef displayTimer;
+
+/** Set from timer callbacks and button interrupts, handled in main loop */
+static volatile bool sampleDue;
+static volatile bool displayDue;
+
+/** Lateness of the sample timer at the last display update, for inspection
+ *  with a debugger */
+RTCTIMER_Stats_TypeDef sampleStats;
+
+/**************************************************************************//**
+ * @brief Timer callback, sets the flag given as argument
+ *****************************************************************************/
+static void timerFlagSet(void *user)
+{
+  *(volatile bool *)user = true;
+}
+
 /**************************************************************************//**
  * @brief GPIO Interrupt handler (PB9) Fahrenheit
  *****************************************************************************/
@@ -66,6 +124,7 @@ void GPIO_ODD_IRQHandler(void)
   GPIO_IntClear(1 << 9);
 
   showFahrenheit = 1;
+  displayDue     = true;
 }
 
 /**************************************************************************//**
@@ -77,6 +136,7 @@ void GPIO_EVEN_IRQHandler(void)
   GPIO_IntClear(1 << 10);
 
   showFahrenheit = 0;
+  displayDue     = true;
 }
 
 /**************************************************************************//**
@@ -104,41 +164,33 @@ void gpioSetup(void)
 }
 
 /**************************************************************************//**
- * @brief ADC0 interrupt handler. Simply clears interrupt flag.
+ * @brief Round hundredths of a degree to tenths
  *****************************************************************************/
-void ADC0_IRQHandler(void)
+static int32_t centiToTenths(int32_t centi)
 {
-  ADC_IntClear(ADC0, ADC_IF_SINGLE);
+  return (centi >= 0) ? ((centi + 5) / 10) : ((centi - 5) / 10);
 }
 
-/**************************************************************************//**
- * @brief Initialize ADC for temperature sensor readings in single poin
- *****************************************************************************/
-void setupSensor(void)
+#if defined(TEMPCONV_BENCHMARK)
+/** Core clock cycles of a conversion, averaged over samples across the ADC
+ *  range, measured at startup for inspection with a debugger */
+typedef struct
 {
-  /* Base the ADC configuration on the default setup. */
-  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
-  ADC_InitSingle_TypeDef sInit = ADC_INITSINGLE_DEFAULT;
-
-  /* Initialize timebases */
-  init.timebase = ADC_TimebaseCalc(0);
-  init.prescale = ADC_PrescaleCalc(400000,0);
-  ADC_Init(ADC0, &init);
-
-  /* Set input to temperature sensor. Reference must be 1.25V */
-  sInit.reference = adcRef1V25;
-  sInit.input = adcSingleInpTemp;
-  ADC_InitSingle(ADC0, &sInit);
-
-  /* Setup interrupt generation on completed conversion. */
-  ADC_IntEnable(ADC0, ADC_IF_SINGLE);
-  NVIC_EnableIRQ(ADC0_IRQn);
-}
+  uint32_t floatCelsius;
+  uint32_t floatFahrenheit;
+  uint32_t fixedCelsius;
+  uint32_t fixedFahrenheit;
+} ConvCycles_TypeDef;
+
+ConvCycles_TypeDef convCycles;
+
+/** Samples of the benchmark */
+#define BENCHMARK_SAMPLES   64
 
 /**************************************************************************//**
- * @brief Convert ADC sample values to celsius.
- * @note See section 2.3.4 in the reference manual for details on this
- *       calculatoin
+ * @brief Convert ADC sample values to celsius, in floating point
+ * @note This is the conversion the example used before tempconv.c, kept to
+ *       compare the cycles.
  * @param adcSample Raw value from ADC to be converted to celsius
  * @return The temperature in degrees Celsius.
  *****************************************************************************/
@@ -162,7 +214,7 @@ float convertToCelsius(int32_t adcSample)
 }
 
 /**************************************************************************//**
- * @brief Convert ADC sample values to fahrenheit
+ * @brief Convert ADC sample values to fahrenheit, in floating point
  * @param adcSample Raw value from ADC to be converted to fahrenheit
  * @return The temperature in degrees Fahrenheit
  *****************************************************************************/
@@ -177,17 +229,64 @@ float convertToFahrenheit(uint32_t adcSample)
   return fahrenheit;
 }
 
+/**************************************************************************//**
+ * @brief Measure the cycles of the floating and fixed point conversions
+ *        with the DWT cycle counter
+ *****************************************************************************/
+static void convBenchmark(void)
+{
+  volatile float   f;
+  volatile int32_t centi;
+  uint32_t         cycles[4] = { 0, 0, 0, 0 };
+  uint32_t         sample;
+  uint32_t         start;
+  int              i;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+  for (i = 0; i < BENCHMARK_SAMPLES; i++)
+  {
+    sample = (uint32_t)i * (4096 / BENCHMARK_SAMPLES);
+
+    start      = DWT->CYCCNT;
+    f          = convertToCelsius(sample);
+    cycles[0] += DWT->CYCCNT - start;
+
+    start      = DWT->CYCCNT;
+    f          = convertToFahrenheit(sample);
+    cycles[1] += DWT->CYCCNT - start;
+
+    start      = DWT->CYCCNT;
+    centi      = TEMPCONV_CentiCelsius(sample);
+    cycles[2] += DWT->CYCCNT - start;
+
+    start      = DWT->CYCCNT;
+    centi      = TEMPCONV_CentiFahrenheit(sample);
+    cycles[3] += DWT->CYCCNT - start;
+  }
+  (void)f;
+  (void)centi;
+
+  convCycles.floatCelsius    = cycles[0] / BENCHMARK_SAMPLES;
+  convCycles.floatFahrenheit = cycles[1] / BENCHMARK_SAMPLES;
+  convCycles.fixedCelsius    = cycles[2] / BENCHMARK_SAMPLES;
+  convCycles.fixedFahrenheit = cycles[3] / BENCHMARK_SAMPLES;
+}
+#endif
+
 /**************************************************************************//**
  * @brief  Main function
  *****************************************************************************/
 int main(void)
 {
-  uint8_t prod_rev;
   char string[8];
-  int i;
+  int32_t i;
+  int32_t celsius;
+  int32_t fahrenheit;
 
-  uint32_t temp;
-  uint32_t temp_offset;
+  uint32_t temp = 0;
+  ADCPIPE_Result_TypeDef result;
 
   /* Chip errata */
   CHIP_Init();
@@ -197,56 +296,103 @@ int main(void)
 
   /* Enable peripheral clocks */
   CMU_ClockEnable(cmuClock_HFPER, true);
-  CMU_ClockEnable(cmuClock_ADC0, true);
 
   /* Initialize LCD controller without boost */
   SegmentLCD_Init(false);
   SegmentLCD_AllOff();
 
-  /* This is a work around for Chip Rev.D Errata, Revision 0.6. */
-  /* Check for product revision 16 and 17 and set the offset */
-  /* for ADC0_TEMP_0_READ_1V25. */
-  prod_rev = (DEVINFO->PART & _DEVINFO_PART_PROD_REV_MASK) >> _DEVINFO_PART_PROD_REV_SHIFT;
+  /* Read the factory calibration once, with the offset of the Chip Rev.D
+     Errata, Revision 0.6, see tempconv.c */
+  TEMPCONV_Init();
 
-  if( (prod_rev == 16) || (prod_rev == 17) )
-  {
-      temp_offset = 112;
-  }
-  else
-  {
-      temp_offset = 0;
-  }
+#if defined(TEMPCONV_BENCHMARK)
+  convBenchmark();
+#endif
 
   /* Enable board control interrupts */
   gpioSetup();
 
-  /* Setup ADC for sampling internal temperature sensor. */
-  setupSensor();
+  /* Sample the inputs with TIMER0, PRS and DMA, see adcpipe.c */
+  ADCPIPE_Init(inputs, INPUTS, SAMPLE_RATE);
+
+  /* Sample and display from two periodic timers on the RTC */
+  RTCTIMER_Init(cmuSelect_LFRCO, cmuClkDiv_32);
+  RTCTIMER_TimerInit(&sampleTimer);
+  RTCTIMER_TimerInit(&displayTimer);
+  RTCTIMER_Start(&sampleTimer, SAMPLE_INTERVAL, true, timerFlagSet, (void *)&sampleDue);
+  RTCTIMER_Start(&displayTimer, DISPLAY_INTERVAL, true, timerFlagSet, (void *)&displayDue);
+  sampleDue = true;
 
-  /* Main loop - just read temperature and update LCD */
+  /* Main loop - read temperature and update LCD when the timers expire */
   while (1)
   {
+    if (sampleDue)
+    {
+      sampleDue = false;
+
+      /* Sample a block of every input, the DMA interrupt at the end of a
+         block is the only wakeup */
+      if (!ADCPIPE_Busy())
+      {
+        ADCPIPE_Start(INPUTS);
+      }
+    }
 
-    /* Start one ADC sample */
-    ADC_Start(ADC0, adcStartSingle);
+    /* Average the full blocks */
+    if (ADCPIPE_Pending())
+    {
+      ADCPIPE_Process();
+    }
 
-    /* Wait in EM1 for ADC to complete */
-    EMU_EnterEM1();
+    if (!displayDue)
+    {
+      /* Sleep until a timer, button or full block sets a flag, in EM1 while
+         the pipeline is sampling, else in EM2 */
+      __disable_irq();
+      if (!sampleDue && !displayDue && !ADCPIPE_Pending())
+      {
+        if (ADCPIPE_Busy())
+        {
+          EMU_EnterEM1();
+        }
+        else
+        {
+          EMU_EnterEM2(true);
+        }
+      }
+      __enable_irq();
+      continue;
+    }
+    displayDue = false;
 
-    /* Read sensor value */
-    /* According to rev. D errata ADC0_TEMP_0_READ_1V25 should be decreased */
-    /* by the offset  but it is the same if ADC reading is increased - */
-    /* reference manual 28.3.4.2. */
-    temp = ADC_DataSingleGet(ADC0) + temp_offset;
+    /* A button press right after an update may find no new samples, the
+       previous average is shown again */
+    if (ADCPIPE_Read(INPUT_TEMP, &result))
+    {
+      temp = result.average;
+    }
+    if (ADCPIPE_Read(INPUT_VDD, &result))
+    {
+      adcLog.vddMv = (result.average * 3 * 1250 + 0x8000) >> 16;
+    }
+    if (ADCPIPE_Read(INPUT_EXTERNAL, &result))
+    {
+      adcLog.external = result.average;
+    }
+    ADCPIPE_StatsGet(&adcLog.stats);
+    RTCTIMER_StatsGet(&sampleTimer, &sampleStats);
 
-    /* Convert ADC sample to Fahrenheit / Celsius and print string to display */
+    /* Convert the oversampled average to Fahrenheit / Celsius and print
+       string to display */
+    celsius    = TEMPCONV_CentiCelsiusOvs(temp);
+    fahrenheit = TEMPCONV_CentiFahrenheitOvs(temp);
     if (showFahrenheit)
     {
       /* Show Fahrenheit on alphanumeric part of display */
-      i = (int)(convertToFahrenheit(temp) * 10);
-      snprintf(string, 8, "%2d,%1d%%F", (i/10), abs(i%10));
+      i = centiToTenths(fahrenheit);
+      snprintf(string, 8, "%2d,%1d%%F", (int)(i/10), (int)abs(i%10));
       /* Show Celsius on numeric part of display */
-      i = (int)(convertToCelsius(temp) * 10);
+      i = centiToTenths(celsius);
       SegmentLCD_Number(i*10);
       SegmentLCD_Symbol(LCD_SYMBOL_DP10, 1);
       SegmentLCD_Symbol(LCD_SYMBOL_DEGC, 1);
@@ -255,19 +401,15 @@ int main(void)
     else
     {
       /* Show Celsius on alphanumeric part of display */
-      i = (int)(convertToCelsius(temp) * 10);
-      snprintf(string, 8, "%2d,%1d%%C", (i/10), abs(i%10));
+      i = centiToTenths(celsius);
+      snprintf(string, 8, "%2d,%1d%%C", (int)(i/10), (int)abs(i%10));
       /* Show Fahrenheit on numeric part of display */
-      i = (int)(convertToFahrenheit(temp) * 10);
+      i = centiToTenths(fahrenheit);
       SegmentLCD_Number(i*10);
       SegmentLCD_Symbol(LCD_SYMBOL_DP10, 1);
       SegmentLCD_Symbol(LCD_SYMBOL_DEGC, 0);
       SegmentLCD_Symbol(LCD_SYMBOL_DEGF, 1);
     }
     SegmentLCD_Write(string);
-
-    /* Sleep for 2 seconds in EM 2 */
-    RTCDRV_Trigger(2000, NULL);
-    EMU_EnterEM2(true);
   }
 }
@@ -0,0 +1,501 @@
+/***************************************************************************//**
+ * @file
+ * @brief Multiplexed software timers on the RTC.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stddef.h>
+
+#if defined(RTCTIMER_HOST)
+#include "timersim.h"     /* Host build, see host/readme.txt */
+#else
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_rtc.h"
+#endif
+
+#include "rtctimer.h"
+
+/***************************************************************************//**
+ * @addtogroup RTCTIMER
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/* RTC counter mask, the counter is 24 bits and wraps around. */
+#define RTCTIMER_MASK            _RTC_CNT_MASK
+
+/* Longest step of COMP0. A timer further away gets intermediate interrupts,
+   so elapsed ticks are always less than a counter period. */
+#define RTCTIMER_MAX_STEP        (RTCTIMER_MASK >> 2)
+
+/* COMP0 is written through the low frequency domain, and must be this many
+   ticks ahead of the counter to match reliably. */
+#define RTCTIMER_MIN_STEP        2
+
+/** @endcond */
+
+/*******************************************************************************
+ *******************************   STATICS   ***********************************
+ ******************************************************************************/
+
+/* Running timers, sorted by expiry. */
+static RTCTIMER_Timer_TypeDef *timerList;
+
+/* RTC counter value the delta of the first timer is counted from. */
+static uint32_t baseTicks;
+
+/* RTC ticks per second. */
+static uint32_t rtcFreq;
+
+/*******************************************************************************
+ **************************   LOCAL FUNCTIONS   ********************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Move the start of the delta list to the current RTC counter.
+ *
+ * @details
+ *   The ticks elapsed since the last call are taken from the first timers.
+ *   Timers which expire get a delta of 0, and the ticks since their expiry
+ *   are added to their lateness. Must be called with interrupts disabled.
+ ******************************************************************************/
+static void timerAdvance(void)
+{
+  RTCTIMER_Timer_TypeDef *timer = timerList;
+  uint32_t               now    = RTC_CounterGet();
+  uint32_t               elapsed;
+
+  elapsed   = (now - baseTicks) & RTCTIMER_MASK;
+  baseTicks = now;
+
+  while ((timer != NULL) && (elapsed > 0))
+  {
+    if (timer->delta > elapsed)
+    {
+      timer->delta -= elapsed;
+      break;
+    }
+    elapsed      -= timer->delta;
+    timer->late  += elapsed;
+    timer->delta  = 0;
+    timer         = timer->next;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Insert a timer in the delta list.
+ *
+ * @details
+ *   Timers with the same expiry keep the order they were inserted in. Must
+ *   be called with interrupts disabled, after timerAdvance().
+ *
+ * @param[in] timer
+ *   Timer, not in the list.
+ *
+ * @param[in] ticks
+ *   Ticks from now to expiry.
+ ******************************************************************************/
+static void timerInsert(RTCTIMER_Timer_TypeDef *timer, uint32_t ticks)
+{
+  RTCTIMER_Timer_TypeDef **link = &timerList;
+
+  while ((*link != NULL) && ((*link)->delta <= ticks))
+  {
+    ticks -= (*link)->delta;
+    link   = &(*link)->next;
+  }
+
+  /* The following timer is now counted from this one */
+  if (*link != NULL)
+  {
+    (*link)->delta -= ticks;
+  }
+
+  timer->delta   = ticks;
+  timer->late    = 0;
+  timer->next    = *link;
+  timer->running = true;
+  *link          = timer;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Remove a timer from the delta list.
+ *
+ * @details
+ *   Must be called with interrupts disabled.
+ ******************************************************************************/
+static void timerRemove(RTCTIMER_Timer_TypeDef *timer)
+{
+  RTCTIMER_Timer_TypeDef **link = &timerList;
+
+  while (*link != timer)
+  {
+    link = &(*link)->next;
+  }
+
+  /* The following timer is now counted from the previous one */
+  if (timer->next != NULL)
+  {
+    timer->next->delta += timer->delta;
+  }
+
+  *link          = timer->next;
+  timer->running = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Ticks until the next expiry of a timer.
+ *
+ * @details
+ *   A one-shot timer is rounded up, so it never expires early. The period of
+ *   a periodic timer is rounded down, and the remainder is carried to the
+ *   next period.
+ ******************************************************************************/
+static uint32_t timerTicks(RTCTIMER_Timer_TypeDef *timer, uint32_t ms)
+{
+  uint64_t total = (uint64_t)ms * rtcFreq;
+
+  if (timer->periodMs == 0)
+  {
+    return (uint32_t)((total + 999) / 1000);
+  }
+
+  total          += timer->fraction;
+  timer->fraction = (uint32_t)(total % 1000);
+  return (uint32_t)(total / 1000);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set COMP0 to the expiry of the first timer.
+ *
+ * @details
+ *   Must be called with interrupts disabled, after timerAdvance().
+ ******************************************************************************/
+static void timerProgram(void)
+{
+  uint32_t step;
+
+  if (timerList == NULL)
+  {
+    RTC_IntDisable(RTC_IEN_COMP0);
+    return;
+  }
+
+  step = timerList->delta;
+  if (step > RTCTIMER_MAX_STEP)
+  {
+    step = RTCTIMER_MAX_STEP;
+  }
+
+  RTC_CompareSet(0, (baseTicks + step) & RTCTIMER_MASK);
+  RTC_IntEnable(RTC_IEN_COMP0);
+
+  /* The counter is read after setting COMP0, so an expiry passed in the
+     meantime is found here */
+  if (((RTC_CounterGet() - baseTicks) & RTCTIMER_MASK) + RTCTIMER_MIN_STEP >= step)
+  {
+    RTC_IntSet(RTC_IFS_COMP0);
+  }
+}
+
+/*******************************************************************************
+ **************************   GLOBAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief RTC interrupt handler, calls back expired timers.
+ ******************************************************************************/
+void RTC_IRQHandler(void)
+{
+  RTCTIMER_Timer_TypeDef *timer;
+  uint32_t               late;
+  uint32_t               ticks;
+  uint32_t               primask;
+
+  RTC_IntClear(RTC_IFC_COMP0);
+
+  while (true)
+  {
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    timerAdvance();
+    timer = timerList;
+    if ((timer == NULL) || (timer->delta > 0))
+    {
+      timerProgram();
+      __set_PRIMASK(primask);
+      break;
+    }
+
+    /* Expired, a periodic timer is restarted from its expiry */
+    late = timer->late;
+    timerRemove(timer);
+    if (timer->periodMs != 0)
+    {
+      ticks = timerTicks(timer, timer->periodMs);
+      timerInsert(timer, ticks > late ? ticks - late : 0);
+      timer->late = ticks > late ? 0 : late - ticks;
+    }
+
+    if ((timer->stats.count == 0) || (late < timer->stats.lateMin))
+    {
+      timer->stats.lateMin = late;
+    }
+    if (late > timer->stats.lateMax)
+    {
+      timer->stats.lateMax = late;
+    }
+    timer->stats.lateSum += late;
+    timer->stats.count++;
+
+    __set_PRIMASK(primask);
+
+    timer->callback(timer->user);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Initialize the timers.
+ *
+ * @details
+ *   The RTC is started as a free running counter. COMP0 is used for the
+ *   expiry of the first timer.
+ *
+ * @param[in] lfaClock
+ *   Clock source of LFACLK, cmuSelect_LFXO or cmuSelect_LFRCO.
+ *
+ * @param[in] div
+ *   RTC clock divisor. cmuClkDiv_32 gives 1024 ticks per second from a
+ *   32768 Hz oscillator.
+ ******************************************************************************/
+void RTCTIMER_Init(CMU_Select_TypeDef lfaClock, CMU_ClkDiv_TypeDef div)
+{
+  RTC_Init_TypeDef rtcInit = RTC_INIT_DEFAULT;
+
+  timerList = NULL;
+
+  /* Enable LE domain registers and RTC clock */
+  CMU_ClockEnable(cmuClock_CORELE, true);
+  CMU_ClockSelectSet(cmuClock_LFA, lfaClock);
+  CMU_ClockDivSet(cmuClock_RTC, div);
+  CMU_ClockEnable(cmuClock_RTC, true);
+
+  rtcInit.enable   = false;  /* Start RTC after the interrupt is set up. */
+  rtcInit.debugRun = false;  /* Halt RTC when debugging. */
+  rtcInit.comp0Top = false;  /* Free running, COMP0 follows the timers. */
+  RTC_Init(&rtcInit);
+
+  rtcFreq = CMU_ClockFreqGet(cmuClock_RTC);
+  EFM_ASSERT(rtcFreq > 0);
+
+  RTC_IntDisable(RTC_IEN_COMP0);
+  RTC_IntClear(RTC_IFC_COMP0);
+  NVIC_ClearPendingIRQ(RTC_IRQn);
+  NVIC_EnableIRQ(RTC_IRQn);
+
+  RTC_Enable(true);
+  baseTicks = RTC_CounterGet();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set up a timer as stopped.
+ *
+ * @details
+ *   Must be called once before the timer is first started, and not while it
+ *   is running. A timer in static memory is zero-initialized and stopped
+ *   already, a timer on the stack or heap is not.
+ *
+ * @param[in] timer
+ *   Timer.
+ ******************************************************************************/
+void RTCTIMER_TimerInit(RTCTIMER_Timer_TypeDef *timer)
+{
+  timer->next          = NULL;
+  timer->delta         = 0;
+  timer->late          = 0;
+  timer->periodMs      = 0;
+  timer->fraction      = 0;
+  timer->running       = false;
+  timer->callback      = NULL;
+  timer->user          = NULL;
+  timer->stats.count   = 0;
+  timer->stats.lateMin = 0;
+  timer->stats.lateMax = 0;
+  timer->stats.lateSum = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start a timer.
+ *
+ * @details
+ *   The timer must have been set up with RTCTIMER_TimerInit(). A running
+ *   timer is restarted. Its lateness statistics are cleared. Can
+ *   be called from timer callbacks.
+ *
+ * @param[in] timer
+ *   Timer.
+ *
+ * @param[in] ms
+ *   Time to expiry, and period of a periodic timer, in milliseconds.
+ *
+ * @param[in] periodic
+ *   Restart the timer on every expiry.
+ *
+ * @param[in] callback
+ *   Called from the RTC interrupt handler on expiry.
+ *
+ * @param[in] user
+ *   Argument of the callback.
+ ******************************************************************************/
+void RTCTIMER_Start(RTCTIMER_Timer_TypeDef *timer, uint32_t ms, bool periodic,
+                    RTCTIMER_Callback_TypeDef callback, void *user)
+{
+  uint32_t primask;
+
+  EFM_ASSERT(callback != NULL);
+  EFM_ASSERT(!periodic || (ms > 0));
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (timer->running)
+  {
+    timerRemove(timer);
+  }
+  timerAdvance();
+
+  timer->periodMs = periodic ? ms : 0;
+  timer->fraction = 0;
+  timer->callback = callback;
+  timer->user     = user;
+  timer->stats.count   = 0;
+  timer->stats.lateMin = 0;
+  timer->stats.lateMax = 0;
+  timer->stats.lateSum = 0;
+
+  timerInsert(timer, timerTicks(timer, ms));
+  timerProgram();
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop a timer.
+ *
+ * @param[in] timer
+ *   Timer.
+ *
+ * @return
+ *   false if the timer was not running.
+ ******************************************************************************/
+bool RTCTIMER_Stop(RTCTIMER_Timer_TypeDef *timer)
+{
+  uint32_t primask;
+  bool     running;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  running = timer->running;
+  if (running)
+  {
+    timerRemove(timer);
+    timerAdvance();
+    timerProgram();
+  }
+
+  __set_PRIMASK(primask);
+
+  return running;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check if a timer is running.
+ ******************************************************************************/
+bool RTCTIMER_Running(const RTCTIMER_Timer_TypeDef *timer)
+{
+  return timer->running;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the lateness of the callbacks of a timer.
+ *
+ * @details
+ *   Lateness is the time from expiry until the timer is handled in the RTC
+ *   interrupt, in RTC ticks. For a periodic timer, lateMax - lateMin is the
+ *   jitter of its period.
+ *
+ * @param[in] timer
+ *   Timer.
+ *
+ * @param[out] stats
+ *   Lateness since the timer was started.
+ ******************************************************************************/
+void RTCTIMER_StatsGet(const RTCTIMER_Timer_TypeDef *timer,
+                       RTCTIMER_Stats_TypeDef *stats)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  *stats = timer->stats;
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert RTC ticks to microseconds.
+ ******************************************************************************/
+uint32_t RTCTIMER_TicksToUs(uint32_t ticks)
+{
+  return (uint32_t)(((uint64_t)ticks * 1000000) / rtcFreq);
+}
+
+/** @} (end addtogroup RTCTIMER) */
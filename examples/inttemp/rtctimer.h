@@ -0,0 +1,127 @@
+/***************************************************************************//**
+ * @file
+ * @brief Multiplexed software timers on the RTC.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __RTCTIMER_H
+#define __RTCTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(RTCTIMER_HOST)
+#include "timersim.h"     /* Host build, see host/readme.txt */
+#else
+#include "em_cmu.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup RTCTIMER
+ * @brief Multiplexed one-shot and periodic timers on the RTC.
+ * @details
+ *   Any number of timers share the RTC. They are kept in a list sorted by
+ *   expiry time, where every timer holds the RTC ticks from the expiry of
+ *   the previous one (a delta list). COMP0 is set to the expiry of the first
+ *   timer only, so the RTC interrupt occurs when a timer expires and never
+ *   in between, and the core can stay in EM2.
+ *
+ *   The RTC counts freely and is never restarted. A periodic timer is
+ *   restarted from its expiry time rather than from the time its callback
+ *   runs, so interrupt latency does not add up, and periods which are not a
+ *   whole number of ticks are kept on average.
+ *
+ *   Callbacks are called from the RTC interrupt handler, in expiry order.
+ *   They may start and stop timers. Every timer records how late its
+ *   callbacks were, in RTC ticks, see RTCTIMER_StatsGet().
+ *
+ *   RTCTIMER replaces RTCDRV, which restarts the RTC on every timeout, and
+ *   both can not be used together.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ ******************************   TYPEDEFS   ***********************************
+ ******************************************************************************/
+
+/** Timer callback, called from the RTC interrupt handler. */
+typedef void (*RTCTIMER_Callback_TypeDef)(void *user);
+
+/** Lateness of the callbacks of a timer, in RTC ticks. */
+typedef struct
+{
+  uint32_t count;      /**< Expirations since the timer was started.        */
+  uint32_t lateMin;    /**< Smallest lateness.                              */
+  uint32_t lateMax;    /**< Largest lateness.                               */
+  uint32_t lateSum;    /**< Sum of lateness, for the average.               */
+} RTCTIMER_Stats_TypeDef;
+
+/** Timer. The memory is owned by the caller and must stay valid while the
+ *  timer is running. It must be set up with RTCTIMER_TimerInit() before it
+ *  is first started. */
+typedef struct RTCTIMER_Timer
+{
+  struct RTCTIMER_Timer     *next;      /**< Next timer in the delta list.   */
+  uint32_t                  delta;      /**< Ticks after the previous timer. */
+  uint32_t                  late;       /**< Ticks late at expiry.           */
+  uint32_t                  periodMs;   /**< Period, 0 for a one-shot timer. */
+  uint32_t                  fraction;   /**< Period remainder, ms * ticks/s. */
+  bool                      running;    /**< In the delta list.              */
+  RTCTIMER_Callback_TypeDef callback;   /**< Called on expiry.               */
+  void                      *user;      /**< Argument of the callback.       */
+  RTCTIMER_Stats_TypeDef    stats;      /**< Lateness of the callbacks.      */
+} RTCTIMER_Timer_TypeDef;
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+void     RTCTIMER_Init(CMU_Select_TypeDef lfaClock, CMU_ClkDiv_TypeDef div);
+void     RTCTIMER_TimerInit(RTCTIMER_Timer_TypeDef *timer);
+void     RTCTIMER_Start(RTCTIMER_Timer_TypeDef *timer, uint32_t ms, bool periodic,
+                        RTCTIMER_Callback_TypeDef callback, void *user);
+bool     RTCTIMER_Stop(RTCTIMER_Timer_TypeDef *timer);
+bool     RTCTIMER_Running(const RTCTIMER_Timer_TypeDef *timer);
+void     RTCTIMER_StatsGet(const RTCTIMER_Timer_TypeDef *timer,
+                           RTCTIMER_Stats_TypeDef *stats);
+uint32_t RTCTIMER_TicksToUs(uint32_t ticks);
+
+/** @} (end addtogroup RTCTIMER) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RTCTIMER_H */
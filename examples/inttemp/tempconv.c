@@ -0,0 +1,248 @@
+/***************************************************************************//**
+ * @file
+ * @brief Fixed point conversion of the internal temperature sensor.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#if defined(TEMPCONV_HOST)
+#include "tempsim.h"      /* Host build, see host/readme.txt */
+#else
+#include "em_device.h"
+#include "em_assert.h"
+#endif
+
+#include "tempconv.h"
+
+/***************************************************************************//**
+ * @addtogroup TEMPCONV
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/* Fraction bits of the coefficients. The products stay below 2^32 for any
+   12 bit calibration value and sample, and the 8 bit calibration temperature. */
+#define TEMPCONV_SHIFT           14
+
+/* Absolute zero, in hundredths of a degree Celsius and Fahrenheit. The
+   conversion is done in Kelvin and Rankine, so all values are positive. */
+#define TEMPCONV_KELVIN          27315
+#define TEMPCONV_RANKINE         45967
+
+/* Hundredths of a degree per ADC step, in units of 2^-TEMPCONV_SHIFT */
+#define TEMPCONV_STEP_C \
+  (((10000UL << TEMPCONV_SHIFT) + TEMPCONV_GRADIENT / 2) / TEMPCONV_GRADIENT)
+#define TEMPCONV_STEP_F \
+  (((9UL * (10000UL << TEMPCONV_SHIFT)) + 5 * TEMPCONV_GRADIENT / 2) / \
+   (5 * TEMPCONV_GRADIENT))
+
+/** @endcond */
+
+/*******************************************************************************
+ *******************************   STATICS   ***********************************
+ ******************************************************************************/
+
+/* Temperature at sample 0, in units of 2^-TEMPCONV_SHIFT hundredths of a
+   Kelvin and of a Rankine, plus 0.5 for rounding. */
+static uint32_t zeroKelvin;
+static uint32_t zeroRankine;
+
+/*******************************************************************************
+ **************************   GLOBAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Calibrate the conversion from the device information page.
+ *
+ * @details
+ *   Reads the calibration temperature and the ADC sample at that
+ *   temperature, and applies the offset of the rev. D errata on product
+ *   revision 16 and 17. Must be called before the first conversion.
+ ******************************************************************************/
+void TEMPCONV_Init(void)
+{
+  uint32_t prodRev;
+  uint32_t offset = 0;
+
+  prodRev = (DEVINFO->PART & _DEVINFO_PART_PROD_REV_MASK)
+            >> _DEVINFO_PART_PROD_REV_SHIFT;
+  if ((prodRev == 16) || (prodRev == 17))
+  {
+    offset = TEMPCONV_REVD_OFFSET;
+  }
+
+  TEMPCONV_Calibrate((DEVINFO->CAL & _DEVINFO_CAL_TEMP_MASK)
+                     >> _DEVINFO_CAL_TEMP_SHIFT,
+                     (DEVINFO->ADC0CAL2 & _DEVINFO_ADC0CAL2_TEMP1V25_MASK)
+                     >> _DEVINFO_ADC0CAL2_TEMP1V25_SHIFT,
+                     offset);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Calibrate the conversion.
+ *
+ * @param[in] calTemp
+ *   Calibration temperature in degrees Celsius, CAL_TEMP_0, 0-255.
+ *
+ * @param[in] calValue
+ *   ADC sample at calTemp, ADC0_TEMP_0_READ_1V25, 0-4095.
+ *
+ * @param[in] offset
+ *   Offset subtracted from calValue, see the rev. D errata.
+ ******************************************************************************/
+void TEMPCONV_Calibrate(uint32_t calTemp, uint32_t calValue, uint32_t offset)
+{
+  EFM_ASSERT((calTemp <= 255) && (calValue <= 4095));
+
+  calValue = (calValue > offset) ? (calValue - offset) : 0;
+
+  /* T(sample) = calTemp + (calValue - sample) * step */
+  zeroKelvin = ((TEMPCONV_KELVIN + 100 * calTemp) << TEMPCONV_SHIFT)
+               + calValue * TEMPCONV_STEP_C
+               + (1UL << (TEMPCONV_SHIFT - 1));
+  zeroRankine = ((TEMPCONV_KELVIN * 9 / 5 + 180 * calTemp) << TEMPCONV_SHIFT)
+                + calValue * TEMPCONV_STEP_F
+                + (1UL << (TEMPCONV_SHIFT - 1));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert a temperature sensor sample to degrees Celsius.
+ *
+ * @param[in] sample
+ *   12 bit ADC sample, 1.25 V reference.
+ *
+ * @return
+ *   Temperature in hundredths of a degree Celsius.
+ ******************************************************************************/
+int32_t TEMPCONV_CentiCelsius(uint32_t sample)
+{
+  uint32_t drop;
+
+  if (sample > 4095)
+  {
+    sample = 4095;
+  }
+  drop = sample * TEMPCONV_STEP_C;
+  if (drop > zeroKelvin)
+  {
+    return -TEMPCONV_KELVIN;
+  }
+  return (int32_t)((zeroKelvin - drop) >> TEMPCONV_SHIFT) - TEMPCONV_KELVIN;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert a temperature sensor sample to degrees Fahrenheit.
+ *
+ * @param[in] sample
+ *   12 bit ADC sample, 1.25 V reference.
+ *
+ * @return
+ *   Temperature in hundredths of a degree Fahrenheit.
+ ******************************************************************************/
+int32_t TEMPCONV_CentiFahrenheit(uint32_t sample)
+{
+  uint32_t drop;
+
+  if (sample > 4095)
+  {
+    sample = 4095;
+  }
+  drop = sample * TEMPCONV_STEP_F;
+  if (drop > zeroRankine)
+  {
+    return -TEMPCONV_RANKINE;
+  }
+  return (int32_t)((zeroRankine - drop) >> TEMPCONV_SHIFT) - TEMPCONV_RANKINE;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert an oversampled temperature sensor sample to degrees Celsius.
+ *
+ * @param[in] sample
+ *   ADC sample or average of samples with TEMPCONV_OVS_BITS fraction bits,
+ *   1.25 V reference.
+ *
+ * @return
+ *   Temperature in hundredths of a degree Celsius.
+ ******************************************************************************/
+int32_t TEMPCONV_CentiCelsiusOvs(uint32_t sample)
+{
+  uint32_t drop;
+
+  if (sample > (4095UL << TEMPCONV_OVS_BITS))
+  {
+    sample = 4095UL << TEMPCONV_OVS_BITS;
+  }
+  drop = (uint32_t)(((uint64_t)sample * TEMPCONV_STEP_C) >> TEMPCONV_OVS_BITS);
+  if (drop > zeroKelvin)
+  {
+    return -TEMPCONV_KELVIN;
+  }
+  return (int32_t)((zeroKelvin - drop) >> TEMPCONV_SHIFT) - TEMPCONV_KELVIN;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert an oversampled temperature sensor sample to degrees Fahrenheit.
+ *
+ * @param[in] sample
+ *   ADC sample or average of samples with TEMPCONV_OVS_BITS fraction bits,
+ *   1.25 V reference.
+ *
+ * @return
+ *   Temperature in hundredths of a degree Fahrenheit.
+ ******************************************************************************/
+int32_t TEMPCONV_CentiFahrenheitOvs(uint32_t sample)
+{
+  uint32_t drop;
+
+  if (sample > (4095UL << TEMPCONV_OVS_BITS))
+  {
+    sample = 4095UL << TEMPCONV_OVS_BITS;
+  }
+  drop = (uint32_t)(((uint64_t)sample * TEMPCONV_STEP_F) >> TEMPCONV_OVS_BITS);
+  if (drop > zeroRankine)
+  {
+    return -TEMPCONV_RANKINE;
+  }
+  return (int32_t)((zeroRankine - drop) >> TEMPCONV_SHIFT) - TEMPCONV_RANKINE;
+}
+
+/** @} (end addtogroup TEMPCONV) */
@@ -0,0 +1,110 @@
+/***************************************************************************//**
+ * @file
+ * @brief Fixed point conversion of the internal temperature sensor.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __TEMPCONV_H
+#define __TEMPCONV_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup TEMPCONV
+ * @brief Integer conversion of temperature sensor samples.
+ * @details
+ *   Converts 12 bit ADC samples of the internal temperature sensor, taken
+ *   with the 1.25 V reference, to hundredths of a degree Celsius or
+ *   Fahrenheit, as described in the reference manual:
+ *
+ *     T = CAL_TEMP_0 - (ADC0_TEMP_0_READ_1V25 - sample) / gradient
+ *
+ *   The factory calibration is read from the device information page once,
+ *   by TEMPCONV_Init(), which also applies the ADC0_TEMP_0_READ_1V25 offset
+ *   of the chip rev. D errata. The calibration and the gradient are folded
+ *   into two integer coefficients per scale, so a conversion is a multiply,
+ *   a subtraction and a shift, without floating point arithmetic, which the
+ *   Cortex-M3 does in software.
+ *
+ *   Samples of the ADC oversampling mode, or averages of samples, can be
+ *   converted with TEMPCONV_OVS_BITS fraction bits, a 16 bit sample for the
+ *   default of 4, with TEMPCONV_CentiCelsiusOvs() and
+ *   TEMPCONV_CentiFahrenheitOvs().
+ *
+ *   The result is rounded to the nearest hundredth of a degree, and differs
+ *   by less than 0.01 degree from the floating point formula.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ ****************************   CONFIGURATION   ********************************
+ ******************************************************************************/
+
+/** Temperature gradient of the sensor in ADC steps per 100 degrees Celsius,
+ *  with the sign inverted (datasheet: -6.27 steps per degree). */
+#ifndef TEMPCONV_GRADIENT
+#define TEMPCONV_GRADIENT       627
+#endif
+
+/** ADC0_TEMP_0_READ_1V25 offset of chip rev. D, product revision 16 and 17
+ *  (errata, revision 0.6). */
+#ifndef TEMPCONV_REVD_OFFSET
+#define TEMPCONV_REVD_OFFSET    112
+#endif
+
+/** Fraction bits of the samples of TEMPCONV_CentiCelsiusOvs() and
+ *  TEMPCONV_CentiFahrenheitOvs(). */
+#ifndef TEMPCONV_OVS_BITS
+#define TEMPCONV_OVS_BITS       4
+#endif
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+void    TEMPCONV_Init(void);
+void    TEMPCONV_Calibrate(uint32_t calTemp, uint32_t calValue, uint32_t offset);
+int32_t TEMPCONV_CentiCelsius(uint32_t sample);
+int32_t TEMPCONV_CentiFahrenheit(uint32_t sample);
+int32_t TEMPCONV_CentiCelsiusOvs(uint32_t sample);
+int32_t TEMPCONV_CentiFahrenheitOvs(uint32_t sample);
+
+/** @} (end addtogroup TEMPCONV) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TEMPCONV_H */
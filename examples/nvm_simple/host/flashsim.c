@@ -0,0 +1,354 @@
+/***************************************************************************//**
+ * @file
+ * @brief RAM backed flash model for host simulation of the NVM module.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nvm.h"
+#include "nvm_hal.h"
+#include "flashsim.h"
+
+/***************************************************************************//**
+ * @addtogroup NVM
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup FLASHSIM
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ *******************************   STATICS   ***********************************
+ ******************************************************************************/
+
+/* Simulated flash area. */
+static uint8_t  *flashArea;
+static uint32_t flashPages;
+
+/* Wear and traffic counters. */
+static FLASHSIM_Stats_t flashStats;
+
+/* Power cut, operations left before the cut, -1 if disabled. */
+static jmp_buf  *cutEnv;
+static int32_t  cutCountdown = -1;
+
+/* Write failure, word programs left before the failure, -1 if disabled. */
+static int32_t  failCountdown = -1;
+
+/* State of the pseudo random generator. */
+static uint32_t randomState = 1;
+
+/*******************************************************************************
+ ***************************   LOCAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Stop the simulation on an access the flash would not allow.
+ ******************************************************************************/
+static void FlashFault(char const *msg, uint8_t *pAddress)
+{
+  fprintf(stderr, "flashsim: %s at offset 0x%lx\n",
+          msg, (unsigned long) (pAddress - flashArea));
+  abort();
+}
+
+/***************************************************************************//**
+ * @brief Check that a range is inside the flash area.
+ ******************************************************************************/
+static void FlashCheck(uint8_t *pAddress, uint32_t len)
+{
+  if ((pAddress < flashArea)
+      || (pAddress + len > flashArea + flashPages * NVM_PAGE_SIZE))
+    FlashFault("access outside flash area", pAddress);
+}
+
+/***************************************************************************//**
+ * @brief Count down to a power cut.
+ *
+ * @return true if power is cut at this operation.
+ ******************************************************************************/
+static bool PowerCut(void)
+{
+  if (cutCountdown < 0)
+    return false;
+
+  if (cutCountdown == 0)
+  {
+    cutCountdown = -1;
+    return true;
+  }
+
+  cutCountdown--;
+  return false;
+}
+
+/***************************************************************************//**
+ * @brief Count down to a failing word program.
+ *
+ * @return true if this word program fails.
+ ******************************************************************************/
+static bool WriteFail(void)
+{
+  if (failCountdown < 0)
+    return false;
+
+  if (failCountdown == 0)
+  {
+    failCountdown = -1;
+    return true;
+  }
+
+  failCountdown--;
+  return false;
+}
+
+/*******************************************************************************
+ **************************   GLOBAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Set up the model on a flash area and clear all counters.
+ *
+ * @param[in] area
+ *   Page aligned buffer holding the flash contents.
+ *
+ * @param[in] pages
+ *   Number of flash pages in the area, at most FLASHSIM_MAX_PAGES.
+ ******************************************************************************/
+void FLASHSIM_Init(uint8_t *area, uint32_t pages)
+{
+  flashArea     = area;
+  flashPages    = pages;
+  cutCountdown  = -1;
+  failCountdown = -1;
+  FLASHSIM_StatsReset();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the wear and traffic counters.
+ ******************************************************************************/
+void FLASHSIM_StatsGet(FLASHSIM_Stats_t *stats)
+{
+  *stats = flashStats;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Clear the wear and traffic counters.
+ ******************************************************************************/
+void FLASHSIM_StatsReset(void)
+{
+  memset(&flashStats, 0, sizeof(flashStats));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Arm or disarm a power cut.
+ *
+ * @param[in] env
+ *   Jump buffer to return to when power is cut.
+ *
+ * @param[in] operations
+ *   Number of word programs and page erases that complete before the cut,
+ *   -1 to disable.
+ ******************************************************************************/
+void FLASHSIM_PowerCutSet(jmp_buf *env, int32_t operations)
+{
+  cutEnv       = env;
+  cutCountdown = operations;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Arm or disarm a failing word program.
+ *
+ * @param[in] operations
+ *   Number of word programs that complete before one fails, -1 to disable.
+ ******************************************************************************/
+void FLASHSIM_WriteFailSet(int32_t operations)
+{
+  failCountdown = operations;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Pseudo random number, the same sequence on every host.
+ ******************************************************************************/
+uint32_t FLASHSIM_Random(void)
+{
+  randomState = randomState * 1103515245UL + 12345UL;
+  return (randomState >> 16) & 0x7FFF;
+}
+
+/*******************************************************************************
+ ****************************   NVM HAL MODEL   ********************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Nothing to prepare on the host.
+ ******************************************************************************/
+void NVMHAL_Init(void)
+{
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Nothing to release on the host.
+ ******************************************************************************/
+void NVMHAL_DeInit(void)
+{
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Read data from the flash area.
+ ******************************************************************************/
+void NVMHAL_Read(uint8_t *pAddress, void *pObject, uint16_t len)
+{
+  FlashCheck(pAddress, len);
+  memcpy(pObject, pAddress, len);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Program data word by word, a partial last word is padded with ones.
+ *   A failing word is not programmed, and neither are the words after it.
+ ******************************************************************************/
+NVM_Result_t NVMHAL_Write(uint8_t *pAddress, void const *pObject, uint16_t len)
+{
+  uint8_t const *pData = (uint8_t const *) pObject;
+  uint8_t       word[4];
+  uint32_t      i;
+  uint32_t      j;
+
+  if (((uintptr_t) pAddress & 3) != 0)
+    FlashFault("unaligned write", pAddress);
+  FlashCheck(pAddress, (len + 3) & ~3);
+
+  for (i = 0; i < len; i += 4)
+  {
+    memset(word, 0xFF, sizeof(word));
+    memcpy(word, pData + i, (len - i < 4) ? (len - i) : 4);
+
+    for (j = 0; j < 4; j++)
+    {
+      if ((~pAddress[i + j] & word[j]) != 0)
+        FlashFault("programming a bit from 0 to 1", pAddress + i + j);
+    }
+
+    if (PowerCut())
+    {
+      /* Only some of the bits were programmed. */
+      for (j = 0; j < 4; j++)
+        pAddress[i + j] &= word[j] | (uint8_t) FLASHSIM_Random();
+      longjmp(*cutEnv, 1);
+    }
+
+    if (WriteFail())
+    {
+      flashStats.writeFails++;
+      return nvmResultError;
+    }
+
+    for (j = 0; j < 4; j++)
+      pAddress[i + j] &= word[j];
+    flashStats.wordWrites++;
+  }
+
+  return nvmResultOk;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Erase a flash page and count the erase.
+ ******************************************************************************/
+NVM_Result_t NVMHAL_PageErase(uint8_t *pAddress)
+{
+  uint32_t page;
+  uint32_t i;
+
+  if (((pAddress - flashArea) % NVM_PAGE_SIZE) != 0)
+    FlashFault("unaligned page erase", pAddress);
+  FlashCheck(pAddress, NVM_PAGE_SIZE);
+
+  page = (pAddress - flashArea) / NVM_PAGE_SIZE;
+
+  if (PowerCut())
+  {
+    /* Only some of the words were erased. */
+    for (i = 0; i < NVM_PAGE_SIZE; i += 4)
+    {
+      if (FLASHSIM_Random() & 1)
+        memset(pAddress + i, 0xFF, 4);
+    }
+    flashStats.eraseCount[page]++;
+    longjmp(*cutEnv, 1);
+  }
+
+  memset(pAddress, 0xFF, NVM_PAGE_SIZE);
+  flashStats.pageErases++;
+  flashStats.eraseCount[page]++;
+
+  return nvmResultOk;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   CRC-CCITT checksum, the same algorithm as the target HAL.
+ ******************************************************************************/
+void NVMHAL_Checksum(uint16_t *checksum, void *pMemory, uint16_t len)
+{
+  uint8_t *pData = (uint8_t *) pMemory;
+  uint16_t crc   = *checksum;
+
+  while (len--)
+  {
+    crc  = (crc >> 8) | (crc << 8);
+    crc ^= *pData++;
+    crc ^= (crc & 0xFF) >> 4;
+    crc ^= crc << 12;
+    crc ^= (crc & 0xFF) << 5;
+  }
+
+  *checksum = crc;
+}
+
+/** @} (end addtogroup FLASHSIM) */
+/** @} (end addtogroup NVM) */
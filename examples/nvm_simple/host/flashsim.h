@@ -0,0 +1,107 @@
+/***************************************************************************//**
+ * @file
+ * @brief RAM backed flash model for host simulation of the NVM module.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __FLASHSIM_H
+#define __FLASHSIM_H
+
+#include <stdint.h>
+#include <setjmp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup NVM
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @defgroup FLASHSIM
+ * @brief Flash model implementing the NVM HAL (nvm_hal.h) on a RAM buffer.
+ * @details
+ *   The model behaves like the internal flash: programming can only clear
+ *   bits, and a page must be erased to set them again. Any attempt to set a
+ *   bit by programming, or to access memory outside the flash area, aborts
+ *   the simulation.
+ *
+ *   Every word program and page erase is counted, and power can be cut at
+ *   any of them. A cut leaves the word being programmed (or the page being
+ *   erased) in a random, partially written state and returns to the
+ *   setjmp() point given to FLASHSIM_PowerCutSet().
+ *
+ *   A word program can also be made to fail with FLASHSIM_WriteFailSet().
+ *   The word is left unprogrammed, and NVMHAL_Write() returns an error.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ ****************************   CONFIGURATION   ********************************
+ ******************************************************************************/
+
+/** Maximum number of flash pages in the model. */
+#define FLASHSIM_MAX_PAGES    64
+
+/*******************************************************************************
+ ******************************   TYPEDEFS   ***********************************
+ ******************************************************************************/
+
+/** Wear and traffic counters of the flash model. */
+typedef struct
+{
+  uint32_t wordWrites;                       /**< Words programmed.           */
+  uint32_t pageErases;                       /**< Pages erased.               */
+  uint32_t writeFails;                       /**< Word programs failed.       */
+  uint32_t eraseCount[FLASHSIM_MAX_PAGES];   /**< Erases of every page.       */
+} FLASHSIM_Stats_t;
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+void     FLASHSIM_Init(uint8_t *area, uint32_t pages);
+void     FLASHSIM_StatsGet(FLASHSIM_Stats_t *stats);
+void     FLASHSIM_StatsReset(void);
+void     FLASHSIM_PowerCutSet(jmp_buf *env, int32_t operations);
+void     FLASHSIM_WriteFailSet(int32_t operations);
+uint32_t FLASHSIM_Random(void);
+
+/** @} (end defgroup FLASHSIM) */
+/** @} (end addtogroup NVM) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLASHSIM_H */
@@ -0,0 +1,580 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host simulator and benchmark for the nvm_simple NVM configuration.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <unistd.h>
+
+#include "nvm_config.h"
+#include "nvm_log.h"
+#include "flashsim.h"
+
+/******************************************************************************
+*  Runs the NVM configuration of the nvm_simple example (nvm_config.c and
+*  nvm_log.c) on a RAM backed flash model.
+*
+*  The benchmark replays the key pattern of the example: short bursts of PB1
+*  releases, each storing the counter to the "wear" page, mixed with stores
+*  and recalls of the "normal" page and resets. It reports erase counts of
+*  every flash page, write amplification and the projected flash life.
+*
+*  The power fail test repeats every store with power cut at each of its word
+*  programs and page erases in turn, and checks that the restore sequence of
+*  APP_RestoreData() then finds either the old or the new value of every page.
+*
+*  The write fail test fails a word program at each of the word programs of a
+*  transaction in turn, and checks that a committed transaction is stored by
+*  the next transaction, or by a restore.
+*
+*  usage: nvmsim [-s scratch pages] [-n stores] [-p power fail stores]
+*                [-w write fail stores]
+******************************************************************************/
+
+/* Defaults, scratch pages as NVM_PAGES_SCRATCH in nvm_config.c */
+#define DEFAULT_SCRATCH_PAGES     3
+#define DEFAULT_STORES            100000
+#define DEFAULT_POWERFAIL_STORES  2000
+#define DEFAULT_WRITEFAIL_STORES  200
+
+/* Erase cycles guaranteed for the internal flash of the EFM32GG. */
+#define FLASH_ENDURANCE           20000
+
+#define MAX_DISPLAYABLE_NUMBER    9999
+
+/* Marks a page which has not been stored yet. */
+#define VALUE_NONE                0xFFFFFFFFUL
+
+/* Simulated flash area and configuration. */
+static uint8_t       *simArea;
+static NVM_Config_t  *simConfig;
+
+/* Expected contents of the pages. */
+static uint32_t      expectedNormal = VALUE_NONE;
+static uint32_t      expectedWear   = VALUE_NONE;
+
+/* Benchmark counters. */
+static uint32_t      storeCount;
+static uint32_t      readCount;
+static uint32_t      resetCount;
+static uint32_t      logicalBytes;
+
+/**************************************************************************//**
+ * @brief Stop the simulation with a message
+ *****************************************************************************/
+static void SIM_Fatal(char const *msg, uint32_t value)
+{
+  fprintf(stderr, "nvmsim: %s (%lu)\n", msg, (unsigned long) value);
+  exit(1);
+}
+
+/**************************************************************************//**
+ * @brief Set up a configuration with the pages of the example on RAM flash
+ *****************************************************************************/
+static void SIM_ConfigCreate(uint32_t scratchPages)
+{
+  NVM_Config_t const *example = NVM_ConfigGet();
+  uint32_t           pages    = example->userPages + scratchPages;
+  NVM_Config_t const config   = { example->nvmPages, pages, example->userPages, NULL };
+
+  /* Transactions use one scratch page, consolidation another. */
+  if ((scratchPages < 2) || (pages > FLASHSIM_MAX_PAGES))
+    SIM_Fatal("invalid number of scratch pages, minimum 2", scratchPages);
+
+  if (posix_memalign((void **) &simArea, NVM_PAGE_SIZE, pages * NVM_PAGE_SIZE) != 0)
+    SIM_Fatal("out of memory", pages);
+
+  /* Contents after flashing the example, see nvmData in nvm_config.c */
+  memset(simArea, 0, pages * NVM_PAGE_SIZE);
+  simArea[0] = 0xFF;
+
+  simConfig = malloc(sizeof(NVM_Config_t));
+  if (simConfig == NULL)
+    SIM_Fatal("out of memory", pages);
+  memcpy(simConfig, &config, sizeof(NVM_Config_t));
+  simConfig->nvmArea = simArea;
+
+  FLASHSIM_Init(simArea, pages);
+}
+
+/**************************************************************************//**
+ * @brief Store the "wear" page, and the "normal" page if selected, in a
+ *        transaction
+ *****************************************************************************/
+static NVM_Result_t SIM_TransactionStore(bool normal)
+{
+  NVM_Result_t result;
+
+  result = NVMLOG_TransactionBegin();
+  if ((result == nvmResultOk) && normal)
+    result = NVMLOG_Write(PAGE_NORMAL_ID, NVM_WRITE_ALL_CMD);
+  if (result == nvmResultOk)
+    result = NVMLOG_Write(PAGE_WEAR_ID, NVM_WRITE_ALL_CMD);
+  if (result == nvmResultOk)
+    result = NVMLOG_TransactionCommit();
+
+  return result;
+}
+
+/**************************************************************************//**
+ * @brief Store a page as the example does
+ *
+ * @details
+ *   The "wear" page is stored alone as in APP_StoreData(), the "normal" page
+ *   together with the "wear" page in a transaction as in APP_StoreAllData().
+ *****************************************************************************/
+static void SIM_StoreData(NVM_Page_Ids page)
+{
+  NVM_Result_t result;
+
+  if (page == PAGE_WEAR_ID)
+  {
+    result = NVMLOG_Write(PAGE_WEAR_ID, NVM_WRITE_ALL_CMD);
+  }
+  else
+  {
+    result = SIM_TransactionStore(true);
+  }
+
+  if (result != nvmResultOk)
+    SIM_Fatal("store failed, page", page);
+
+  storeCount++;
+  logicalBytes += sizeof(nvm_counter);
+
+  expectedWear = nvm_counter;
+  if (page == PAGE_NORMAL_ID)
+    expectedNormal = nvm_counter;
+}
+
+/**************************************************************************//**
+ * @brief Reset and restore data, same sequence as APP_RestoreData()
+ *****************************************************************************/
+static NVM_Result_t SIM_RestoreData(void)
+{
+  NVM_Result_t result;
+
+  nvm_counter = 0;
+  result = NVMLOG_Init(simConfig, NVM_LayoutGet());
+
+  if (result == nvmResultOk)
+  {
+    result = NVMLOG_Read(PAGE_WEAR_ID, COUNTER_ID);
+    if (result == nvmResultNoPage)
+      result = NVMLOG_Read(PAGE_NORMAL_ID, COUNTER_ID);
+
+    if (result == nvmResultNoPage)
+    {
+      SIM_StoreData(PAGE_NORMAL_ID);
+      result = nvmResultOk;
+    }
+  }
+
+  return result;
+}
+
+/**************************************************************************//**
+ * @brief Read the value stored in a page, VALUE_NONE if not stored
+ *****************************************************************************/
+static uint32_t SIM_PageValue(NVM_Page_Ids page)
+{
+  nvm_counter = 0;
+  if (NVMLOG_Read(page, COUNTER_ID) != nvmResultOk)
+    return VALUE_NONE;
+
+  return nvm_counter;
+}
+
+/**************************************************************************//**
+ * @brief Check that both pages hold either their old or their new values
+ *****************************************************************************/
+static bool SIM_StateCheck(uint32_t oldWear, uint32_t oldNormal,
+                           uint32_t newWear, uint32_t newNormal)
+{
+  uint32_t wear   = SIM_PageValue(PAGE_WEAR_ID);
+  uint32_t normal = SIM_PageValue(PAGE_NORMAL_ID);
+
+  return ((wear == oldWear) && (normal == oldNormal))
+         || ((wear == newWear) && (normal == newNormal));
+}
+
+/**************************************************************************//**
+ * @brief Pick the next user action, returns the page to store
+ *
+ * @details
+ *   Most actions are PB1 releases after counting up for a while, which store
+ *   the "wear" page. Some are PB0 long presses storing the "normal" page.
+ *****************************************************************************/
+static NVM_Page_Ids SIM_NextStore(void)
+{
+  if ((FLASHSIM_Random() % 100) < 90)
+  {
+    nvm_counter += 1 + FLASHSIM_Random() % 20;
+    if (nvm_counter > MAX_DISPLAYABLE_NUMBER)
+      nvm_counter = 0;
+    return PAGE_WEAR_ID;
+  }
+
+  return PAGE_NORMAL_ID;
+}
+
+/**************************************************************************//**
+ * @brief Replay user actions and check every read
+ *****************************************************************************/
+static void SIM_Benchmark(uint32_t stores)
+{
+  uint32_t action;
+
+  while (storeCount < stores)
+  {
+    action = FLASHSIM_Random() % 100;
+
+    if (action < 90)
+    {
+      SIM_StoreData(SIM_NextStore());
+    }
+    else if (action < 97)
+    {
+      /* PB0 short press, recall the "normal" page */
+      if (NVMLOG_Read(PAGE_NORMAL_ID, COUNTER_ID) != nvmResultOk)
+        SIM_Fatal("recall failed at store", storeCount);
+      if (nvm_counter != expectedNormal)
+        SIM_Fatal("recalled wrong value at store", storeCount);
+      readCount++;
+    }
+    else
+    {
+      if (SIM_RestoreData() != nvmResultOk)
+        SIM_Fatal("restore failed at store", storeCount);
+      if (nvm_counter != expectedWear)
+        SIM_Fatal("restored wrong value at store", storeCount);
+      resetCount++;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief Print wear statistics of the benchmark
+ *****************************************************************************/
+static void SIM_Report(void)
+{
+  FLASHSIM_Stats_t stats;
+  uint32_t         minErase = UINT32_MAX;
+  uint32_t         maxErase = 0;
+  uint32_t         i;
+  double           life;
+
+  FLASHSIM_StatsGet(&stats);
+
+  printf("configuration    : %u user pages, %u scratch pages\n",
+         (unsigned) simConfig->userPages,
+         (unsigned) (simConfig->pages - simConfig->userPages));
+  printf("actions          : %lu stores, %lu recalls, %lu resets\n",
+         (unsigned long) storeCount, (unsigned long) readCount,
+         (unsigned long) resetCount);
+  printf("flash traffic    : %lu words programmed, %lu pages erased\n",
+         (unsigned long) stats.wordWrites, (unsigned long) stats.pageErases);
+  printf("write amplif.    : %.2f (bytes programmed per byte stored)\n",
+         (4.0 * stats.wordWrites) / logicalBytes);
+  printf("stores per erase : %.1f\n",
+         stats.pageErases ? (double) storeCount / stats.pageErases : 0.0);
+
+  printf("erases per page  :");
+  for (i = 0; i < simConfig->pages; i++)
+  {
+    printf(" %lu", (unsigned long) stats.eraseCount[i]);
+    if (stats.eraseCount[i] < minErase)
+      minErase = stats.eraseCount[i];
+    if (stats.eraseCount[i] > maxErase)
+      maxErase = stats.eraseCount[i];
+  }
+  printf("\n");
+  printf("wear spread      : min %lu, max %lu\n",
+         (unsigned long) minErase, (unsigned long) maxErase);
+
+  if (maxErase > 0)
+  {
+    life = (double) storeCount * FLASH_ENDURANCE / maxErase;
+    printf("projected life   : %.0f stores (%.1f years at 1000 stores/day)\n",
+           life, life / 1000.0 / 365.0);
+  }
+
+  /* Counters kept in flash by the log, including erases of the first boot. */
+  printf("log erase counts :");
+  for (i = 0; i < simConfig->pages; i++)
+    printf(" %lu", (unsigned long) NVMLOG_EraseCountGet(i));
+  printf(" (%lu cycles left)\n", (unsigned long) NVMLOG_EraseCyclesLeft());
+}
+
+/**************************************************************************//**
+ * @brief Store a page with power cut after a number of flash operations
+ *
+ * @return true if the store completed before the cut
+ *****************************************************************************/
+static bool SIM_StoreDataCut(NVM_Page_Ids page, int32_t cut)
+{
+  static jmp_buf env;
+
+  if (setjmp(env) != 0)
+    return false;
+
+  FLASHSIM_PowerCutSet(&env, cut);
+  SIM_StoreData(page);
+  FLASHSIM_PowerCutSet(NULL, -1);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Cut power at every flash operation of every store
+ *****************************************************************************/
+static void SIM_PowerFailTest(uint32_t stores)
+{
+  uint8_t      *snapshot;
+  uint32_t     size = simConfig->pages * NVM_PAGE_SIZE;
+  uint32_t     oldWear;
+  uint32_t     oldNormal;
+  uint32_t     newValue;
+  uint32_t     cuts = 0;
+  uint32_t     failures = 0;
+  int32_t      cut;
+  NVM_Page_Ids page;
+  uint32_t     i;
+
+  snapshot = malloc(size);
+  if (snapshot == NULL)
+    SIM_Fatal("out of memory", size);
+
+  for (i = 0; i < stores; i++)
+  {
+    page      = SIM_NextStore();
+    newValue  = nvm_counter;
+    oldWear   = expectedWear;
+    oldNormal = expectedNormal;
+    memcpy(snapshot, simArea, size);
+
+    for (cut = 0; ; cut++)
+    {
+      /* Start every attempt from the flash contents before the store. */
+      memcpy(simArea, snapshot, size);
+      if (NVMLOG_Init(simConfig, NVM_LayoutGet()) != nvmResultOk)
+        SIM_Fatal("init failed at power fail store", i);
+      nvm_counter = newValue;
+
+      if (SIM_StoreDataCut(page, cut))
+        break;
+
+      /* Power was cut, restore and check both pages. */
+      cuts++;
+      if ((SIM_RestoreData() != nvmResultOk)
+          || !SIM_StateCheck(oldWear, oldNormal, newValue,
+                             (page == PAGE_NORMAL_ID) ? newValue : oldNormal))
+      {
+        failures++;
+        printf("inconsistent state at store %lu, cut after %ld operations\n",
+               (unsigned long) i, (long) cut);
+      }
+    }
+
+  }
+
+  free(snapshot);
+
+  printf("power fail test  : %lu stores, %lu power cuts, %lu failures\n",
+         (unsigned long) stores, (unsigned long) cuts, (unsigned long) failures);
+
+  if (failures != 0)
+    exit(1);
+}
+
+/**************************************************************************//**
+ * @brief Store both pages in a transaction from the flash contents given,
+ *        with a word program failing after a number of word programs
+ *
+ * @return true if a word program failed
+ *****************************************************************************/
+static bool SIM_StoreDataFail(uint8_t const *flash, uint32_t value, int32_t fail)
+{
+  FLASHSIM_Stats_t before;
+  FLASHSIM_Stats_t after;
+
+  memcpy(simArea, flash, simConfig->pages * NVM_PAGE_SIZE);
+  if (NVMLOG_Init(simConfig, NVM_LayoutGet()) != nvmResultOk)
+    SIM_Fatal("init failed at write fail", fail);
+
+  FLASHSIM_StatsGet(&before);
+  nvm_counter = value;
+  FLASHSIM_WriteFailSet(fail);
+  SIM_TransactionStore(true);
+  FLASHSIM_WriteFailSet(-1);
+  FLASHSIM_StatsGet(&after);
+
+  return after.writeFails != before.writeFails;
+}
+
+/**************************************************************************//**
+ * @brief Fail a word program at every word program of every transaction
+ *
+ * @details
+ *   After the failure the transaction must either be lost, or be stored
+ *   completely by the next transaction, which only stores the "wear" page,
+ *   and by a restore. Which of them is taken from a restore right after the
+ *   failure.
+ *****************************************************************************/
+static void SIM_WriteFailTest(uint32_t stores)
+{
+  uint8_t      *snapshot;
+  uint32_t     size = simConfig->pages * NVM_PAGE_SIZE;
+  uint32_t     oldWear;
+  uint32_t     oldNormal;
+  uint32_t     value;
+  uint32_t     next;
+  uint32_t     normal;
+  uint32_t     writeFails = 0;
+  uint32_t     failures = 0;
+  bool         consistent;
+  int32_t      fail;
+  uint32_t     i;
+
+  snapshot = malloc(size);
+  if (snapshot == NULL)
+    SIM_Fatal("out of memory", size);
+
+  for (i = 0; i < stores; i++)
+  {
+    oldWear   = expectedWear;
+    oldNormal = expectedNormal;
+    value     = (oldWear + 1) % (MAX_DISPLAYABLE_NUMBER + 1);
+    next      = (value + 1) % (MAX_DISPLAYABLE_NUMBER + 1);
+    memcpy(snapshot, simArea, size);
+
+    for (fail = 0; SIM_StoreDataFail(snapshot, value, fail); fail++)
+    {
+      writeFails++;
+
+      /* Restore right after the failure. */
+      consistent = (NVMLOG_Init(simConfig, NVM_LayoutGet()) == nvmResultOk)
+                   && SIM_StateCheck(oldWear, oldNormal, value, value);
+      normal     = SIM_PageValue(PAGE_NORMAL_ID);
+
+      /* The next transaction without restore, and a restore after it. */
+      SIM_StoreDataFail(snapshot, value, fail);
+      nvm_counter = next;
+      consistent  = consistent
+                    && (SIM_TransactionStore(false) == nvmResultOk)
+                    && SIM_StateCheck(next, normal, next, normal)
+                    && (NVMLOG_Init(simConfig, NVM_LayoutGet()) == nvmResultOk)
+                    && SIM_StateCheck(next, normal, next, normal);
+
+      if (!consistent)
+      {
+        failures++;
+        printf("inconsistent state at store %lu, write failed after %ld words\n",
+               (unsigned long) i, (long) fail);
+      }
+    }
+
+    /* Continue from the store without failure. */
+    memcpy(simArea, snapshot, size);
+    if (NVMLOG_Init(simConfig, NVM_LayoutGet()) != nvmResultOk)
+      SIM_Fatal("init failed at write fail store", i);
+    nvm_counter = value;
+    SIM_StoreData(PAGE_NORMAL_ID);
+  }
+
+  free(snapshot);
+
+  printf("write fail test  : %lu stores, %lu write failures, %lu failures\n",
+         (unsigned long) stores, (unsigned long) writeFails,
+         (unsigned long) failures);
+
+  if (failures != 0)
+    exit(1);
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+  uint32_t scratchPages    = DEFAULT_SCRATCH_PAGES;
+  uint32_t stores          = DEFAULT_STORES;
+  uint32_t powerFailStores = DEFAULT_POWERFAIL_STORES;
+  uint32_t writeFailStores = DEFAULT_WRITEFAIL_STORES;
+  int      opt;
+
+  while ((opt = getopt(argc, argv, "s:n:p:w:")) != -1)
+  {
+    switch (opt)
+    {
+    case 's':
+      scratchPages = strtoul(optarg, NULL, 0);
+      break;
+    case 'n':
+      stores = strtoul(optarg, NULL, 0);
+      break;
+    case 'p':
+      powerFailStores = strtoul(optarg, NULL, 0);
+      break;
+    case 'w':
+      writeFailStores = strtoul(optarg, NULL, 0);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-s scratch pages] [-n stores] [-p power fail stores]"
+                      " [-w write fail stores]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  SIM_ConfigCreate(scratchPages);
+
+  /* First boot after flashing, not counted in the benchmark. */
+  if (SIM_RestoreData() != nvmResultOk)
+    SIM_Fatal("first restore failed", 0);
+  FLASHSIM_StatsReset();
+  storeCount   = 0;
+  logicalBytes = 0;
+
+  SIM_Benchmark(stores);
+  SIM_Report();
+
+  SIM_PowerFailTest(powerFailStores);
+  SIM_WriteFailTest(writeFailStores);
+
+  return 0;
+}
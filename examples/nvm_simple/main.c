@@ -48,7 +48,8 @@
 #include "segmentlcd.h"
 
 #include "nvm_config.h"
-#include "nvm.h"
+#include "nvm_log.h"
+#include "nvm_defer.h"
 
 /******************************************************************************
 *  This example shows simple usage of NVM module.
@@ -61,9 +62,20 @@
 *  change. In this example on two pages same object is stored but NVM could handle
 *  multiple pages with different objects.
 *
+*  Both pages are kept in a log (nvm_log.c). The "normal" page compares objects
+*  with their last stored copy and only appends the ones that have changed, the
+*  "wear" page appends a new version of its object with a sequence number on
+*  every store. Most stores cost a few word writes instead of a page erase.
+*  A transaction stores both pages together, so after a reset they never hold
+*  different values of the counter.
+*
+*  Counting does not write flash directly: the "wear" page is marked as changed
+*  (nvm_defer.c) and written by the RTC scheduled store once PB1 has not been
+*  used for NVMDEFER_DELAY_MS, so a burst of counts costs a single write.
+*
 *  PB0 - short press recalls data from "normal" page
-*  PB0 - long press store data to "normal" page
-*  PB1 - counts up, and after releasing stores data to "wear" page
+*  PB0 - long press store data to "normal" and "wear" page in one transaction
+*  PB1 - counts up, and shortly after the last release stores data to "wear" page
 *
 *  RESET - resets CPU and if there were valid data in NVM recovers last data value.
 *
@@ -179,14 +191,14 @@ void APP_Fatal(uint32_t pulses)
 }
 
 /**************************************************************************//**
- * @brief Store objects to specific page (volume)
+ * @brief Store objects to all changed pages (volumes)
  *****************************************************************************/
-NVM_Result_t  APP_StoreData(NVM_Page_Ids page)
+NVM_Result_t  APP_StoreData(void)
 {
   NVM_Result_t result;
 
   BSP_LedsSet(LED_STORE_ON);
-  result = NVM_Write(page, NVM_WRITE_ALL_CMD);
+  result = NVMDEFER_Flush();
   BSP_LedsSet(LED_ALL_OFF);
 
   if (result != nvmResultOk)
@@ -195,6 +207,17 @@ NVM_Result_t  APP_StoreData(NVM_Page_Ids page)
   return result;
 }
 
+/**************************************************************************//**
+ * @brief Store objects to all pages (volumes) in one transaction
+ *****************************************************************************/
+NVM_Result_t  APP_StoreAllData(void)
+{
+  NVMDEFER_Mark(PAGE_NORMAL_ID);
+  NVMDEFER_Mark(PAGE_WEAR_ID);
+
+  return APP_StoreData();
+}
+
 /**************************************************************************//**
  * @brief Read objects from page (volume)
  *****************************************************************************/
@@ -203,7 +226,7 @@ NVM_Result_t  APP_ReadData(NVM_Page_Ids page)
   NVM_Result_t result;
 
   BSP_LedsSet(LED_READ_ON);
-  result = NVM_Read(page, COUNTER_ID);
+  result = NVMLOG_Read(page, COUNTER_ID);
   BSP_LedsSet(LED_ALL_OFF);
 
   if (result != nvmResultOk)
@@ -218,31 +241,23 @@ NVM_Result_t  APP_RestoreData(void)
 {
   NVM_Result_t result;
 
-  /* initialize NVM module */
-  result = NVM_Init(NVM_ConfigGet());
-
-  if (result == nvmResultError)
-  { /* Ups, looks like no valid data in flash! */
-    /* This could happen on first run after flashing. */
-    /* So, we have to erase NVM */
-    BSP_LedsSet(LED_STORE_ON);
-    result = NVM_Erase(0);
-
-    /* Store initial data/configuration */
-    if (result == nvmResultOk)
-      result = APP_StoreData(PAGE_NORMAL_ID);
-    /* if wear page contains different data/object than normal page */
-    /* it could be resonable to write wear page here too. */
-    BSP_LedsSet(LED_ALL_OFF);
-  }
+  /* initialize NVM module, pages without valid data (e.g. on first run */
+  /* after flashing) are erased here */
+  BSP_LedsSet(LED_STORE_ON);
+  result = NVMLOG_Init(NVM_ConfigGet(), NVM_LayoutGet());
+  BSP_LedsSet(LED_ALL_OFF);
 
   /* if init phase went correctly, try to restore data. */
   if (result == nvmResultOk)
   { /* Try to restore data from wear page, if failed read it from normal page */
     BSP_LedsSet(LED_READ_ON);
-    result = NVM_Read(PAGE_WEAR_ID, COUNTER_ID);
+    result = NVMLOG_Read(PAGE_WEAR_ID, COUNTER_ID);
     if (result == nvmResultNoPage)
-      result = APP_ReadData(PAGE_NORMAL_ID);
+      result = NVMLOG_Read(PAGE_NORMAL_ID, COUNTER_ID);
+
+    /* Store initial data/configuration on first run */
+    if (result == nvmResultNoPage)
+      result = APP_StoreAllData();
   }
   BSP_LedsSet(LED_ALL_OFF);
 
@@ -271,6 +286,9 @@ int main(void)
   /* configure GPIO */
   APP_GpioSetup();
 
+  /* configure RTC for deferred stores */
+  NVMDEFER_Init();
+
   if (APP_RestoreData() != nvmResultOk)
     APP_Fatal(FATAL_AT_INIT);
 
@@ -280,6 +298,9 @@ int main(void)
     SegmentLCD_Write("SLEEP");
     /* go to sleep and wait for key pressing */
     EMU_EnterEM2(false);
+    /* store changes once no more were made for a while */
+    if (NVMDEFER_Due())
+      APP_StoreData();
     if (!GPIO_PinInGet(KEY_PB0_PIN))  /* PB0 */
     {
       j = 0;
@@ -289,12 +310,13 @@ int main(void)
       if (!GPIO_PinInGet(KEY_PB0_PIN))
       { /* store */
         SegmentLCD_Write("STORE");
-        APP_StoreData(PAGE_NORMAL_ID);
+        APP_StoreAllData();
       }
       else
       {
         /* restore */
         SegmentLCD_Write("RECALL");
+        APP_StoreData();  /* do not lose counts not yet stored */
         APP_ReadData(PAGE_NORMAL_ID);
       }
       APP_BusyWait(DELAY_AFTER_PB1);  /* delay to keep displayed text */
@@ -310,7 +332,7 @@ int main(void)
           nvm_counter = 0;
         SegmentLCD_Number(nvm_counter);
       }
-      APP_StoreData(PAGE_WEAR_ID);
+      NVMDEFER_Mark(PAGE_WEAR_ID);
     }
   }
 }
@@ -34,6 +34,7 @@
  *****************************************************************************/
 #include "nvm_config.h"
 #include "nvm.h"
+#include "nvm_layout.h"
 #include <stddef.h>
 
 /***************************************************************************//**
@@ -51,7 +52,8 @@
  ******************************************************************************/
 
 /** Configure extra pages to allocate for data security and wear leveling.
- * Minimum 1, but the more you add the better lifetime your system will have. */
+ * Minimum 1, but the more you add the better lifetime your system will have.
+ * Transactions (see APP_StoreAllData() in main.c) need minimum 2. */
 #define NVM_PAGES_SCRATCH    3
 
 /* Objects. */
@@ -59,32 +61,33 @@ uint16_t  nvm_counter = 0;
 
 /* Page definition.
  * Combine objects with their id, and put them in a page. */
-static NVM_Page_t const nvmPageNormal =
-{
-/*{Pointer to object,          Size of object,         Object ID}, */
-  { (uint8_t *) &nvm_counter,  sizeof(nvm_counter),   COUNTER_ID },
-  NVM_PAGE_TERMINATION /* Null termination of table. Do not remove! */
-};
+#define NVM_PAGE_NORMAL_OBJECTS(X, page) \
+/*X(page, Object ID,  Object), */        \
+  X(page, COUNTER_ID, nvm_counter)
 
 /* Page definition.
  * Combine objects with their id, and put them in a page.
  * This page contains only one object, since it is going to be
  * used as a wear page. */
-static NVM_Page_t const nvmPageWear =
-{
-/*{Pointer to object,   Size of object,   Object ID}, */
-  { (uint8_t *) &nvm_counter,  sizeof(nvm_counter),   COUNTER_ID },
-  NVM_PAGE_TERMINATION /* Null termination of table. Do not remove! */
-};
+#define NVM_PAGE_WEAR_OBJECTS(X, page) \
+/*X(page, Object ID,  Object), */      \
+  X(page, COUNTER_ID, nvm_counter)
 
 /* Register pages.
- * Connect pages to page IDs, and define the type of page. */
-static NVM_Page_Table_t const nvmPagesConfig =
-{
-/*{Page ID,      Page pointer,   Page type}, */
-  { PAGE_NORMAL_ID, &nvmPageNormal, nvmPageTypeNormal },
-  { PAGE_WEAR_ID,   &nvmPageWear,   nvmPageTypeWear }
-};
+ * Connect pages to page IDs, and define the type of page.
+ * Both pages are stored in the log (see nvm_log.h): a store to the normal
+ * page appends only the objects that have changed, a store to the wear page
+ * appends a new version of its object. */
+#define NVM_PAGES(X) \
+/*X(Page ID,        Page name,     Objects,                 Page type), */ \
+  X(PAGE_NORMAL_ID, nvmPageNormal, NVM_PAGE_NORMAL_OBJECTS, Normal)        \
+  X(PAGE_WEAR_ID,   nvmPageWear,   NVM_PAGE_WEAR_OBJECTS,   Wear)
+
+/* Generate page tables and the layout of every page for the log, and check
+ * the layout at compile time (see nvm_layout.h). Both pages are stored in one
+ * transaction. */
+NVM_LAYOUT_TABLE(nvmPagesConfig, NVM_PAGES)
+NVM_LAYOUT_ASSERT_TRANSACTION(nvmPagesConfig, NVM_PAGES)
 
 /* end of configuration, below defines should not be changed */
 #define NUMBER_OF_USER_PAGES  (sizeof(nvmPagesConfig)/sizeof(NVM_Page_Descriptor_t))
@@ -131,5 +134,10 @@ NVM_Config_t const *NVM_ConfigGet(void)
   return( &nvmConfig );
 }
 
+NVMLOG_Layout_t const *NVM_LayoutGet(void)
+{
+  return( nvmPagesConfig_layout );
+}
+
 /** @} (end addtogroup test */
 /** @} (end addtogroup NVM) */
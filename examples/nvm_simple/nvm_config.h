@@ -39,6 +39,7 @@
 #include <stdbool.h>
 
 #include "nvm.h"
+#include "nvm_log.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -87,6 +88,7 @@ typedef enum
 extern uint16_t  nvm_counter;
 
 NVM_Config_t const *NVM_ConfigGet(void);
+NVMLOG_Layout_t const *NVM_LayoutGet(void);
 
 /** @} (end defgroup test) */
 /** @} (end addtogroup NVM) */
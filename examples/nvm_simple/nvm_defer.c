@@ -0,0 +1,244 @@
+/***************************************************************************//**
+ * @file
+ * @brief Deferred commit of NVM log writes.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_rtc.h"
+
+#include "nvm_defer.h"
+#include "nvm_log.h"
+
+/***************************************************************************//**
+ * @addtogroup NVM
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup NVMDEFER
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/* RTC clock divisor, the RTC counts 1024 times per second from 32768 Hz. */
+#define NVMDEFER_RTC_DIV         cmuClkDiv_32
+
+/* Page IDs are kept in a 32 bit mask. */
+#define NVMDEFER_MAX_PAGE_IDS    32
+
+/** @endcond */
+
+/*******************************************************************************
+ *******************************   STATICS   ***********************************
+ ******************************************************************************/
+
+/* Pages marked by NVMDEFER_Mark(), one bit per page ID. */
+static uint32_t dirtyPages;
+
+/* Set by the RTC interrupt when no changes were made for NVMDEFER_DELAY_MS. */
+static volatile bool expired;
+
+/* NVMDEFER_DELAY_MS in RTC ticks. */
+static uint32_t delayTicks;
+
+/*******************************************************************************
+ **************************   GLOBAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief RTC interrupt handler, the timeout of the marked pages has expired.
+ ******************************************************************************/
+void RTC_IRQHandler(void)
+{
+  RTC_IntClear(RTC_IFC_COMP0);
+  RTC_IntDisable(RTC_IEN_COMP0);
+  expired = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Initialize deferred writes.
+ *
+ * @details
+ *   The RTC is started as a free running counter from the LFACLK, which must
+ *   already be selected (e.g. by SegmentLCD_Init()). COMP0 is used for the
+ *   timeout.
+ ******************************************************************************/
+void NVMDEFER_Init(void)
+{
+  RTC_Init_TypeDef rtcInit = RTC_INIT_DEFAULT;
+
+  dirtyPages = 0;
+  expired    = false;
+
+  /* Enable LE domain registers and RTC clock */
+  CMU_ClockEnable(cmuClock_CORELE, true);
+  CMU_ClockDivSet(cmuClock_RTC, NVMDEFER_RTC_DIV);
+  CMU_ClockEnable(cmuClock_RTC, true);
+
+  rtcInit.enable   = false;  /* Start RTC after the interrupt is set up. */
+  rtcInit.debugRun = false;  /* Halt RTC when debugging. */
+  rtcInit.comp0Top = false;  /* Free running, COMP0 is moved on every change. */
+  RTC_Init(&rtcInit);
+
+  delayTicks = (CMU_ClockFreqGet(cmuClock_RTC) * NVMDEFER_DELAY_MS) / 1000;
+  EFM_ASSERT((delayTicks > 0) && (delayTicks < _RTC_COMP0_MASK));
+
+  RTC_IntDisable(RTC_IEN_COMP0);
+  RTC_IntClear(RTC_IFC_COMP0);
+  NVIC_ClearPendingIRQ(RTC_IRQn);
+  NVIC_EnableIRQ(RTC_IRQn);
+
+  RTC_Enable(true);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Mark a page as changed.
+ *
+ * @details
+ *   The page is written NVMDEFER_DELAY_MS after the last change of any page.
+ *
+ * @param[in] pageId
+ *   ID of the page whose objects have changed in RAM.
+ ******************************************************************************/
+void NVMDEFER_Mark(uint16_t pageId)
+{
+  EFM_ASSERT(pageId < NVMDEFER_MAX_PAGE_IDS);
+
+  /* Restart the timeout */
+  RTC_IntDisable(RTC_IEN_COMP0);
+  RTC_IntClear(RTC_IFC_COMP0);
+  expired = false;
+
+  dirtyPages |= 1UL << pageId;
+
+  RTC_CompareSet(0, (RTC_CounterGet() + delayTicks) & _RTC_COMP0_MASK);
+  RTC_IntEnable(RTC_IEN_COMP0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check whether any page is marked and not yet written.
+ ******************************************************************************/
+bool NVMDEFER_Pending(void)
+{
+  return dirtyPages != 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check whether the marked pages are due to be written with
+ *   NVMDEFER_Flush().
+ ******************************************************************************/
+bool NVMDEFER_Due(void)
+{
+  return expired && (dirtyPages != 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Write all marked pages now.
+ *
+ * @details
+ *   A single page is written with NVMLOG_Write(), several pages are written in
+ *   one transaction.
+ *
+ * @return
+ *   nvmResultOk on success or if no page is marked, else the result of the
+ *   log. The pages stay marked if they could not be written.
+ ******************************************************************************/
+NVM_Result_t NVMDEFER_Flush(void)
+{
+  NVM_Result_t result = nvmResultOk;
+  uint32_t     pages;
+  uint16_t     pageId;
+  bool         transaction;
+
+  RTC_IntDisable(RTC_IEN_COMP0);
+  expired = false;
+
+  pages = dirtyPages;
+  if (pages == 0)
+    return nvmResultOk;
+
+  /* More than one bit set, store pages together */
+  transaction = (pages & (pages - 1)) != 0;
+  if (transaction)
+    result = NVMLOG_TransactionBegin();
+
+  for (pageId = 0; (pageId < NVMDEFER_MAX_PAGE_IDS) && (result == nvmResultOk); pageId++)
+  {
+    if (pages & (1UL << pageId))
+      result = NVMLOG_Write(pageId, NVM_WRITE_ALL_CMD);
+  }
+
+  if (transaction && (result == nvmResultOk))
+    result = NVMLOG_TransactionCommit();
+
+  if (result == nvmResultOk)
+    dirtyPages = 0;
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Write all marked pages and enter EM4.
+ *
+ * @return
+ *   Only returns if the pages could not be written, with the result of
+ *   NVMDEFER_Flush().
+ ******************************************************************************/
+NVM_Result_t NVMDEFER_EnterEM4(void)
+{
+  NVM_Result_t result;
+
+  result = NVMDEFER_Flush();
+  if (result == nvmResultOk)
+    EMU_EnterEM4();
+
+  return result;
+}
+
+/** @} (end addtogroup NVMDEFER) */
+/** @} (end addtogroup NVM) */
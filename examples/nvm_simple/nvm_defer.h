@@ -0,0 +1,101 @@
+/***************************************************************************//**
+ * @file
+ * @brief Deferred commit of NVM log writes.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __NVMDEFER_H
+#define __NVMDEFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "nvm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup NVM
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @defgroup NVMDEFER
+ * @brief Write-behind scheduling of NVM log writes.
+ * @details
+ *   Instead of writing a page every time one of its objects changes, the
+ *   application marks the page as changed with NVMDEFER_Mark(). The change
+ *   starts (or restarts) an RTC timeout, and when no further changes have
+ *   been made for NVMDEFER_DELAY_MS the marked pages are written with the log
+ *   (see nvm_log.h), several pages in one transaction. A burst of changes
+ *   therefore costs one write, and the core can return to EM2 immediately.
+ *
+ *   The RTC interrupt only wakes the core. The main loop checks
+ *   NVMDEFER_Due() after waking up and then writes the marked pages with
+ *   NVMDEFER_Flush(), so flash is never written from interrupt context.
+ *   NVMDEFER_Flush() must also be used on shutdown paths, NVMDEFER_EnterEM4()
+ *   does so before entering EM4.
+ *
+ *   Changes which are not yet written are lost if power fails within
+ *   NVMDEFER_DELAY_MS.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ ****************************   CONFIGURATION   ********************************
+ ******************************************************************************/
+
+/** Time without changes before marked pages are written, in milliseconds. */
+#ifndef NVMDEFER_DELAY_MS
+#define NVMDEFER_DELAY_MS        2000
+#endif
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+void         NVMDEFER_Init(void);
+void         NVMDEFER_Mark(uint16_t pageId);
+bool         NVMDEFER_Pending(void);
+bool         NVMDEFER_Due(void);
+NVM_Result_t NVMDEFER_Flush(void);
+NVM_Result_t NVMDEFER_EnterEM4(void);
+
+/** @} (end defgroup NVMDEFER) */
+/** @} (end addtogroup NVM) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NVMDEFER_H */
@@ -0,0 +1,195 @@
+/***************************************************************************//**
+ * @file
+ * @brief Compile time layout of NVM pages.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __NVMLAYOUT_H
+#define __NVMLAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nvm.h"
+#include "nvm_log.h"
+
+/***************************************************************************//**
+ * @addtogroup NVM
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @defgroup NVMLAYOUT
+ * @brief Compile time generation and validation of NVM page tables.
+ * @details
+ *   Pages are described with X-macro lists instead of hand written tables.
+ *   The objects of a page are listed as X(page, object ID, variable), where
+ *   page is passed through from the list, and the pages as X(page ID, page
+ *   name, object list, Normal or Wear):
+ *
+ *   @verbatim
+ *   #define PAGE_A_OBJECTS(X, page)  \
+ *     X(page, COUNTER_ID, counter)   \
+ *     X(page, CONFIG_ID,  config)
+ *
+ *   #define PAGES(X) \
+ *     X(PAGE_A_ID, pageA, PAGE_A_OBJECTS, Normal)
+ *
+ *   NVM_LAYOUT_TABLE(pageTable, PAGES)
+ *   @endverbatim
+ *
+ *   NVM_LAYOUT_TABLE() defines the NVM_Page_t of every page, the
+ *   NVM_Page_Table_t, and an array <table>_layout with the NVMLOG_Layout_t
+ *   of every page to pass to NVMLOG_Init(). It fails to compile if a page does not fit in a flash
+ *   page, an object or page ID is used twice or is out of range, or a wear
+ *   page holds more than one object. The compiler error names the failing
+ *   check, e.g. "pageA_does_not_fit_in_a_flash_page".
+ *
+ *   For every page a type <page name>_Image_t is defined with the packed
+ *   layout of a consolidated page as stored by the log. The record offsets
+ *   and sizes of the NVMLOG_Layout_t are taken from this type, so the log
+ *   finds every record without walking the object descriptors.
+ * @{
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/* Compile time assertion, the array size is negative if cond is false. */
+#define NVM_LAYOUT_ASSERT(cond, name)  typedef char name[(cond) ? 1 : -1]
+
+/* Page type and image member of every page format. */
+#define NVM_LAYOUT_TYPE_Normal         nvmPageTypeNormal
+#define NVM_LAYOUT_TYPE_Wear           nvmPageTypeWear
+
+#define NVM_LAYOUT_MEMBER_Normal(page, id, var)             \
+  NVMLOG_Record_t var##_record;                             \
+  uint8_t         var##_data[(sizeof(var) + 3) & ~3];
+
+#define NVM_LAYOUT_MEMBER_Wear(page, id, var)               \
+  NVMLOG_WearRecord_t var##_record;                         \
+  uint8_t             var##_data[(sizeof(var) + 3) & ~3];
+
+/* Size of the record of an object in the packed image of a page. */
+#define NVM_LAYOUT_RECORD_SIZE(name, var)                   \
+  (sizeof(((name##_Image_t *) 0)->var##_record)             \
+   + sizeof(((name##_Image_t *) 0)->var##_data))
+
+/* Expansions of an object list. */
+#define NVM_LAYOUT_OBJECT(page, id, var)     { (uint8_t *) &(var), sizeof(var), (id) },
+#define NVM_LAYOUT_OBJECT_SUM(page, id, var) + (1UL << (id))
+#define NVM_LAYOUT_OBJECT_OR(page, id, var)  | (1UL << (id))
+#define NVM_LAYOUT_OBJECT_ONE(page, id, var) + 1
+#define NVM_LAYOUT_OBJECT_TXN(page, id, var) + NVMLOG_RECORD_SIZE(sizeof(var))
+#define NVM_LAYOUT_OBJECT_OFFSET(page, id, var) NVM_LAYOUT_OFFSET(page, var),
+#define NVM_LAYOUT_OBJECT_SIZE(page, id, var)   NVM_LAYOUT_RECORD_SIZE(page, var),
+
+/* Expansions of a page list. */
+#define NVM_LAYOUT_PAGE_ENTRY(pageId, name, objects, format) \
+  { (pageId), &(name), NVM_LAYOUT_TYPE_##format },
+#define NVM_LAYOUT_PAGE_SUM(pageId, name, objects, format)  + (1UL << (pageId))
+#define NVM_LAYOUT_PAGE_OR(pageId, name, objects, format)   | (1UL << (pageId))
+#define NVM_LAYOUT_PAGE_ONE(pageId, name, objects, format)  + 1
+#define NVM_LAYOUT_PAGE_TXN(pageId, name, objects, format)  objects(NVM_LAYOUT_OBJECT_TXN, name)
+#define NVM_LAYOUT_PAGE_LAYOUT(pageId, name, objects, format) \
+  { 0 objects(NVM_LAYOUT_OBJECT_ONE, name), name##_offset, name##_size },
+
+/* Definition and checks of one page. */
+#define NVM_LAYOUT_PAGE(pageId, name, objects, format)                        \
+  static NVM_Page_t const name =                                              \
+  {                                                                           \
+    objects(NVM_LAYOUT_OBJECT, name)                                          \
+    NVM_PAGE_TERMINATION                                                      \
+  };                                                                          \
+  typedef struct                                                              \
+  {                                                                           \
+    NVMLOG_PageHeader_t header;                                               \
+    objects(NVM_LAYOUT_MEMBER_##format, name)                                 \
+  } name##_Image_t;                                                           \
+  static uint16_t const name##_offset[] =                                     \
+  {                                                                           \
+    objects(NVM_LAYOUT_OBJECT_OFFSET, name)                                   \
+    NVM_LAYOUT_SIZE(name)                                                     \
+  };                                                                          \
+  static uint16_t const name##_size[] =                                       \
+  {                                                                           \
+    objects(NVM_LAYOUT_OBJECT_SIZE, name)                                     \
+  };                                                                          \
+  NVM_LAYOUT_ASSERT(sizeof(name##_Image_t) <= NVM_PAGE_SIZE,                  \
+                    name##_does_not_fit_in_a_flash_page);                     \
+  NVM_LAYOUT_ASSERT((0 objects(NVM_LAYOUT_OBJECT_SUM, name))                  \
+                    == (0 objects(NVM_LAYOUT_OBJECT_OR, name)),               \
+                    name##_has_duplicate_object_ids);                         \
+  NVM_LAYOUT_ASSERT((0 objects(NVM_LAYOUT_OBJECT_OR, name))                   \
+                    < (1UL << NVMLOG_MAX_OBJECT_IDS),                         \
+                    name##_has_object_id_out_of_range);                       \
+  NVM_LAYOUT_ASSERT((NVM_LAYOUT_TYPE_##format != nvmPageTypeWear)             \
+                    || ((0 objects(NVM_LAYOUT_OBJECT_ONE, name)) == 1),       \
+                    name##_wear_page_must_hold_one_object);
+
+/** @endcond */
+
+/** Offset of the record of an object in the packed image of a page. */
+#define NVM_LAYOUT_OFFSET(name, var)   offsetof(name##_Image_t, var##_record)
+
+/** Packed size of a page as stored by the log. */
+#define NVM_LAYOUT_SIZE(name)          sizeof(name##_Image_t)
+
+/** Define all pages of a page list and their page table. */
+#define NVM_LAYOUT_TABLE(table, pages)                                        \
+  pages(NVM_LAYOUT_PAGE)                                                      \
+  static NVM_Page_Table_t const table =                                       \
+  {                                                                           \
+    pages(NVM_LAYOUT_PAGE_ENTRY)                                              \
+  };                                                                          \
+  static NVMLOG_Layout_t const table##_layout[] =                             \
+  {                                                                           \
+    pages(NVM_LAYOUT_PAGE_LAYOUT)                                             \
+  };                                                                          \
+  NVM_LAYOUT_ASSERT((0 pages(NVM_LAYOUT_PAGE_SUM))                            \
+                    == (0 pages(NVM_LAYOUT_PAGE_OR)),                         \
+                    table##_has_duplicate_page_ids);                          \
+  NVM_LAYOUT_ASSERT((0 pages(NVM_LAYOUT_PAGE_OR))                             \
+                    < (1UL << NVMLOG_MAX_PAGE_IDS),                           \
+                    table##_has_page_id_out_of_range);                        \
+  NVM_LAYOUT_ASSERT((0 pages(NVM_LAYOUT_PAGE_ONE)) <= NVMLOG_MAX_USER_PAGES,  \
+                    table##_has_too_many_pages);
+
+/** Check that all objects of a page list can be written in one transaction. */
+#define NVM_LAYOUT_ASSERT_TRANSACTION(table, pages)                           \
+  NVM_LAYOUT_ASSERT(sizeof(NVMLOG_PageHeader_t)                               \
+                    + 2 * sizeof(NVMLOG_Record_t)                             \
+                    pages(NVM_LAYOUT_PAGE_TXN) <= NVM_PAGE_SIZE,              \
+                    table##_does_not_fit_in_a_transaction);
+
+/** @} (end defgroup NVMLAYOUT) */
+/** @} (end addtogroup NVM) */
+
+#endif /* __NVMLAYOUT_H */
@@ -0,0 +1,1321 @@
+/***************************************************************************//**
+ * @file
+ * @brief Non-Volatile Memory delta log.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+
+#include "nvm_log.h"
+#include "nvm_hal.h"
+
+/***************************************************************************//**
+ * @addtogroup NVM
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup NVMLOG
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+#define NVMLOG_PAGE_MAGIC        0x4C4D564EUL    /* "NVML" */
+#define NVMLOG_PAGE_COMMITTED    0x54494D43UL    /* "CMIT" */
+#define NVMLOG_RECORD_OBJECT     0x01
+#define NVMLOG_RECORD_TXN        0x02    /* Object of a transaction.      */
+#define NVMLOG_RECORD_COMMIT     0x03    /* Transaction is complete.      */
+#define NVMLOG_RECORD_APPLIED    0x04    /* Transaction is in the pages.  */
+#define NVMLOG_TXN_PAGE_ID       0xFFFE  /* Page ID of transaction page.  */
+#define NVMLOG_CHECKSUM_INITIAL  0xFFFF
+#define NVMLOG_ERASED_WORD       0xFFFFFFFFUL
+
+/* Sequence numbers are 15 bit, an erased record header is never valid. */
+#define NVMLOG_WEAR_SEQUENCE_MASK 0x7FFF
+
+/* Object selection masks, one bit per object ID. */
+#define NVMLOG_SELECT_ALL        0xFFFFFFFFUL
+#define NVMLOG_SELECT(objectId)  (1UL << (objectId))
+
+/** @endcond */
+
+/*******************************************************************************
+ *******************************   STATICS   ***********************************
+ ******************************************************************************/
+
+/* Configuration and page layouts given to NVMLOG_Init(). */
+static NVM_Config_t const    *logConfig;
+static NVMLOG_Layout_t const *logLayout;
+
+/* State of every user page, indexed as the page table in the configuration. */
+static struct
+{
+  uint8_t *page;      /* Active flash page, NULL if the page is not stored.  */
+  uint8_t *freePos;   /* Position of the next record in the active page.     */
+  uint16_t sequence;  /* Sequence number of the newest version (wear page).  */
+} logPages[NVMLOG_MAX_USER_PAGES];
+
+/* Erase count of every flash page in the log area. */
+static uint32_t eraseCounts[NVMLOG_MAX_PAGES];
+
+/* Page table index of every page ID, -1 if not used. */
+static int8_t pageIndex[NVMLOG_MAX_PAGE_IDS];
+
+/* Index of every object, by page table index and object ID. */
+static struct
+{
+  NVM_Object_Descriptor_t const *obj;  /* NULL if the object ID is unused. */
+  uint8_t const                 *data; /* Newest copy, NULL if none.       */
+  uint8_t const                 *pending; /* Data of a transaction to store
+                                             instead of the RAM copy.      */
+} objectIndex[NVMLOG_MAX_USER_PAGES][NVMLOG_MAX_OBJECT_IDS];
+
+/* State of transactions, see NVMLOG_TransactionBegin(). */
+static struct
+{
+  uint8_t  *page;     /* Flash page holding transactions, NULL if none.      */
+  uint8_t  *freePos;  /* Position of the next record in the page.            */
+  uint8_t  *unapplied; /* Committed transaction not stored in the user pages
+                          yet, NULL if none.                                 */
+  bool     active;    /* Writes are collected until the commit.              */
+  uint32_t select[NVMLOG_MAX_USER_PAGES]; /* Objects written, per page.      */
+} txn;
+
+/*******************************************************************************
+ ***************************   LOCAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Get address of a flash page in the log area.
+ ******************************************************************************/
+static uint8_t *PageAddress(uint32_t index)
+{
+  return (uint8_t *) logConfig->nvmArea + index * NVM_PAGE_SIZE;
+}
+
+/***************************************************************************//**
+ * @brief Find the index of a user page in the page table.
+ *
+ * @return Index in the page table, -1 if page is unknown.
+ ******************************************************************************/
+static int PageIndexGet(uint16_t pageId)
+{
+  if (pageId >= NVMLOG_MAX_PAGE_IDS)
+    return -1;
+
+  return pageIndex[pageId];
+}
+
+/***************************************************************************//**
+ * @brief Get the number of a flash page in the log area.
+ ******************************************************************************/
+static uint32_t PageNumber(uint8_t *page)
+{
+  return (page - (uint8_t *) logConfig->nvmArea) / NVM_PAGE_SIZE;
+}
+
+/***************************************************************************//**
+ * @brief Check if a word aligned range of flash is erased.
+ ******************************************************************************/
+static bool RangeBlank(uint8_t *start, uint32_t size)
+{
+  uint32_t *pWord = (uint32_t *) start;
+  uint32_t i;
+
+  for (i = 0; i < size / sizeof(uint32_t); i++)
+  {
+    if (pWord[i] != NVMLOG_ERASED_WORD)
+      return false;
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief Check if a flash page is completely erased.
+ ******************************************************************************/
+static bool PageBlank(uint8_t *page)
+{
+  return RangeBlank(page, NVM_PAGE_SIZE);
+}
+
+/***************************************************************************//**
+ * @brief Check if a flash page is erased apart from its erase count.
+ ******************************************************************************/
+static bool PageFree(uint8_t *page)
+{
+  uint32_t offset = offsetof(NVMLOG_PageHeader_t, pageId);
+
+  return (((NVMLOG_PageHeader_t *) page)->magic == NVMLOG_PAGE_MAGIC)
+         && RangeBlank(page + offset, NVM_PAGE_SIZE - offset);
+}
+
+/***************************************************************************//**
+ * @brief Write the erase count to an erased flash page.
+ *
+ * @details
+ *   The count is written before the magic word, so a page with a valid magic
+ *   word always holds a valid count.
+ ******************************************************************************/
+static NVM_Result_t PageFormat(uint8_t *page)
+{
+  NVMLOG_PageHeader_t *header = (NVMLOG_PageHeader_t *) page;
+  uint32_t            magic   = NVMLOG_PAGE_MAGIC;
+  NVM_Result_t        result;
+
+  result = NVMHAL_Write((uint8_t *) &header->eraseCount,
+                        &eraseCounts[PageNumber(page)], sizeof(uint32_t));
+  if (result == nvmResultOk)
+    result = NVMHAL_Write((uint8_t *) &header->magic, &magic, sizeof(magic));
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief Erase a flash page and write its new erase count.
+ ******************************************************************************/
+static NVM_Result_t PageErase(uint8_t *page)
+{
+  NVM_Result_t result;
+
+  result = NVMHAL_PageErase(page);
+  if (result != nvmResultOk)
+    return result;
+
+  eraseCounts[PageNumber(page)]++;
+  return PageFormat(page);
+}
+
+/***************************************************************************//**
+ * @brief Check if a user page is stored as a wear page.
+ ******************************************************************************/
+static bool PageIsWear(int idx)
+{
+  return (*logConfig->nvmPages)[idx].pageType == nvmPageTypeWear;
+}
+
+/***************************************************************************//**
+ * @brief Get the size of a record holding an object of a user page.
+ ******************************************************************************/
+static uint32_t RecordSize(int idx, uint16_t size)
+{
+  if (PageIsWear(idx))
+    return NVMLOG_WEAR_RECORD_SIZE(size);
+
+  return NVMLOG_RECORD_SIZE(size);
+}
+
+/***************************************************************************//**
+ * @brief Get the selection mask of an object ID or NVM_WRITE_ALL_CMD.
+ ******************************************************************************/
+static uint32_t SelectMask(uint8_t objectId)
+{
+  if (objectId == NVM_WRITE_ALL_CMD)
+    return NVMLOG_SELECT_ALL;
+
+  if (objectId >= NVMLOG_MAX_OBJECT_IDS)
+    return 0;
+
+  return NVMLOG_SELECT(objectId);
+}
+
+/***************************************************************************//**
+ * @brief Check if an object is in a selection mask.
+ ******************************************************************************/
+static bool ObjectSelected(NVM_Object_Descriptor_t const *obj, uint32_t select)
+{
+  return (select & NVMLOG_SELECT(obj->objectId)) != 0;
+}
+
+/***************************************************************************//**
+ * @brief Get the data to store for an object, from a transaction or RAM.
+ ******************************************************************************/
+static void const *ObjectData(int idx, NVM_Object_Descriptor_t const *obj)
+{
+  if (objectIndex[idx][obj->objectId].pending != NULL)
+    return objectIndex[idx][obj->objectId].pending;
+
+  return obj->location;
+}
+
+/***************************************************************************//**
+ * @brief Calculate the checksum of a record header and its data.
+ ******************************************************************************/
+static uint16_t RecordChecksum(NVMLOG_Record_t const *rec, void const *data)
+{
+  uint16_t checksum = NVMLOG_CHECKSUM_INITIAL;
+
+  NVMHAL_Checksum(&checksum, (void *) rec, offsetof(NVMLOG_Record_t, checksum));
+  if (rec->type == NVMLOG_RECORD_TXN)
+    NVMHAL_Checksum(&checksum, (void *) &rec->pageId, sizeof(rec->pageId));
+  NVMHAL_Checksum(&checksum, (void *) data, rec->size);
+  return checksum;
+}
+
+/***************************************************************************//**
+ * @brief Calculate the checksum of a wear record header and its data.
+ ******************************************************************************/
+static uint16_t WearRecordChecksum(NVMLOG_WearRecord_t const *rec,
+                                   void const *data, uint16_t size)
+{
+  uint16_t checksum = NVMLOG_CHECKSUM_INITIAL;
+
+  NVMHAL_Checksum(&checksum, (void *) &rec->sequence, sizeof(rec->sequence));
+  NVMHAL_Checksum(&checksum, (void *) data, size);
+  return checksum;
+}
+
+/***************************************************************************//**
+ * @brief Walk the version records of a wear page.
+ *
+ * @details
+ *   Every valid record must carry the sequence number following the one of
+ *   the record before it, so the last valid record is the newest version.
+ *
+ * @return Position where the next record can be written.
+ ******************************************************************************/
+static uint8_t *WearPageScan(int idx)
+{
+  NVM_Object_Descriptor_t const *obj  = *(*logConfig->nvmPages)[idx].page;
+  uint8_t                       *pos  = logPages[idx].page + sizeof(NVMLOG_PageHeader_t);
+  uint8_t                       *end  = logPages[idx].page + NVM_PAGE_SIZE;
+  uint32_t                      size  = NVMLOG_WEAR_RECORD_SIZE(obj->size);
+  NVMLOG_WearRecord_t           *rec;
+  bool                          found = false;
+
+  while (pos + size <= end)
+  {
+    rec = (NVMLOG_WearRecord_t *) pos;
+
+    /* An erased record header marks the end of the log. */
+    if (((uint32_t *) pos)[0] == NVMLOG_ERASED_WORD)
+      break;
+
+    if ((rec->sequence > NVMLOG_WEAR_SEQUENCE_MASK)
+        || (found && (rec->sequence != ((logPages[idx].sequence + 1) & NVMLOG_WEAR_SEQUENCE_MASK)))
+        || (rec->checksum != WearRecordChecksum(rec, rec + 1, obj->size)))
+      return end;
+
+    objectIndex[idx][obj->objectId].data = (uint8_t *) (rec + 1);
+    logPages[idx].sequence = rec->sequence;
+    found = true;
+
+    pos += size;
+  }
+
+  return pos;
+}
+
+/***************************************************************************//**
+ * @brief Walk the records of the active flash page of a user page.
+ *
+ * @details
+ *   Updates the object index with the newest valid record of every object,
+ *   and finds the position where the next record can be written. A corrupted
+ *   (e.g. torn) record seals the page, the free position is then set to the
+ *   end of the page so the next write consolidates the page.
+ ******************************************************************************/
+static void PageScan(int idx)
+{
+  uint8_t         *pos = logPages[idx].page + sizeof(NVMLOG_PageHeader_t);
+  uint8_t         *end = logPages[idx].page + NVM_PAGE_SIZE;
+  NVMLOG_Record_t *rec;
+  int             id;
+
+  for (id = 0; id < NVMLOG_MAX_OBJECT_IDS; id++)
+    objectIndex[idx][id].data = NULL;
+
+  if (PageIsWear(idx))
+  {
+    logPages[idx].freePos = WearPageScan(idx);
+    return;
+  }
+
+  while (pos + sizeof(NVMLOG_Record_t) <= end)
+  {
+    rec = (NVMLOG_Record_t *) pos;
+
+    /* An erased record header marks the end of the log. */
+    if ((((uint32_t *) pos)[0] == NVMLOG_ERASED_WORD)
+        && (((uint32_t *) pos)[1] == NVMLOG_ERASED_WORD))
+      break;
+
+    if ((rec->type != NVMLOG_RECORD_OBJECT)
+        || (pos + sizeof(NVMLOG_Record_t) + rec->size > end)
+        || (rec->checksum != RecordChecksum(rec, rec + 1)))
+    {
+      pos = end;
+      break;
+    }
+
+    /* Records of objects no longer in the configuration are ignored. */
+    if ((rec->objectId < NVMLOG_MAX_OBJECT_IDS)
+        && (objectIndex[idx][rec->objectId].obj != NULL)
+        && (objectIndex[idx][rec->objectId].obj->size == rec->size))
+      objectIndex[idx][rec->objectId].data = (uint8_t *) (rec + 1);
+
+    pos += NVMLOG_RECORD_SIZE(rec->size);
+  }
+
+  logPages[idx].freePos = pos;
+}
+
+/***************************************************************************//**
+ * @brief Program a record.
+ ******************************************************************************/
+static NVM_Result_t RecordWrite(uint8_t *pos, uint8_t type, uint16_t pageId,
+                                uint8_t objectId, void const *data, uint16_t size)
+{
+  NVMLOG_Record_t rec;
+  NVM_Result_t    result;
+
+  rec.objectId = objectId;
+  rec.type     = type;
+  rec.size     = size;
+  rec.pageId   = pageId;
+  rec.checksum = RecordChecksum(&rec, data);
+
+  /* Header first, a record with a torn data part fails the checksum. */
+  result = NVMHAL_Write(pos, &rec, sizeof(rec));
+  if ((result == nvmResultOk) && (size > 0))
+    result = NVMHAL_Write(pos + sizeof(rec), data, size);
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief Program the next version record of a wear page.
+ ******************************************************************************/
+static NVM_Result_t WearRecordWrite(int idx, uint8_t *pos,
+                                    void const *data, uint16_t size)
+{
+  NVMLOG_WearRecord_t rec;
+  NVM_Result_t        result;
+
+  rec.sequence = (logPages[idx].sequence + 1) & NVMLOG_WEAR_SEQUENCE_MASK;
+  rec.checksum = WearRecordChecksum(&rec, data, size);
+
+  result = NVMHAL_Write(pos, &rec, sizeof(rec));
+  if (result == nvmResultOk)
+    result = NVMHAL_Write(pos + sizeof(rec), data, size);
+
+  if (result == nvmResultOk)
+    logPages[idx].sequence = rec.sequence;
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief Program a record of an object in the format of its user page.
+ ******************************************************************************/
+static NVM_Result_t ObjectRecordWrite(int idx, uint8_t *pos,
+                                      NVM_Object_Descriptor_t const *obj,
+                                      void const *data)
+{
+  if (PageIsWear(idx))
+    return WearRecordWrite(idx, pos, data, obj->size);
+
+  return RecordWrite(pos, NVMLOG_RECORD_OBJECT, 0xFFFF, obj->objectId,
+                     data, obj->size);
+}
+
+/***************************************************************************//**
+ * @brief Check if an object differs from its last committed copy.
+ ******************************************************************************/
+static bool ObjectChanged(int idx, NVM_Object_Descriptor_t const *obj)
+{
+  uint8_t const *last = objectIndex[idx][obj->objectId].data;
+
+  return (last == NULL)
+         || (memcmp(last, ObjectData(idx, obj), obj->size) != 0);
+}
+
+/***************************************************************************//**
+ * @brief Find the least worn unused flash page in the log area, and make sure
+ *   it is erased and holds its erase count.
+ ******************************************************************************/
+static uint8_t *PageAllocate(void)
+{
+  uint8_t      *page = NULL;
+  uint32_t     i;
+  int          idx;
+  bool         used;
+  NVM_Result_t result;
+
+  for (i = 0; i < logConfig->pages; i++)
+  {
+    used = (PageAddress(i) == txn.page);
+    for (idx = 0; idx < logConfig->userPages; idx++)
+    {
+      if (logPages[idx].page == PageAddress(i))
+        used = true;
+    }
+
+    if (!used && ((page == NULL) || (eraseCounts[i] < eraseCounts[PageNumber(page)])))
+      page = PageAddress(i);
+  }
+
+  if ((page == NULL) || PageFree(page))
+    return page;
+
+  if (PageBlank(page))
+    result = PageFormat(page);
+  else
+    result = PageErase(page);
+
+  return (result == nvmResultOk) ? page : NULL;
+}
+
+/***************************************************************************//**
+ * @brief Write the full image of a user page to a fresh flash page.
+ *
+ * @details
+ *   Selected objects are taken from RAM (or from a transaction), the others
+ *   are copied from their last committed record. The new page becomes valid
+ *   when its commit word is written, only then the old page is erased. A
+ *   power failure in between leaves two committed pages, NVMLOG_Init() keeps
+ *   the newest one.
+ ******************************************************************************/
+static NVM_Result_t PageConsolidate(int idx, uint32_t select)
+{
+  NVM_Page_Descriptor_t const   *desc    = &(*logConfig->nvmPages)[idx];
+  NVMLOG_Layout_t const         *layout  = &logLayout[idx];
+  NVM_Object_Descriptor_t const *obj;
+  NVMLOG_PageHeader_t           header;
+  uint8_t                       *oldPage = logPages[idx].page;
+  uint8_t                       *newPage;
+  void const                    *data;
+  uint32_t                      commit   = NVMLOG_PAGE_COMMITTED;
+  uint32_t                      skipped  = 0;
+  uint32_t                      i;
+  NVM_Result_t                  result;
+
+  newPage = PageAllocate();
+  if (newPage == NULL)
+    return nvmResultError;
+
+  header.pageId    = desc->pageId;
+  header.pageIdInv = (uint16_t) ~desc->pageId;
+  header.version   = 1;
+  if (oldPage != NULL)
+    header.version = ((NVMLOG_PageHeader_t *) oldPage)->version + 1;
+
+  /* The magic word and erase count are already written by PageAllocate(). */
+  result = NVMHAL_Write(newPage + offsetof(NVMLOG_PageHeader_t, pageId),
+                        &header.pageId,
+                        offsetof(NVMLOG_PageHeader_t, committed)
+                        - offsetof(NVMLOG_PageHeader_t, pageId));
+
+  /* Records are packed at their offsets in the layout, moved down by the
+   * records of objects which are left out. */
+  for (i = 0; (i < layout->count) && (result == nvmResultOk); i++)
+  {
+    obj  = &(*desc->page)[i];
+    data = ObjectData(idx, obj);
+    if (!ObjectSelected(obj, select))
+    {
+      data = objectIndex[idx][obj->objectId].data;
+      if (data == NULL)
+      {
+        skipped += layout->size[i];
+        continue;     /* Never stored, and not requested now. */
+      }
+    }
+
+    result = ObjectRecordWrite(idx, newPage + layout->offset[i] - skipped,
+                               obj, data);
+  }
+
+  if (result == nvmResultOk)
+    result = NVMHAL_Write((uint8_t *) &((NVMLOG_PageHeader_t *) newPage)->committed,
+                          &commit, sizeof(commit));
+
+  if (result != nvmResultOk)
+  {
+    /* Leave the old page in place, the new one is recycled later. */
+    return result;
+  }
+
+  /* Switch the index over to the new page. */
+  logPages[idx].page = newPage;
+  PageScan(idx);
+
+  if (oldPage != NULL)
+    result = PageErase(oldPage);
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief Store the changed objects of a selection in a user page.
+ ******************************************************************************/
+static NVM_Result_t PageWrite(int idx, uint32_t select)
+{
+  NVM_Object_Descriptor_t const *obj;
+  NVM_Object_Descriptor_t const *objects = *(*logConfig->nvmPages)[idx].page;
+  NVMLOG_Layout_t const         *layout  = &logLayout[idx];
+  NVM_Result_t                  result   = nvmResultOk;
+  uint32_t                      needed   = 0;
+  uint32_t                      i;
+
+  for (i = 0; i < layout->count; i++)
+  {
+    obj = &objects[i];
+    if (ObjectSelected(obj, select) && ObjectChanged(idx, obj))
+      needed += layout->size[i];
+  }
+
+  /* Nothing has changed since last write. */
+  if (needed == 0)
+    return nvmResultOk;
+
+  if ((logPages[idx].page == NULL)
+      || (logPages[idx].freePos + needed > logPages[idx].page + NVM_PAGE_SIZE))
+    return PageConsolidate(idx, select);
+
+  for (i = 0; (i < layout->count) && (result == nvmResultOk); i++)
+  {
+    obj = &objects[i];
+    if (ObjectSelected(obj, select) && ObjectChanged(idx, obj))
+    {
+      result = ObjectRecordWrite(idx, logPages[idx].freePos, obj, ObjectData(idx, obj));
+      if (result == nvmResultOk)
+        objectIndex[idx][obj->objectId].data = logPages[idx].freePos + RecordSize(idx, 0);
+      logPages[idx].freePos += layout->size[i];
+    }
+  }
+
+  /* Do not append to a page with a failed record, consolidate next time. */
+  if (result != nvmResultOk)
+    logPages[idx].freePos = logPages[idx].page + NVM_PAGE_SIZE;
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief Start a new transaction page, and erase the old one.
+ *
+ * @details
+ *   Only called when every transaction in the old page has been applied,
+ *   txn.unapplied is NULL.
+ ******************************************************************************/
+static NVM_Result_t TxnPageAllocate(void)
+{
+  NVMLOG_PageHeader_t header;
+  uint8_t             *oldPage = txn.page;
+  uint8_t             *newPage;
+  NVM_Result_t        result;
+
+  newPage = PageAllocate();
+  if (newPage == NULL)
+    return nvmResultError;
+
+  header.pageId    = NVMLOG_TXN_PAGE_ID;
+  header.pageIdInv = (uint16_t) ~NVMLOG_TXN_PAGE_ID;
+  header.version   = 1;
+  header.committed = NVMLOG_PAGE_COMMITTED;
+  if (oldPage != NULL)
+    header.version = ((NVMLOG_PageHeader_t *) oldPage)->version + 1;
+
+  result = NVMHAL_Write(newPage + offsetof(NVMLOG_PageHeader_t, pageId),
+                        &header.pageId,
+                        sizeof(header) - offsetof(NVMLOG_PageHeader_t, pageId));
+  if (result != nvmResultOk)
+    return result;
+
+  txn.page    = newPage;
+  txn.freePos = newPage + sizeof(NVMLOG_PageHeader_t);
+
+  if (oldPage != NULL)
+    result = PageErase(oldPage);
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief Walk the records of the transaction page.
+ *
+ * @details
+ *   Finds the position where the next record can be written, and a committed
+ *   transaction which has not been marked as applied. Records of a transaction
+ *   without commit record, or a corrupted record, seal the page so the next
+ *   transaction starts a new page.
+ *
+ * @return Start of the records of the unapplied transaction, NULL if none.
+ ******************************************************************************/
+static uint8_t *TxnPageScan(void)
+{
+  uint8_t         *pos   = txn.page + sizeof(NVMLOG_PageHeader_t);
+  uint8_t         *end   = txn.page + NVM_PAGE_SIZE;
+  uint8_t         *start = NULL;
+  uint8_t         *unapplied = NULL;
+  NVMLOG_Record_t *rec;
+
+  while (pos + sizeof(NVMLOG_Record_t) <= end)
+  {
+    rec = (NVMLOG_Record_t *) pos;
+
+    if ((((uint32_t *) pos)[0] == NVMLOG_ERASED_WORD)
+        && (((uint32_t *) pos)[1] == NVMLOG_ERASED_WORD))
+      break;
+
+    if ((rec->type < NVMLOG_RECORD_TXN)
+        || (rec->type > NVMLOG_RECORD_APPLIED)
+        || (pos + sizeof(NVMLOG_Record_t) + rec->size > end)
+        || (rec->checksum != RecordChecksum(rec, rec + 1)))
+    {
+      start = NULL;
+      pos   = end;
+      break;
+    }
+
+    if ((rec->type == NVMLOG_RECORD_TXN) && (start == NULL))
+      start = pos;
+    else if ((rec->type == NVMLOG_RECORD_COMMIT) && (start != NULL))
+    {
+      unapplied = start;
+      start     = NULL;
+    }
+    else if (rec->type == NVMLOG_RECORD_APPLIED)
+      unapplied = NULL;
+
+    pos += NVMLOG_RECORD_SIZE(rec->size);
+  }
+
+  /* Records of an interrupted transaction, never append after them. */
+  if (start != NULL)
+    pos = end;
+
+  txn.freePos = pos;
+  return unapplied;
+}
+
+/***************************************************************************//**
+ * @brief Store the committed transaction txn.unapplied in the user pages.
+ *
+ * @details
+ *   Every object of the transaction is written to its page from the copy in
+ *   the transaction page, and the transaction is then marked as applied.
+ *   Objects already holding the value of the transaction are not written
+ *   again, so the transaction can be reapplied after a power failure.
+ *
+ *   If a user page write fails the transaction stays in txn.unapplied, and
+ *   is applied again before anything else is written.
+ ******************************************************************************/
+static NVM_Result_t TxnApply(void)
+{
+  NVMLOG_Record_t *rec;
+  NVM_Result_t    result = nvmResultOk;
+  uint32_t        select[NVMLOG_MAX_USER_PAGES];
+  int             idx;
+  int             id;
+
+  for (idx = 0; idx < logConfig->userPages; idx++)
+    select[idx] = 0;
+
+  for (rec = (NVMLOG_Record_t *) txn.unapplied;
+       rec->type == NVMLOG_RECORD_TXN;
+       rec = (NVMLOG_Record_t *) ((uint8_t *) rec + NVMLOG_RECORD_SIZE(rec->size)))
+  {
+    /* Objects no longer in the configuration are ignored. */
+    idx = PageIndexGet(rec->pageId);
+    if ((idx < 0)
+        || (rec->objectId >= NVMLOG_MAX_OBJECT_IDS)
+        || (objectIndex[idx][rec->objectId].obj == NULL)
+        || (objectIndex[idx][rec->objectId].obj->size != rec->size))
+      continue;
+
+    objectIndex[idx][rec->objectId].pending = (uint8_t *) (rec + 1);
+    select[idx] |= NVMLOG_SELECT(rec->objectId);
+  }
+
+  for (idx = 0; (idx < logConfig->userPages) && (result == nvmResultOk); idx++)
+  {
+    if (select[idx] != 0)
+      result = PageWrite(idx, select[idx]);
+  }
+
+  for (idx = 0; idx < logConfig->userPages; idx++)
+  {
+    for (id = 0; id < NVMLOG_MAX_OBJECT_IDS; id++)
+      objectIndex[idx][id].pending = NULL;
+  }
+
+  if (result != nvmResultOk)
+    return result;
+
+  txn.unapplied = NULL;
+
+  if (txn.freePos + sizeof(NVMLOG_Record_t) <= txn.page + NVM_PAGE_SIZE)
+  {
+    result = RecordWrite(txn.freePos, NVMLOG_RECORD_APPLIED, 0xFFFF, 0, NULL, 0);
+    txn.freePos += sizeof(NVMLOG_Record_t);
+    if (result == nvmResultOk)
+      return result;
+  }
+
+  /* The page holds only applied transactions. Without room for the mark, or
+   * with a failed mark, which would hide later records from TxnPageScan(),
+   * it is erased. */
+  result   = PageErase(txn.page);
+  txn.page = NULL;
+
+  return result;
+}
+
+/*******************************************************************************
+ **************************   GLOBAL FUNCTIONS   *******************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Initialize the log and locate the newest copy of every user page.
+ *
+ * @details
+ *   Pages which are neither erased nor hold a committed page image, e.g.
+ *   after a power failure during consolidation, are erased. User pages which
+ *   are not found in flash are created on their first write. A transaction
+ *   which was committed but not completely stored in its pages is completed.
+ *
+ * @param[in] config
+ *   Page table and flash area of the log. The area must hold at least one
+ *   more flash page than there are user pages, and at most NVMLOG_MAX_PAGES.
+ *
+ * @param[in] layout
+ *   Layout of every user page, indexed as the page table, see
+ *   NVM_LAYOUT_TABLE(). It is checked against the page table here.
+ *
+ * @return
+ *   nvmResultOk on success, nvmResultError if the configuration is invalid or
+ *   an interrupted transaction could not be completed.
+ ******************************************************************************/
+NVM_Result_t NVMLOG_Init(NVM_Config_t const *config,
+                         NVMLOG_Layout_t const *layout)
+{
+  NVM_Object_Descriptor_t const *obj;
+  NVMLOG_PageHeader_t           *header;
+  NVM_Result_t                  result;
+  uint8_t                       *page;
+  uint32_t                      size;
+  uint32_t                      maxCount;
+  uint32_t                      i;
+  int                           idx;
+  int                           id;
+
+  logConfig = config;
+  logLayout = layout;
+
+  if ((config->userPages > NVMLOG_MAX_USER_PAGES)
+      || (config->pages > NVMLOG_MAX_PAGES)
+      || (config->pages <= config->userPages))
+    return nvmResultError;
+
+  for (id = 0; id < NVMLOG_MAX_PAGE_IDS; id++)
+    pageIndex[id] = -1;
+
+  for (idx = 0; idx < config->userPages; idx++)
+  {
+    id = (*config->nvmPages)[idx].pageId;
+    if ((id >= NVMLOG_MAX_PAGE_IDS) || (pageIndex[id] >= 0))
+      return nvmResultError;
+    pageIndex[id] = idx;
+
+    for (id = 0; id < NVMLOG_MAX_OBJECT_IDS; id++)
+    {
+      objectIndex[idx][id].obj     = NULL;
+      objectIndex[idx][id].data    = NULL;
+      objectIndex[idx][id].pending = NULL;
+    }
+
+    /* Object IDs must be unique in the page, the layout must match the
+     * objects, and the full image of the page must fit in a flash page. */
+    size = sizeof(NVMLOG_PageHeader_t);
+    i    = 0;
+    for (obj = *(*config->nvmPages)[idx].page; obj->size != 0; obj++, i++)
+    {
+      if ((obj->objectId >= NVMLOG_MAX_OBJECT_IDS)
+          || (objectIndex[idx][obj->objectId].obj != NULL)
+          || (i >= layout[idx].count)
+          || (layout[idx].offset[i] != size)
+          || (layout[idx].size[i] != RecordSize(idx, obj->size)))
+        return nvmResultError;
+      objectIndex[idx][obj->objectId].obj = obj;
+
+      size += layout[idx].size[i];
+    }
+
+    if ((i != layout[idx].count)
+        || (layout[idx].offset[i] != size)
+        || (size > NVM_PAGE_SIZE))
+      return nvmResultError;
+
+    /* A wear page holds exactly one object. */
+    obj = *(*config->nvmPages)[idx].page;
+    if (PageIsWear(idx) && ((obj[0].size == 0) || (obj[1].size != 0)))
+      return nvmResultError;
+
+    logPages[idx].page     = NULL;
+    logPages[idx].freePos  = NULL;
+    logPages[idx].sequence = 0;
+    txn.select[idx]        = 0;
+  }
+
+  txn.page      = NULL;
+  txn.unapplied = NULL;
+  txn.active    = false;
+
+  /* Erase counts, a page with a corrupted header (e.g. after a power failure
+   * during erase) is assumed to be as worn as the most worn page. */
+  maxCount = 0;
+  for (i = 0; i < config->pages; i++)
+  {
+    header         = (NVMLOG_PageHeader_t *) PageAddress(i);
+    eraseCounts[i] = 0;
+    if ((header->magic == NVMLOG_PAGE_MAGIC) && (header->eraseCount > maxCount))
+      maxCount = header->eraseCount;
+  }
+  for (i = 0; i < config->pages; i++)
+  {
+    page   = PageAddress(i);
+    header = (NVMLOG_PageHeader_t *) page;
+    if (header->magic == NVMLOG_PAGE_MAGIC)
+      eraseCounts[i] = header->eraseCount;
+    else if (!PageBlank(page))
+      eraseCounts[i] = maxCount;
+  }
+
+  NVMHAL_Init();
+
+  for (i = 0; i < config->pages; i++)
+  {
+    page   = PageAddress(i);
+    header = (NVMLOG_PageHeader_t *) page;
+
+    if (PageBlank(page) || PageFree(page))
+      continue;
+
+    if ((header->magic == NVMLOG_PAGE_MAGIC)
+        && (header->pageId == NVMLOG_TXN_PAGE_ID)
+        && ((header->pageId ^ header->pageIdInv) == 0xFFFF)
+        && (header->committed == NVMLOG_PAGE_COMMITTED))
+    {
+      /* Interrupted switch of transaction page, keep the newest. */
+      if ((txn.page != NULL)
+          && (((NVMLOG_PageHeader_t *) txn.page)->version > header->version))
+      {
+        PageErase(page);
+        continue;
+      }
+      if (txn.page != NULL)
+        PageErase(txn.page);
+      txn.page = page;
+      continue;
+    }
+
+    idx = -1;
+    if ((header->magic == NVMLOG_PAGE_MAGIC)
+        && ((header->pageId ^ header->pageIdInv) == 0xFFFF)
+        && (header->committed == NVMLOG_PAGE_COMMITTED))
+      idx = PageIndexGet(header->pageId);
+
+    if (idx < 0)
+    {
+      PageErase(page);
+      continue;
+    }
+
+    if (logPages[idx].page != NULL)
+    {
+      /* Interrupted consolidation, keep the newest image. */
+      if (((NVMLOG_PageHeader_t *) logPages[idx].page)->version > header->version)
+      {
+        PageErase(page);
+        continue;
+      }
+      PageErase(logPages[idx].page);
+    }
+    logPages[idx].page = page;
+  }
+
+  for (idx = 0; idx < config->userPages; idx++)
+  {
+    if (logPages[idx].page != NULL)
+      PageScan(idx);
+  }
+
+  /* Complete a transaction interrupted after its commit. */
+  result = nvmResultOk;
+  if (txn.page != NULL)
+  {
+    txn.unapplied = TxnPageScan();
+    if (txn.unapplied != NULL)
+      result = TxnApply();
+  }
+
+  NVMHAL_DeInit();
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Erase all pages of the log.
+ *
+ * @details
+ *   The erase counts of the pages are kept.
+ *
+ * @return
+ *   nvmResultOk on success.
+ ******************************************************************************/
+NVM_Result_t NVMLOG_Erase(void)
+{
+  NVM_Result_t result = nvmResultOk;
+  uint8_t      *page;
+  uint32_t     i;
+  int          idx;
+  int          id;
+
+  NVMHAL_Init();
+
+  for (i = 0; (i < logConfig->pages) && (result == nvmResultOk); i++)
+  {
+    page = PageAddress(i);
+    if (!PageBlank(page) && !PageFree(page))
+      result = PageErase(page);
+  }
+
+  NVMHAL_DeInit();
+
+  for (idx = 0; idx < logConfig->userPages; idx++)
+  {
+    logPages[idx].page    = NULL;
+    logPages[idx].freePos = NULL;
+    for (id = 0; id < NVMLOG_MAX_OBJECT_IDS; id++)
+      objectIndex[idx][id].data = NULL;
+  }
+  txn.page      = NULL;
+  txn.unapplied = NULL;
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Store changed objects of a user page.
+ *
+ * @details
+ *   Every selected object is compared with its last committed copy, and a
+ *   record is appended only for objects that have changed. If the records do
+ *   not fit in the active flash page the page is consolidated.
+ *
+ *   Inside a transaction the objects are only marked, and are stored by
+ *   NVMLOG_TransactionCommit().
+ *
+ * @param[in] pageId
+ *   User page to write.
+ *
+ * @param[in] objectId
+ *   Object to write, or NVM_WRITE_ALL_CMD for all objects in the page.
+ *
+ * @return
+ *   nvmResultOk on success, nvmResultNoPage if the page is unknown.
+ ******************************************************************************/
+NVM_Result_t NVMLOG_Write(uint16_t pageId, uint8_t objectId)
+{
+  NVM_Result_t result;
+  int          idx;
+
+  idx = PageIndexGet(pageId);
+  if (idx < 0)
+    return nvmResultNoPage;
+
+  /* In a transaction the objects are stored by NVMLOG_TransactionCommit(). */
+  if (txn.active)
+  {
+    txn.select[idx] |= SelectMask(objectId);
+    return nvmResultOk;
+  }
+
+  NVMHAL_Init();
+
+  /* A pending transaction must not overwrite the new values later. */
+  result = nvmResultOk;
+  if (txn.unapplied != NULL)
+    result = TxnApply();
+
+  if (result == nvmResultOk)
+    result = PageWrite(idx, SelectMask(objectId));
+
+  NVMHAL_DeInit();
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start a transaction.
+ *
+ * @details
+ *   Objects written with NVMLOG_Write() until NVMLOG_TransactionCommit() are
+ *   stored together, in one or more user pages: after a power failure either
+ *   all of them or none of them hold the new value.
+ *
+ *   Transactions use one of the scratch pages, so the log area must hold at
+ *   least two more flash pages than there are user pages.
+ *
+ * @return
+ *   nvmResultOk on success, nvmResultError if a transaction is already
+ *   started or the log area is too small.
+ ******************************************************************************/
+NVM_Result_t NVMLOG_TransactionBegin(void)
+{
+  int idx;
+
+  if (txn.active || (logConfig->pages < logConfig->userPages + 2))
+    return nvmResultError;
+
+  for (idx = 0; idx < logConfig->userPages; idx++)
+    txn.select[idx] = 0;
+
+  txn.active = true;
+  return nvmResultOk;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Store all objects written since NVMLOG_TransactionBegin().
+ *
+ * @details
+ *   The changed objects are taken from RAM and written to the transaction
+ *   page, followed by a commit record which makes the transaction valid. The
+ *   objects are then stored in their pages. If power fails before the commit
+ *   record is written the transaction is lost, after that NVMLOG_Init()
+ *   completes it.
+ *
+ *   If storing the objects in their pages fails after the commit record, the
+ *   transaction is stored by the next write or commit, before anything else,
+ *   or by NVMLOG_Init(). Until then no transaction is added to the page.
+ *
+ * @return
+ *   nvmResultOk on success, nvmResultError if no transaction is started,
+ *   the changed objects do not fit in a flash page, or an earlier
+ *   transaction still cannot be stored.
+ ******************************************************************************/
+NVM_Result_t NVMLOG_TransactionCommit(void)
+{
+  NVM_Object_Descriptor_t const *obj;
+  NVM_Result_t                  result = nvmResultOk;
+  uint32_t                      needed = 0;
+  uint32_t                      i;
+  uint8_t                       *start;
+  int                           idx;
+
+  if (!txn.active)
+    return nvmResultError;
+  txn.active = false;
+
+  /* Complete an earlier transaction first, it may still hold objects of
+   * this one, and its records must not be erased or marked applied by it. */
+  if (txn.unapplied != NULL)
+  {
+    NVMHAL_Init();
+    result = TxnApply();
+    NVMHAL_DeInit();
+
+    if (result != nvmResultOk)
+      return result;
+  }
+
+  for (idx = 0; idx < logConfig->userPages; idx++)
+  {
+    for (i = 0; i < logLayout[idx].count; i++)
+    {
+      obj = &(*(*logConfig->nvmPages)[idx].page)[i];
+      if (ObjectSelected(obj, txn.select[idx]) && ObjectChanged(idx, obj))
+        needed += NVMLOG_RECORD_SIZE(obj->size);
+    }
+  }
+
+  /* Nothing has changed since last write. */
+  if (needed == 0)
+    return nvmResultOk;
+
+  /* Room for the commit and applied records. */
+  needed += 2 * sizeof(NVMLOG_Record_t);
+  if (needed > NVM_PAGE_SIZE - sizeof(NVMLOG_PageHeader_t))
+    return nvmResultError;
+
+  NVMHAL_Init();
+
+  if ((txn.page == NULL) || (txn.freePos + needed > txn.page + NVM_PAGE_SIZE))
+    result = TxnPageAllocate();
+
+  start = txn.freePos;
+  for (idx = 0; (idx < logConfig->userPages) && (result == nvmResultOk); idx++)
+  {
+    for (i = 0; (i < logLayout[idx].count) && (result == nvmResultOk); i++)
+    {
+      obj = &(*(*logConfig->nvmPages)[idx].page)[i];
+      if (ObjectSelected(obj, txn.select[idx]) && ObjectChanged(idx, obj))
+      {
+        result = RecordWrite(txn.freePos, NVMLOG_RECORD_TXN,
+                             (*logConfig->nvmPages)[idx].pageId,
+                             obj->objectId, obj->location, obj->size);
+        txn.freePos += NVMLOG_RECORD_SIZE(obj->size);
+      }
+    }
+  }
+
+  /* The single commit point of the transaction. */
+  if (result == nvmResultOk)
+  {
+    result = RecordWrite(txn.freePos, NVMLOG_RECORD_COMMIT, 0xFFFF, 0, NULL, 0);
+    txn.freePos += sizeof(NVMLOG_Record_t);
+  }
+
+  if (result == nvmResultOk)
+  {
+    txn.unapplied = start;
+    result        = TxnApply();
+  }
+  else if (txn.page != NULL)
+    txn.freePos = txn.page + NVM_PAGE_SIZE;   /* Start a new page next time. */
+
+  NVMHAL_DeInit();
+
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of times a flash page in the log area has been erased.
+ *
+ * @param[in] page
+ *   Number of the flash page in the log area, 0 to pages - 1.
+ *
+ * @return
+ *   Erase count, 0 if the page number is out of range.
+ ******************************************************************************/
+uint32_t NVMLOG_EraseCountGet(uint32_t page)
+{
+  if (page >= logConfig->pages)
+    return 0;
+
+  return eraseCounts[page];
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the remaining flash life of the log area.
+ *
+ * @details
+ *   Pages are allocated by erase count, so the most worn page limits the life
+ *   of the area.
+ *
+ * @return
+ *   Erase cycles left of the most worn page, NVMLOG_FLASH_ENDURANCE minus its
+ *   erase count, 0 if the endurance has been exceeded.
+ ******************************************************************************/
+uint32_t NVMLOG_EraseCyclesLeft(void)
+{
+  uint32_t maxCount = 0;
+  uint32_t i;
+
+  for (i = 0; i < logConfig->pages; i++)
+  {
+    if (eraseCounts[i] > maxCount)
+      maxCount = eraseCounts[i];
+  }
+
+  if (maxCount >= NVMLOG_FLASH_ENDURANCE)
+    return 0;
+
+  return NVMLOG_FLASH_ENDURANCE - maxCount;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Restore objects of a user page from their last committed copy.
+ *
+ * @param[in] pageId
+ *   User page to read.
+ *
+ * @param[in] objectId
+ *   Object to read, or NVM_WRITE_ALL_CMD for all objects in the page.
+ *
+ * @return
+ *   nvmResultOk on success, nvmResultNoPage if the page or object has not
+ *   been stored.
+ ******************************************************************************/
+NVM_Result_t NVMLOG_Read(uint16_t pageId, uint8_t objectId)
+{
+  NVM_Object_Descriptor_t const *obj;
+  uint8_t const                 *last;
+  NVM_Result_t                  result = nvmResultOk;
+  uint32_t                      i;
+  int                           idx;
+
+  idx = PageIndexGet(pageId);
+  if ((idx < 0) || (logPages[idx].page == NULL))
+    return nvmResultNoPage;
+
+  if (objectId != NVM_WRITE_ALL_CMD)
+  {
+    if ((objectId >= NVMLOG_MAX_OBJECT_IDS)
+        || (objectIndex[idx][objectId].data == NULL))
+      return nvmResultNoPage;
+
+    obj  = objectIndex[idx][objectId].obj;
+    last = objectIndex[idx][objectId].data;
+    memcpy(obj->location, last, obj->size);
+    return nvmResultOk;
+  }
+
+  for (i = 0; i < logLayout[idx].count; i++)
+  {
+    obj  = &(*(*logConfig->nvmPages)[idx].page)[i];
+    last = objectIndex[idx][obj->objectId].data;
+    if (last != NULL)
+      memcpy(obj->location, last, obj->size);
+    else
+      result = nvmResultNoPage;
+  }
+
+  return result;
+}
+
+/** @} (end addtogroup NVMLOG) */
+/** @} (end addtogroup NVM) */
@@ -0,0 +1,193 @@
+/***************************************************************************//**
+ * @file
+ * @brief Non-Volatile Memory delta log.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __NVMLOG_H
+#define __NVMLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "nvm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup NVM
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @defgroup NVMLOG
+ * @brief Delta log storage for NVM pages.
+ * @details
+ *   Stores the objects of an NVM page as a log of object records in a flash
+ *   page. A write compares every object with its last committed copy in flash
+ *   and appends records only for objects that have changed, which costs a few
+ *   word programs instead of a page erase. Only when the flash page is full
+ *   the current image of all objects is consolidated into a fresh page and the
+ *   old page is erased.
+ *
+ *   Pages and objects are described with the same tables as used by the NVM
+ *   driver (@ref NVM_Config_t), but the log needs its own flash area. The
+ *   record offsets and sizes of every page are taken from a layout table
+ *   generated at compile time (@ref NVMLOG_Layout_t, see nvm_layout.h), so
+ *   writes and reads do not walk the object descriptors.
+ *
+ *   The location of the newest record of every object is kept in a RAM index
+ *   which is built by NVMLOG_Init() and updated on every write, so reading an
+ *   object is a direct copy from flash.
+ *
+ *   Pages of type nvmPageTypeWear hold a single object and use a more compact
+ *   format for frequently changing data such as counters: every write appends
+ *   a new version of the object with a sequence number and a check word, and
+ *   NVMLOG_Init() restores the newest valid version. A 2 byte counter takes 8
+ *   bytes per version, so a 4 kB flash page is erased once every 509 writes.
+ *
+ *   Writes to several objects and pages can be grouped in a transaction with
+ *   NVMLOG_TransactionBegin() and NVMLOG_TransactionCommit(). The objects are
+ *   first written to a transaction page, taken from the scratch pages, and
+ *   become valid together with a single commit record. They are then stored
+ *   in their pages, which NVMLOG_Init() completes after a power failure.
+ *
+ *   Every flash page keeps its erase count in its header, written right after
+ *   the erase. A new page is always taken from the least worn unused pages,
+ *   and NVMLOG_EraseCyclesLeft() reports the remaining life of the area.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ ****************************   CONFIGURATION   ********************************
+ ******************************************************************************/
+
+/** Maximum number of user pages handled by the log. */
+#ifndef NVMLOG_MAX_USER_PAGES
+#define NVMLOG_MAX_USER_PAGES    4
+#endif
+
+/** Page IDs must be lower than this value. */
+#ifndef NVMLOG_MAX_PAGE_IDS
+#define NVMLOG_MAX_PAGE_IDS      4
+#endif
+
+/** Maximum number of flash pages in the log area, an erase count of every
+ *  page is kept in RAM. */
+#ifndef NVMLOG_MAX_PAGES
+#define NVMLOG_MAX_PAGES         16
+#endif
+
+/** Guaranteed erase cycles of a flash page, used for the remaining life. */
+#ifndef NVMLOG_FLASH_ENDURANCE
+#define NVMLOG_FLASH_ENDURANCE   20000
+#endif
+
+/** Object IDs must be lower than this value. The RAM index uses
+ *  8 * NVMLOG_MAX_USER_PAGES * NVMLOG_MAX_OBJECT_IDS bytes. */
+#ifndef NVMLOG_MAX_OBJECT_IDS
+#define NVMLOG_MAX_OBJECT_IDS    8
+#endif
+
+/*******************************************************************************
+ ******************************   TYPEDEFS   ***********************************
+ ******************************************************************************/
+
+/** Header at the start of every flash page used by the log. */
+typedef struct
+{
+  uint32_t magic;          /**< NVMLOG_PAGE_MAGIC, written after eraseCount. */
+  uint32_t eraseCount;     /**< Erases of this flash page.                   */
+  uint16_t pageId;         /**< User page stored in this flash page.         */
+  uint16_t pageIdInv;      /**< Inverted pageId, detects torn headers.       */
+  uint32_t version;        /**< Incremented on every consolidation.          */
+  uint32_t committed;      /**< NVMLOG_PAGE_COMMITTED once image is written. */
+} NVMLOG_PageHeader_t;
+
+/** Header of every object record, followed by word aligned object data. */
+typedef struct
+{
+  uint8_t  objectId;       /**< Object ID.                                   */
+  uint8_t  type;           /**< Record type, NVMLOG_RECORD_OBJECT.           */
+  uint16_t size;           /**< Size of object data in bytes.                */
+  uint16_t checksum;       /**< Checksum of the header and the data.        */
+  uint16_t pageId;         /**< Page of a transaction record, else erased.   */
+} NVMLOG_Record_t;
+
+/** Header of every version record in a wear page, followed by word aligned
+ *  object data. */
+typedef struct
+{
+  uint16_t sequence;       /**< Incremented for every version, 15 bit.       */
+  uint16_t checksum;       /**< Checksum of the sequence and the data.       */
+} NVMLOG_WearRecord_t;
+
+/** Size of an object record in flash, including padding. */
+#define NVMLOG_RECORD_SIZE(size) (sizeof(NVMLOG_Record_t) + (((size) + 3) & ~3))
+
+/** Size of a version record in a wear page, including padding. */
+#define NVMLOG_WEAR_RECORD_SIZE(size) (sizeof(NVMLOG_WearRecord_t) + (((size) + 3) & ~3))
+
+/** Layout of a user page, generated by NVM_LAYOUT_TABLE(). Objects are in
+ *  the order of the page descriptor. */
+typedef struct
+{
+  uint16_t       count;    /**< Number of objects in the page.               */
+  uint16_t const *offset;  /**< Offset of the record of every object in a
+                                consolidated page, count + 1 entries, the
+                                last is the packed size of the page.         */
+  uint16_t const *size;    /**< Size of the record of every object.          */
+} NVMLOG_Layout_t;
+
+/*******************************************************************************
+ *****************************   PROTOTYPES   **********************************
+ ******************************************************************************/
+
+NVM_Result_t NVMLOG_Init(NVM_Config_t const *config,
+                         NVMLOG_Layout_t const *layout);
+NVM_Result_t NVMLOG_Erase(void);
+NVM_Result_t NVMLOG_Write(uint16_t pageId, uint8_t objectId);
+NVM_Result_t NVMLOG_Read(uint16_t pageId, uint8_t objectId);
+NVM_Result_t NVMLOG_TransactionBegin(void);
+NVM_Result_t NVMLOG_TransactionCommit(void);
+uint32_t     NVMLOG_EraseCountGet(uint32_t page);
+uint32_t     NVMLOG_EraseCyclesLeft(void);
+
+/** @} (end defgroup NVMLOG) */
+/** @} (end addtogroup NVM) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NVMLOG_H */
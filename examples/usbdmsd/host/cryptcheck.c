@@ -0,0 +1,265 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the software AES of the usbdmsd sector encryption.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The block functions of the software AES are static, so the source is
+   included rather than linked. */
+#include "../msddcrypt.c"
+
+/******************************************************************************
+ * The software AES-128 of msddcrypt.c is checked against the key expansion
+ * of FIPS-197 appendix A.1 and the cipher example of appendix C.1, in both
+ * directions. MSDDCRYPT_Encrypt() is checked to chain the blocks of a sector
+ * in CBC mode from the ESSIV of the sector, to decrypt back to the
+ * plaintext, and to give different ciphertext for the same plaintext at
+ * different sectors. The encryption and decryption throughput is measured
+ * last.
+ *****************************************************************************/
+
+#define SECTOR_SIZE         512
+
+/* Sectors per benchmark pass, and passes; the fastest pass is reported */
+#define BENCH_SECTORS       2048
+#define BENCH_PASSES        5
+
+/* FIPS-197 appendix A.1 */
+static const uint8_t fipsKeyA1[ AES_BLOCKSIZE ] =
+{
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+  0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static const uint8_t fipsLastRoundKeyA1[ AES_BLOCKSIZE ] =
+{
+  0xd0, 0x14, 0xf9, 0xa8, 0xc9, 0xee, 0x25, 0x89,
+  0xe1, 0x3f, 0x0c, 0xc8, 0xb6, 0x63, 0x0c, 0xa6
+};
+
+/* FIPS-197 appendix C.1 */
+static const uint8_t fipsKeyC1[ AES_BLOCKSIZE ] =
+{
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+static const uint8_t fipsPlainC1[ AES_BLOCKSIZE ] =
+{
+  0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+  0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+static const uint8_t fipsCipherC1[ AES_BLOCKSIZE ] =
+{
+  0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+  0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+static const uint8_t mediaKey[ AES_BLOCKSIZE ] = MSD_CRYPT_KEY;
+
+static uint32_t sectorBuf[ BENCH_SECTORS * SECTOR_SIZE / 4 ];
+
+static int failures;
+
+
+static void check( bool ok, const char *what )
+{
+  printf( "  %-48s %s\n", what, ok ? "ok" : "FAILED" );
+  if ( !ok )
+    failures++;
+}
+
+
+/**************************************************************************//**
+ * @brief  FIPS-197 key expansion and cipher examples
+ *****************************************************************************/
+static void checkFips( void )
+{
+  uint8_t roundKeys[ AES_BLOCKSIZE * ( AES_ROUNDS + 1 ) ];
+  uint8_t block[ AES_BLOCKSIZE ];
+
+  printf( "FIPS-197:\n" );
+
+  SwKeyExpand( roundKeys, fipsKeyA1 );
+  check( memcmp( &roundKeys[ AES_ROUNDS * AES_BLOCKSIZE ], fipsLastRoundKeyA1,
+                 AES_BLOCKSIZE ) == 0, "A.1 key expansion, last round key" );
+
+  SwKeyExpand( roundKeys, fipsKeyC1 );
+  memcpy( block, fipsPlainC1, AES_BLOCKSIZE );
+  SwEncryptBlock( block, roundKeys );
+  check( memcmp( block, fipsCipherC1, AES_BLOCKSIZE ) == 0,
+         "C.1 AES-128 encrypt" );
+
+  SwDecryptBlock( block, roundKeys );
+  check( memcmp( block, fipsPlainC1, AES_BLOCKSIZE ) == 0,
+         "C.1 AES-128 decrypt" );
+}
+
+
+/**************************************************************************//**
+ * @brief  CBC-ESSIV sector encryption
+ *****************************************************************************/
+static void checkSectors( void )
+{
+  uint8_t  plain[ SECTOR_SIZE ];
+  uint32_t sector[ 3 ][ SECTOR_SIZE / 4 ];
+  uint8_t  *cipher = (uint8_t*)sector[ 0 ];
+  uint8_t  block[ AES_BLOCKSIZE ];
+  uint8_t  iv[ AES_BLOCKSIZE ];
+  const uint8_t *prev;
+  bool     chained = true;
+  bool     differ  = true;
+  int      i, j;
+
+  printf( "CBC-ESSIV sectors:\n" );
+
+  srand( 1 );
+  for ( i = 0; i < SECTOR_SIZE; i++ )
+    plain[ i ] = (uint8_t)rand();
+
+  MSDDCRYPT_Init( mediaKey );
+
+  memcpy( sector[ 0 ], plain, SECTOR_SIZE );
+  memcpy( sector[ 1 ], plain, SECTOR_SIZE );
+  memcpy( sector[ 2 ], plain, SECTOR_SIZE );
+  MSDDCRYPT_Encrypt( (uint8_t*)sector[ 0 ], 1000, 1 );
+  MSDDCRYPT_Encrypt( (uint8_t*)sector[ 1 ], 1001, 1 );
+  MSDDCRYPT_Encrypt( (uint8_t*)sector[ 2 ], 0x01000000 + 1000, 1 );
+
+  /* Every block is the plaintext XOR the previous ciphertext, encrypted,
+     starting from the sector IV */
+  SectorIv( iv, 1000 );
+  prev = iv;
+  for ( i = 0; i < SECTOR_SIZE; i += AES_BLOCKSIZE )
+  {
+    for ( j = 0; j < AES_BLOCKSIZE; j++ )
+      block[ j ] = plain[ i + j ] ^ prev[ j ];
+    SwEncryptBlock( block, encRoundKeys );
+    if ( memcmp( block, &cipher[ i ], AES_BLOCKSIZE ) != 0 )
+      chained = false;
+    prev = &cipher[ i ];
+  }
+  check( chained, "blocks chained from the ESSIV of the sector" );
+
+  for ( i = 0; i < SECTOR_SIZE; i += AES_BLOCKSIZE )
+  {
+    if ( ( memcmp( &cipher[ i ], (uint8_t*)sector[ 1 ] + i, AES_BLOCKSIZE ) == 0 ) ||
+         ( memcmp( &cipher[ i ], (uint8_t*)sector[ 2 ] + i, AES_BLOCKSIZE ) == 0 ) )
+      differ = false;
+  }
+  check( differ, "same plaintext, other LBA, every block differs" );
+  check( memcmp( cipher, plain, SECTOR_SIZE ) != 0, "ciphertext differs from plaintext" );
+
+  MSDDCRYPT_Decrypt( (uint8_t*)sector[ 0 ], 1000, 1 );
+  MSDDCRYPT_Decrypt( (uint8_t*)sector[ 1 ], 1001, 1 );
+  MSDDCRYPT_Decrypt( (uint8_t*)sector[ 2 ], 0x01000000 + 1000, 1 );
+  check( ( memcmp( sector[ 0 ], plain, SECTOR_SIZE ) == 0 ) &&
+         ( memcmp( sector[ 1 ], plain, SECTOR_SIZE ) == 0 ) &&
+         ( memcmp( sector[ 2 ], plain, SECTOR_SIZE ) == 0 ),
+         "decrypt round trip" );
+
+  memcpy( sector[ 0 ], plain, SECTOR_SIZE );
+  MSDDCRYPT_Encrypt( (uint8_t*)sector[ 0 ], 1000, 1 );
+  MSDDCRYPT_Decrypt( (uint8_t*)sector[ 0 ], 1001, 1 );
+  check( memcmp( sector[ 0 ], plain, SECTOR_SIZE ) != 0,
+         "decrypt with the wrong LBA fails" );
+
+  /* Several sectors in one call are the same as one at a time */
+  memcpy( sector[ 0 ], plain, SECTOR_SIZE );
+  memcpy( sector[ 1 ], plain, SECTOR_SIZE );
+  MSDDCRYPT_Encrypt( (uint8_t*)sector[ 0 ], 1000, 2 );
+  memcpy( sector[ 2 ], plain, SECTOR_SIZE );
+  MSDDCRYPT_Encrypt( (uint8_t*)sector[ 2 ], 1001, 1 );
+  check( memcmp( sector[ 1 ], sector[ 2 ], SECTOR_SIZE ) == 0,
+         "multi sector call, sector LBAs increment" );
+}
+
+
+static double seconds( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**************************************************************************//**
+ * @brief  Throughput of the software AES
+ *****************************************************************************/
+static void benchmark( void )
+{
+  double start, encrypt = 1e9, decrypt = 1e9, t;
+  int    pass;
+
+  memset( sectorBuf, 0x5a, sizeof( sectorBuf ) );
+
+  for ( pass = 0; pass < BENCH_PASSES; pass++ )
+  {
+    start = seconds();
+    MSDDCRYPT_Encrypt( (uint8_t*)sectorBuf, 0, BENCH_SECTORS );
+    t = seconds() - start;
+    if ( t < encrypt )
+      encrypt = t;
+
+    start = seconds();
+    MSDDCRYPT_Decrypt( (uint8_t*)sectorBuf, 0, BENCH_SECTORS );
+    t = seconds() - start;
+    if ( t < decrypt )
+      decrypt = t;
+  }
+
+  printf( "software AES, %d sectors, fastest of %d passes:\n",
+          BENCH_SECTORS, BENCH_PASSES );
+  printf( "  encrypt  %7.2f us/sector  %7.2f MB/s\n",
+          encrypt * 1e6 / BENCH_SECTORS,
+          BENCH_SECTORS * SECTOR_SIZE / encrypt / 1e6 );
+  printf( "  decrypt  %7.2f us/sector  %7.2f MB/s\n",
+          decrypt * 1e6 / BENCH_SECTORS,
+          BENCH_SECTORS * SECTOR_SIZE / decrypt / 1e6 );
+}
+
+
+int main( void )
+{
+  checkFips();
+  checkSectors();
+  benchmark();
+
+  printf( "%s\n", failures ? "FAILED" : "OK" );
+  return failures ? 1 : 0;
+}
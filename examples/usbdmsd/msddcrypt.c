@@ -0,0 +1,409 @@
+/**************************************************************************//**
+ * @file  msddcrypt.c
+ * @brief Sector encryption for the Mass Storage class Device (MSD) media.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2012 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <string.h>
+#if defined( MSDDCRYPT_HOST )
+#include "cryptsim.h"     /* Host build, see host/readme.txt */
+#else
+#include "em_usb.h"
+#include "em_cmu.h"
+
+#include "msdd.h"
+#include "msddmedia.h"
+#endif
+#include "msddcrypt.h"
+
+#if ( MSD_CRYPT == 1 )
+
+#if ( MSD_CRYPT_SOFTWARE == 0 )
+#include "em_aes.h"
+#if !defined( AES_COUNT ) || ( AES_COUNT == 0 )
+#error "Device has no AES peripheral, use MSD_CRYPT_SOFTWARE."
+#endif
+#endif
+
+#define AES_BLOCKSIZE   16
+#define AES_ROUNDS      10
+
+/* Plaintext used for deriving the ESSIV key from the media key. */
+static const uint8_t essivSalt[ AES_BLOCKSIZE ] =
+{
+  'M', 'S', 'D', 'D', ' ', 'E', 'S', 'S', 'I', 'V', ' ', 'S', 'A', 'L', 'T', 0
+};
+
+#if ( MSD_CRYPT_SOFTWARE == 0 )
+
+EFM32_ALIGN(4)
+static uint8_t encKey[ AES_BLOCKSIZE ];       /* Media encryption key     */
+EFM32_ALIGN(4)
+static uint8_t decKey[ AES_BLOCKSIZE ];       /* Media decryption key     */
+EFM32_ALIGN(4)
+static uint8_t essivKey[ AES_BLOCKSIZE ];     /* Sector IV generation key */
+
+#else
+
+static uint8_t encRoundKeys[ AES_BLOCKSIZE * ( AES_ROUNDS + 1 ) ];
+static uint8_t essivRoundKeys[ AES_BLOCKSIZE * ( AES_ROUNDS + 1 ) ];
+
+static const uint8_t sbox[ 256 ] =
+{
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+static const uint8_t rsbox[ 256 ] =
+{
+  0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+  0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+  0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+  0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+  0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+  0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+  0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+  0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+  0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+  0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+  0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+  0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+  0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+  0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+  0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+  0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
+};
+
+/**************************************************************************//**
+ * @brief
+ *   Multiply by x in GF(2^8).
+ *****************************************************************************/
+static uint8_t XTime( uint8_t x )
+{
+  return (uint8_t)( ( x << 1 ) ^ ( ( x & 0x80 ) ? 0x1B : 0x00 ) );
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Multiply two elements of GF(2^8).
+ *****************************************************************************/
+static uint8_t GfMul( uint8_t a, uint8_t b )
+{
+  uint8_t result = 0;
+
+  while ( b )
+  {
+    if ( b & 1 )
+      result ^= a;
+    a   = XTime( a );
+    b >>= 1;
+  }
+  return result;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Expand a 128 bit key into the AES-128 key schedule.
+ *****************************************************************************/
+static void SwKeyExpand( uint8_t *roundKeys, const uint8_t *key )
+{
+  int     i;
+  uint8_t t[ 4 ], tmp, rcon = 0x01;
+
+  memcpy( roundKeys, key, AES_BLOCKSIZE );
+
+  for ( i = AES_BLOCKSIZE; i < AES_BLOCKSIZE * ( AES_ROUNDS + 1 ); i += 4 )
+  {
+    memcpy( t, &roundKeys[ i - 4 ], 4 );
+
+    if ( ( i % AES_BLOCKSIZE ) == 0 )
+    {
+      tmp    = t[ 0 ];
+      t[ 0 ] = sbox[ t[ 1 ] ] ^ rcon;
+      t[ 1 ] = sbox[ t[ 2 ] ];
+      t[ 2 ] = sbox[ t[ 3 ] ];
+      t[ 3 ] = sbox[ tmp ];
+      rcon   = XTime( rcon );
+    }
+
+    roundKeys[ i     ] = roundKeys[ i - 16 ] ^ t[ 0 ];
+    roundKeys[ i + 1 ] = roundKeys[ i - 15 ] ^ t[ 1 ];
+    roundKeys[ i + 2 ] = roundKeys[ i - 14 ] ^ t[ 2 ];
+    roundKeys[ i + 3 ] = roundKeys[ i - 13 ] ^ t[ 3 ];
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Combined SubBytes and ShiftRows (or their inverses) on a state.
+ *****************************************************************************/
+static void SwSubShift( uint8_t *s, const uint8_t *box, bool inverse )
+{
+  uint8_t t[ AES_BLOCKSIZE ];
+  int     c, r, src;
+
+  for ( c = 0; c < 4; c++ )
+  {
+    for ( r = 0; r < 4; r++ )
+    {
+      src = inverse ? ( ( c - r + 4 ) & 3 ) : ( ( c + r ) & 3 );
+      t[ c * 4 + r ] = box[ s[ src * 4 + r ] ];
+    }
+  }
+  memcpy( s, t, AES_BLOCKSIZE );
+}
+
+/**************************************************************************//**
+ * @brief
+ *   XOR a round key into the state.
+ *****************************************************************************/
+static void SwAddRoundKey( uint8_t *s, const uint8_t *roundKey )
+{
+  int i;
+
+  for ( i = 0; i < AES_BLOCKSIZE; i++ )
+    s[ i ] ^= roundKey[ i ];
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Encrypt one block in place with the software AES-128 implementation.
+ *****************************************************************************/
+static void SwEncryptBlock( uint8_t *s, const uint8_t *roundKeys )
+{
+  int     round, c;
+  uint8_t *col, a0, a1, a2, a3;
+
+  SwAddRoundKey( s, roundKeys );
+
+  for ( round = 1; round <= AES_ROUNDS; round++ )
+  {
+    SwSubShift( s, sbox, false );
+
+    if ( round != AES_ROUNDS )
+    {
+      for ( c = 0; c < 4; c++ )
+      {
+        col = &s[ c * 4 ];
+        a0 = col[ 0 ]; a1 = col[ 1 ]; a2 = col[ 2 ]; a3 = col[ 3 ];
+        col[ 0 ] = XTime( a0 ^ a1 ) ^ a1 ^ a2 ^ a3;
+        col[ 1 ] = XTime( a1 ^ a2 ) ^ a2 ^ a3 ^ a0;
+        col[ 2 ] = XTime( a2 ^ a3 ) ^ a3 ^ a0 ^ a1;
+        col[ 3 ] = XTime( a3 ^ a0 ) ^ a0 ^ a1 ^ a2;
+      }
+    }
+
+    SwAddRoundKey( s, &roundKeys[ round * AES_BLOCKSIZE ] );
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Decrypt one block in place with the software AES-128 implementation.
+ *****************************************************************************/
+static void SwDecryptBlock( uint8_t *s, const uint8_t *roundKeys )
+{
+  int     round, c;
+  uint8_t *col, a0, a1, a2, a3;
+
+  SwAddRoundKey( s, &roundKeys[ AES_ROUNDS * AES_BLOCKSIZE ] );
+
+  for ( round = AES_ROUNDS - 1; round >= 0; round-- )
+  {
+    SwSubShift( s, rsbox, true );
+    SwAddRoundKey( s, &roundKeys[ round * AES_BLOCKSIZE ] );
+
+    if ( round != 0 )
+    {
+      for ( c = 0; c < 4; c++ )
+      {
+        col = &s[ c * 4 ];
+        a0 = col[ 0 ]; a1 = col[ 1 ]; a2 = col[ 2 ]; a3 = col[ 3 ];
+        col[ 0 ] = GfMul( a0, 14 ) ^ GfMul( a1, 11 ) ^ GfMul( a2, 13 ) ^ GfMul( a3,  9 );
+        col[ 1 ] = GfMul( a0,  9 ) ^ GfMul( a1, 14 ) ^ GfMul( a2, 11 ) ^ GfMul( a3, 13 );
+        col[ 2 ] = GfMul( a0, 13 ) ^ GfMul( a1,  9 ) ^ GfMul( a2, 14 ) ^ GfMul( a3, 11 );
+        col[ 3 ] = GfMul( a0, 11 ) ^ GfMul( a1, 13 ) ^ GfMul( a2,  9 ) ^ GfMul( a3, 14 );
+      }
+    }
+  }
+}
+
+#endif /* MSD_CRYPT_SOFTWARE */
+
+/**************************************************************************//**
+ * @brief
+ *   Compute the ESSIV initialization vector of a sector.
+ *****************************************************************************/
+static void SectorIv( uint8_t *iv, uint32_t lba )
+{
+  memset( iv, 0, AES_BLOCKSIZE );
+  iv[ 0 ] = (uint8_t)lba;
+  iv[ 1 ] = (uint8_t)( lba >> 8 );
+  iv[ 2 ] = (uint8_t)( lba >> 16 );
+  iv[ 3 ] = (uint8_t)( lba >> 24 );
+
+  #if ( MSD_CRYPT_SOFTWARE == 0 )
+  AES_ECB128( iv, iv, AES_BLOCKSIZE, essivKey, true );
+  #else
+  SwEncryptBlock( iv, essivRoundKeys );
+  #endif
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize media encryption.
+ *
+ * @param[in] key
+ *   128 bit media key.
+ *****************************************************************************/
+void MSDDCRYPT_Init( const uint8_t *key )
+{
+  #if ( MSD_CRYPT_SOFTWARE == 0 )
+  CMU_ClockEnable( cmuClock_AES, true );
+
+  memcpy( encKey, key, AES_BLOCKSIZE );
+  AES_DecryptKey128( decKey, encKey );
+  /* The AES peripheral reads words, so the salt is encrypted in place in
+     the aligned key buffer. */
+  memcpy( essivKey, essivSalt, AES_BLOCKSIZE );
+  AES_ECB128( essivKey, essivKey, AES_BLOCKSIZE, encKey, true );
+  #else
+  uint8_t essivKey[ AES_BLOCKSIZE ];
+
+  SwKeyExpand( encRoundKeys, key );
+  memcpy( essivKey, essivSalt, AES_BLOCKSIZE );
+  SwEncryptBlock( essivKey, encRoundKeys );
+  SwKeyExpand( essivRoundKeys, essivKey );
+  #endif
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Decrypt media sectors in place.
+ *
+ * @param[in] data
+ *   Pointer to word aligned sector data.
+ *
+ * @param[in] lba
+ *   Media "Logical Block Address" of the first sector.
+ *
+ * @param[in] sectors
+ *   Number of 512 byte sectors to decrypt.
+ *****************************************************************************/
+void MSDDCRYPT_Decrypt( uint8_t *data, uint32_t lba, uint32_t sectors )
+{
+  uint32_t iv[ AES_BLOCKSIZE / 4 ];
+  #if ( MSD_CRYPT_SOFTWARE == 1 )
+  uint8_t prev[ AES_BLOCKSIZE ], next[ AES_BLOCKSIZE ];
+  int     i, j;
+  #endif
+
+  while ( sectors-- )
+  {
+    SectorIv( (uint8_t*)iv, lba );
+
+    #if ( MSD_CRYPT_SOFTWARE == 0 )
+    AES_CBC128( data, data, 512, decKey, (uint8_t*)iv, false );
+    #else
+    memcpy( prev, (uint8_t*)iv, AES_BLOCKSIZE );
+    for ( i = 0; i < 512; i += AES_BLOCKSIZE )
+    {
+      memcpy( next, &data[ i ], AES_BLOCKSIZE );
+      SwDecryptBlock( &data[ i ], encRoundKeys );
+      for ( j = 0; j < AES_BLOCKSIZE; j++ )
+        data[ i + j ] ^= prev[ j ];
+      memcpy( prev, next, AES_BLOCKSIZE );
+    }
+    #endif
+
+    data += 512;
+    lba++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Encrypt media sectors in place.
+ *
+ * @param[in] data
+ *   Pointer to word aligned sector data.
+ *
+ * @param[in] lba
+ *   Media "Logical Block Address" of the first sector.
+ *
+ * @param[in] sectors
+ *   Number of 512 byte sectors to encrypt.
+ *****************************************************************************/
+void MSDDCRYPT_Encrypt( uint8_t *data, uint32_t lba, uint32_t sectors )
+{
+  uint32_t iv[ AES_BLOCKSIZE / 4 ];
+  #if ( MSD_CRYPT_SOFTWARE == 1 )
+  uint8_t *prev;
+  int     i, j;
+  #endif
+
+  while ( sectors-- )
+  {
+    SectorIv( (uint8_t*)iv, lba );
+
+    #if ( MSD_CRYPT_SOFTWARE == 0 )
+    AES_CBC128( data, data, 512, encKey, (uint8_t*)iv, true );
+    #else
+    prev = (uint8_t*)iv;
+    for ( i = 0; i < 512; i += AES_BLOCKSIZE )
+    {
+      for ( j = 0; j < AES_BLOCKSIZE; j++ )
+        data[ i + j ] ^= prev[ j ];
+      SwEncryptBlock( &data[ i ], encRoundKeys );
+      prev = &data[ i ];
+    }
+    #endif
+
+    data += 512;
+    lba++;
+  }
+}
+
+#endif /* MSD_CRYPT == 1 */
@@ -0,0 +1,91 @@
+/***************************************************************************//**
+ * @file  msddcrypt.h
+ * @brief Sector encryption for the Mass Storage class Device (MSD) media.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2012 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __MSDDCRYPT_H
+#define __MSDDCRYPT_H
+
+/*
+ * Set MSD_CRYPT to 1 to store all media sectors AES-128 encrypted.
+ *
+ * Sectors are encrypted in CBC mode with an ESSIV initialization vector,
+ * i.e. the IV of a sector is the sector number encrypted with a second key
+ * derived from the media key. Identical plaintext sectors therefore encrypt
+ * to different ciphertext, and a sector can be decrypted on its own.
+ *
+ * The AES peripheral is used by default. Set MSD_CRYPT_SOFTWARE to 1 to use
+ * a portable software AES implementation instead, e.g. on devices without an
+ * AES peripheral or to compare throughput.
+ */
+#if !defined( MSD_CRYPT )
+#define MSD_CRYPT               0
+#endif
+
+#if !defined( MSD_CRYPT_SOFTWARE )
+#define MSD_CRYPT_SOFTWARE      0
+#endif
+
+/*
+ * 128 bit media key. NOTE: This is only an example key, a real application
+ * must provision a device unique key, e.g. in the lock bits page.
+ */
+#if !defined( MSD_CRYPT_KEY )
+#define MSD_CRYPT_KEY { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, \
+                        0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c }
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if ( MSD_CRYPT == 1 )
+
+/*** MSD Encryption Function prototypes ***/
+
+void MSDDCRYPT_Init( const uint8_t *key );
+void MSDDCRYPT_Decrypt( uint8_t *data, uint32_t lba, uint32_t sectors );
+void MSDDCRYPT_Encrypt( uint8_t *data, uint32_t lba, uint32_t sectors );
+
+#else
+
+#define MSDDCRYPT_Init( key )
+#define MSDDCRYPT_Decrypt( data, lba, sectors )
+#define MSDDCRYPT_Encrypt( data, lba, sectors )
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MSDDCRYPT_H */
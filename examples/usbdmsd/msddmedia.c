@@ -36,6 +36,8 @@
 
 #include "msdd.h"
 #include "msddmedia.h"
+#include "msddstats.h"
+#include "msddcrypt.h"
 
 #if ( MSD_MEDIA == MSD_PSRAM_MEDIA )
 #include "em_ebi.h"
@@ -92,8 +94,11 @@
 
     struct
     {
-      uint8_t *pPageBase;
-      bool    pendingWrite;
+      uint8_t  *pPageBase;
+      bool     pendingWrite;
+      uint32_t seqStart;      /* Sequentially written range in page buffer */
+      uint32_t seqEnd;
+      uint8_t  *pTimedOutPage;/* Last page flushed by the flush timer      */
     } flashStatus;
 
     static uint8_t  *storage = (uint8_t*)(64*1024);
@@ -106,8 +111,11 @@
 
     struct
     {
-      uint8_t *pPageBase;
-      bool    pendingWrite;
+      uint8_t  *pPageBase;
+      bool     pendingWrite;
+      uint32_t seqStart;      /* Sequentially written range in page buffer */
+      uint32_t seqEnd;
+      uint8_t  *pTimedOutPage;/* Last page flushed by the flush timer      */
     } flashStatus;
 
     static uint8_t  *storage;
@@ -120,10 +128,21 @@
 #endif
 
 #define FLUSH_TIMER           0       /* Timer id. */
-#define FLUSH_TIMER_TIMEOUT   250     /* Unit is milliseconds. */
+#define FLUSH_TIMER_TIMEOUT   250     /* Unit is milliseconds, upper limit. */
+#define FLUSH_TIMER_MIN       10      /* Unit is milliseconds, lower limit. */
 
 static uint32_t numSectors;
 
+#if ( MSD_CRYPT == 1 )
+static const uint8_t mediaKey[] = MSD_CRYPT_KEY;
+#endif
+
+#if ( MSD_MEDIA == MSD_FLASH_MEDIA ) || ( MSD_MEDIA == MSD_NORFLASH_MEDIA )
+static uint32_t flushTimeout;         /* Current flush delay, milliseconds. */
+static uint32_t avgWriteGap;          /* Average write gap, ms * 8.         */
+static uint32_t lastWriteFrame;       /* USB frame number of last write.    */
+#endif
+
 #if ( MSD_MEDIA == MSD_FLASH_MEDIA ) || ( MSD_MEDIA == MSD_NORFLASH_MEDIA )
 /**************************************************************************//**
  * @brief
@@ -191,8 +210,53 @@ static void FlushFlash( void )
  *****************************************************************************/
 static void FlushTimerTimeout(void)
 {
+  flashStatus.pTimedOutPage = flashStatus.pPageBase;
   MSDDMEDIA_Flush();
 }
+
+/**************************************************************************//**
+ * @brief
+ *   Adapt the flush delay to the observed gaps between media writes.
+ *
+ * @details
+ *   The USB frame number is used as a millisecond timebase. Write gaps are
+ *   only sampled while a partially written page is pending, which means the
+ *   gap is shorter than the current flush delay and the 11 bit frame number
+ *   can not wrap. The delay tracks a small multiple of the average gap so that
+ *   bursts of small writes are still coalesced in the page buffer, while
+ *   isolated writes are committed quickly. If the flush timer expires and the
+ *   host then writes to the same page again, the delay was too short and is
+ *   doubled.
+ *
+ * @param[in] pPage
+ *   Base address of the flash page about to be written.
+ *****************************************************************************/
+static void FlushTimerAdapt( uint8_t *pPage )
+{
+  uint32_t frame, gap, timeout;
+
+  frame = ( USB->DSTS & _USB_DSTS_SOFFN_MASK ) >> _USB_DSTS_SOFFN_SHIFT;
+
+  if ( flashStatus.pendingWrite )
+  {
+    gap          = ( frame - lastWriteFrame ) & 0x7FF;
+    avgWriteGap += gap - ( avgWriteGap >> 3 );
+    timeout      = FLUSH_TIMER_MIN + ( avgWriteGap >> 1 );  /* 4 x average */
+    if ( timeout > FLUSH_TIMER_TIMEOUT )
+      timeout = FLUSH_TIMER_TIMEOUT;
+    flushTimeout = timeout;
+  }
+  else if ( flashStatus.pTimedOutPage == pPage )
+  {
+    flushTimeout *= 2;
+    if ( flushTimeout > FLUSH_TIMER_TIMEOUT )
+      flushTimeout = FLUSH_TIMER_TIMEOUT;
+    avgWriteGap = ( flushTimeout - FLUSH_TIMER_MIN ) * 2;
+  }
+
+  flashStatus.pTimedOutPage = NULL;
+  lastWriteFrame = frame;
+}
 #endif
 
 /**************************************************************************//**
@@ -215,13 +279,33 @@ static void FlushTimerTimeout(void)
 bool MSDDMEDIA_CheckAccess( MSDD_CmdStatus_TypeDef *pCmd,
                             uint32_t lba, uint32_t sectors )
 {
+  #if ( MSD_STATS == 1 )
+  if ( MSDDSTATS_IsStatsLba( lba ) && ( sectors == 1 ) )
+  {
+    /* Hidden statistics sector, see msddstats.h. */
+    pCmd->lba      = lba;
+    pCmd->xferType = XFER_INDIRECT;
+    pCmd->maxBurst = MEDIA_BUFSIZ;
+    pCmd->xferLen  = 512;
+    return true;
+  }
+  #endif
+
   if ( ( lba + sectors ) > numSectors )
     return false;
 
+  MSDDSTATS_Access( lba, sectors, pCmd->direction );
+
   #if ( MSD_MEDIA == MSD_SRAM_MEDIA ) || ( MSD_MEDIA == MSD_PSRAM_MEDIA )
   pCmd->pData    = &storage[ lba * 512 ];
+  #if ( MSD_CRYPT == 1 )
+  /* Data must pass through the cipher, no direct access to the media. */
+  pCmd->xferType = XFER_INDIRECT;
+  pCmd->maxBurst = MEDIA_BUFSIZ;
+  #else
   pCmd->xferType = XFER_MEMORYMAPPED;
   #endif
+  #endif
 
   #if ( MSD_MEDIA == MSD_SDCARD_MEDIA )
   pCmd->lba      = lba;
@@ -232,7 +316,7 @@ bool MSDDMEDIA_CheckAccess( MSDD_CmdStatus_TypeDef *pCmd,
   #if ( MSD_MEDIA == MSD_FLASH_MEDIA ) || ( MSD_MEDIA == MSD_NORFLASH_MEDIA )
   pCmd->lba   = lba;
   pCmd->pData = &storage[ lba * 512 ];
-  if ( pCmd->direction && !flashStatus.pendingWrite )
+  if ( pCmd->direction && !flashStatus.pendingWrite && ( MSD_CRYPT == 0 ) )
   {
     pCmd->xferType = XFER_MEMORYMAPPED;
   }
@@ -255,11 +339,15 @@ bool MSDDMEDIA_CheckAccess( MSDD_CmdStatus_TypeDef *pCmd,
 void MSDDMEDIA_Flush( void )
 {
   #if ( MSD_MEDIA == MSD_FLASH_MEDIA ) || ( MSD_MEDIA == MSD_NORFLASH_MEDIA )
+  uint32_t flushStart;
+
   if ( flashStatus.pendingWrite )
   {
     flashStatus.pendingWrite = false;
     USBTIMER_Stop( FLUSH_TIMER );
+    flushStart = MSDDSTATS_FlushBegin();
     FlushFlash();
+    MSDDSTATS_FlushEnd( ( flashStatus.pPageBase - storage ) / 512, flushStart );
   }
   #endif
 }
@@ -304,14 +392,19 @@ bool MSDDMEDIA_Init( void )
     return false;
   #endif
 
+  #if ( MSD_MEDIA == MSD_FLASH_MEDIA ) || ( MSD_MEDIA == MSD_NORFLASH_MEDIA )
+  flashStatus.pendingWrite  = false;
+  flashStatus.pTimedOutPage = NULL;
+  flushTimeout              = FLUSH_TIMER_TIMEOUT;
+  avgWriteGap               = ( FLUSH_TIMER_TIMEOUT - FLUSH_TIMER_MIN ) * 2;
+  #endif
+
   #if ( MSD_MEDIA == MSD_FLASH_MEDIA )
-  flashStatus.pendingWrite = false;
   MSC_Init();                         /* Unlock and calibrate flash timing  */
   MSC_Deinit();                       /* Lock flash                         */
   #endif
 
   #if ( MSD_MEDIA == MSD_NORFLASH_MEDIA )
-  flashStatus.pendingWrite = false;
   NORFLASH_Init();                    /* Initialize NORFLASH interface      */
 
   storage       = (uint8_t*)NORFLASH_DeviceInfo()->baseAddress;
@@ -321,6 +414,9 @@ bool MSDDMEDIA_Init( void )
   numSectors    = NORFLASH_DeviceInfo()->deviceSize / 512;
   #endif
 
+  MSDDCRYPT_Init( mediaKey );
+  MSDDSTATS_Init( numSectors );
+
   return true;
 }
 
@@ -340,20 +436,36 @@ bool MSDDMEDIA_Init( void )
  *****************************************************************************/
 void MSDDMEDIA_Read( MSDD_CmdStatus_TypeDef *pCmd, uint8_t *data, uint32_t sectors )
 {
+  #if ( MSD_STATS == 1 )
+  if ( MSDDSTATS_IsStatsLba( pCmd->lba ) )
+  {
+    MSDDSTATS_Read( data );
+    return;
+  }
+  #endif
+
   #if ( MSD_MEDIA == MSD_SRAM_MEDIA ) || ( MSD_MEDIA == MSD_PSRAM_MEDIA )
+  #if ( MSD_CRYPT == 1 )
+  memcpy( data, pCmd->pData, sectors * 512 );
+  MSDDCRYPT_Decrypt( data, ( pCmd->pData - storage ) / 512, sectors );
+  pCmd->pData += sectors * 512;
+  #else
   (void)pCmd;
   (void)data;
   (void)sectors;
   #endif
+  #endif
 
   #if ( MSD_MEDIA == MSD_SDCARD_MEDIA )
   disk_read( 0, data, pCmd->lba, sectors );
+  MSDDCRYPT_Decrypt( data, pCmd->lba, sectors );
   #endif
 
   #if ( MSD_MEDIA == MSD_FLASH_MEDIA ) || ( MSD_MEDIA == MSD_NORFLASH_MEDIA )
   /* Write pending data to flash before starting the read operation. */
   MSDDMEDIA_Flush();
   memcpy( data, pCmd->pData, sectors * 512 );
+  MSDDCRYPT_Decrypt( data, ( pCmd->pData - storage ) / 512, sectors );
   pCmd->pData += sectors * 512;
   #endif
 }
@@ -374,13 +486,29 @@ void MSDDMEDIA_Read( MSDD_CmdStatus_TypeDef *pCmd, uint8_t *data, uint32_t secto
  *****************************************************************************/
 void MSDDMEDIA_Write( MSDD_CmdStatus_TypeDef *pCmd, uint8_t *data, uint32_t sectors )
 {
+  #if ( MSD_STATS == 1 )
+  if ( MSDDSTATS_IsStatsLba( pCmd->lba ) )
+  {
+    /* Any write to the statistics sector clears the counters. */
+    MSDDSTATS_Reset();
+    return;
+  }
+  #endif
+
   #if ( MSD_MEDIA == MSD_SRAM_MEDIA ) || ( MSD_MEDIA == MSD_PSRAM_MEDIA )
+  #if ( MSD_CRYPT == 1 )
+  MSDDCRYPT_Encrypt( data, ( pCmd->pData - storage ) / 512, sectors );
+  memcpy( pCmd->pData, data, sectors * 512 );
+  pCmd->pData += sectors * 512;
+  #else
   (void)pCmd;
   (void)data;
   (void)sectors;
   #endif
+  #endif
 
   #if ( MSD_MEDIA == MSD_SDCARD_MEDIA )
+  MSDDCRYPT_Encrypt( data, pCmd->lba, sectors );
   disk_write( 0, data, pCmd->lba, sectors );
   #endif
 
@@ -388,23 +516,29 @@ void MSDDMEDIA_Write( MSDD_CmdStatus_TypeDef *pCmd, uint8_t *data, uint32_t sect
   unsigned int i;
   uint32_t offset;
 
+  MSDDCRYPT_Encrypt( data, ( pCmd->pData - storage ) / 512, sectors );
+
+  FlushTimerAdapt( (uint8_t*)((uint32_t)pCmd->pData & ~( flashPageSize - 1 )) );
+
   i = 0;
   while ( i < sectors )
   {
     if ( !flashStatus.pendingWrite )
     {
-      /* Copy an entire flash page to the page buffer */
       flashStatus.pendingWrite = true;
       flashStatus.pPageBase    = (uint8_t*)((uint32_t)pCmd->pData & ~( flashPageSize - 1 ));
-      offset                    = pCmd->pData - flashStatus.pPageBase;
-      memcpy( flashPageBuf, flashStatus.pPageBase, flashPageSize );
-
-      /* Write the received data in the page buffer */
-      memcpy( flashPageBuf + offset, data, 512 );
-      data        += 512;
-      pCmd->pData += 512;
-
-      USBTIMER_Start( FLUSH_TIMER, FLUSH_TIMER_TIMEOUT, FlushTimerTimeout );
+      offset                   = pCmd->pData - flashStatus.pPageBase;
+      flashStatus.seqStart     = offset;
+      flashStatus.seqEnd       = offset;
+
+      /*
+       * Copy the entire flash page to the page buffer, unless this write is
+       * going to overwrite all of it.
+       */
+      if ( ( offset != 0 ) || ( ( sectors - i ) * 512 < flashPageSize ) )
+      {
+        memcpy( flashPageBuf, flashStatus.pPageBase, flashPageSize );
+      }
     }
     else
     {
@@ -417,19 +551,32 @@ void MSDDMEDIA_Write( MSDD_CmdStatus_TypeDef *pCmd, uint8_t *data, uint32_t sect
          * before continuing.
          */
         MSDDMEDIA_Flush();
-        i--;
-      }
-      else
-      {
-        /* Write the received data in the page buffer */
-        memcpy( flashPageBuf + offset, data, 512 );
-        data        += 512;
-        pCmd->pData += 512;
-
-        USBTIMER_Start( FLUSH_TIMER, FLUSH_TIMER_TIMEOUT, FlushTimerTimeout );
+        continue;
       }
     }
+
+    /* Write the received data in the page buffer */
+    memcpy( flashPageBuf + offset, data, 512 );
+    data        += 512;
+    pCmd->pData += 512;
     i++;
+
+    /* Keep track of the sequentially written part of the page buffer. */
+    if ( offset != flashStatus.seqEnd )
+      flashStatus.seqStart = offset;
+    flashStatus.seqEnd = offset + 512;
+
+    if ( ( flashStatus.seqStart == 0 ) && ( flashStatus.seqEnd == flashPageSize ) )
+    {
+      /* A sequential stream has filled the page, no reason to wait. */
+      MSDDMEDIA_Flush();
+    }
+  }
+
+  /* Delay flushing of partially written pages, more data may follow. */
+  if ( flashStatus.pendingWrite )
+  {
+    USBTIMER_Start( FLUSH_TIMER, flushTimeout, FlushTimerTimeout );
   }
   #endif
 }
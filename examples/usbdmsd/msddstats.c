@@ -0,0 +1,225 @@
+/**************************************************************************//**
+ * @file  msddstats.c
+ * @brief Access statistics for the Mass Storage class Device (MSD) media.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2012 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#include <string.h>
+#include "em_usb.h"
+#include "em_cmu.h"
+
+#include "msdd.h"
+#include "msddmedia.h"
+#include "msddstats.h"
+
+#if ( MSD_STATS == 1 )
+
+EFM32_ALIGN(4)
+static MSDDSTATS_TypeDef stats;
+static uint32_t          statsLba;
+
+/**************************************************************************//**
+ * @brief
+ *   Map a request size to a histogram bucket (floor of log2).
+ *****************************************************************************/
+static uint32_t SizeToBucket( uint32_t sectors )
+{
+  uint32_t bucket = 31 - __CLZ( sectors );
+
+  if ( bucket >= MSDSTATS_NUM_BUCKETS )
+    bucket = MSDSTATS_NUM_BUCKETS - 1;
+
+  return bucket;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Map a LBA to a statistics region.
+ *****************************************************************************/
+static uint32_t LbaToRegion( uint32_t lba )
+{
+  uint32_t region = lba / stats.sectorsPerRegion;
+
+  if ( region >= MSDSTATS_NUM_REGIONS )
+    region = MSDSTATS_NUM_REGIONS - 1;
+
+  return region;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize the statistics module and start the DWT cycle counter.
+ *
+ * @param[in] numSectors
+ *   Number of 512 byte sectors on the media. The statistics sector is
+ *   located just after the last media sector.
+ *****************************************************************************/
+void MSDDSTATS_Init( uint32_t numSectors )
+{
+  statsLba               = numSectors;
+  stats.sectorsPerRegion = ( numSectors + MSDSTATS_NUM_REGIONS - 1 ) /
+                           MSDSTATS_NUM_REGIONS;
+  if ( stats.sectorsPerRegion == 0 )
+    stats.sectorsPerRegion = 1;
+
+  MSDDSTATS_Reset();
+
+  /* Enable the DWT cycle counter, used for flush latency measurements. */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Record a media access.
+ *
+ * @param[in] lba
+ *   First sector of the transfer.
+ *
+ * @param[in] sectors
+ *   Number of 512 byte sectors in the transfer.
+ *
+ * @param[in] read
+ *   True for reads (device to host), false for writes.
+ *****************************************************************************/
+void MSDDSTATS_Access( uint32_t lba, uint32_t sectors, bool read )
+{
+  uint32_t region, last, count;
+
+  if ( sectors == 0 )
+    return;
+
+  if ( read )
+    stats.readSizeHist[ SizeToBucket( sectors ) ]++;
+  else
+    stats.writeSizeHist[ SizeToBucket( sectors ) ]++;
+
+  /* A request may straddle several regions, credit each of them. */
+  last = lba + sectors;
+  while ( lba < last )
+  {
+    region = LbaToRegion( lba );
+    count  = ( region + 1 ) * stats.sectorsPerRegion - lba;
+    if ( ( count > last - lba ) || ( region == MSDSTATS_NUM_REGIONS - 1 ) )
+      count = last - lba;
+
+    if ( read )
+      stats.regionReads[ region ] += count;
+    else
+      stats.regionWrites[ region ] += count;
+
+    lba += count;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Mark the start of a media flush.
+ *
+ * @return
+ *   Current cycle count, pass it to @ref MSDDSTATS_FlushEnd().
+ *****************************************************************************/
+uint32_t MSDDSTATS_FlushBegin( void )
+{
+  return DWT->CYCCNT;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Record a completed media flush.
+ *
+ * @param[in] lba
+ *   First sector of the flushed page.
+ *
+ * @param[in] startCycles
+ *   Value returned from @ref MSDDSTATS_FlushBegin().
+ *****************************************************************************/
+void MSDDSTATS_FlushEnd( uint32_t lba, uint32_t startCycles )
+{
+  uint32_t cycles, total;
+
+  cycles = DWT->CYCCNT - startCycles;
+
+  stats.flushCount++;
+  stats.regionFlushes[ LbaToRegion( lba ) ]++;
+
+  if ( cycles < stats.flushCyclesMin )
+    stats.flushCyclesMin = cycles;
+  if ( cycles > stats.flushCyclesMax )
+    stats.flushCyclesMax = cycles;
+
+  total = stats.flushCyclesTotalLo + cycles;
+  if ( total < stats.flushCyclesTotalLo )
+    stats.flushCyclesTotalHi++;
+  stats.flushCyclesTotalLo = total;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Check if a LBA addresses the statistics sector.
+ *****************************************************************************/
+bool MSDDSTATS_IsStatsLba( uint32_t lba )
+{
+  return lba == statsLba;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the statistics sector to a buffer.
+ *
+ * @param[in] data
+ *   Pointer to a 512 byte buffer.
+ *****************************************************************************/
+void MSDDSTATS_Read( uint8_t *data )
+{
+  memset( data, 0, 512 );
+  stats.coreClockFreq = CMU_ClockFreqGet( cmuClock_CORE );
+  memcpy( data, &stats, sizeof( stats ) );
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Clear all counters.
+ *****************************************************************************/
+void MSDDSTATS_Reset( void )
+{
+  uint32_t sectorsPerRegion = stats.sectorsPerRegion;
+
+  memset( &stats, 0, sizeof( stats ) );
+
+  stats.magic            = MSDSTATS_MAGIC;
+  stats.version          = MSDSTATS_VERSION;
+  stats.numRegions       = MSDSTATS_NUM_REGIONS;
+  stats.sectorsPerRegion = sectorsPerRegion;
+  stats.flushCyclesMin   = 0xFFFFFFFF;
+}
+
+#endif /* MSD_STATS == 1 */
@@ -0,0 +1,107 @@
+/***************************************************************************//**
+ * @file  msddstats.h
+ * @brief Access statistics for the Mass Storage class Device (MSD) media.
+ * @author Energy Micro AS
+ * @version 3.20.0
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2012 Energy Micro AS, http://www.energymicro.com</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ * 4. The source and compiled code may only be used on Energy Micro "EFM32"
+ *    microcontrollers and "EFR4" radios.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Energy Micro AS has no
+ * obligation to support this Software. Energy Micro AS is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Energy Micro AS will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ *****************************************************************************/
+#ifndef __MSDDSTATS_H
+#define __MSDDSTATS_H
+
+/*
+ * Set MSD_STATS to 1 to collect media access statistics.
+ *
+ * The statistics are made available to the host as a hidden, read-only
+ * sector located at LBA = <reported sector count>, i.e. just after the last
+ * sector of the disk. The sector is not part of the reported capacity and is
+ * therefore never touched by the host filesystem, but it can be read with a
+ * SCSI pass-through READ(10) command (e.g. "sg_dd" or "sg_raw" on Linux).
+ * Writing any data to the same LBA clears all counters.
+ */
+#if !defined( MSD_STATS )
+#define MSD_STATS               0
+#endif
+
+#define MSDSTATS_MAGIC          0x5344534D  /* "MSDS" in little endian     */
+#define MSDSTATS_VERSION        1
+#define MSDSTATS_NUM_REGIONS    32          /* LBA space is split in 32    */
+#define MSDSTATS_NUM_BUCKETS    8           /* 1,2,4,..,128+ sectors       */
+
+/** Layout of the statistics sector, all fields are little endian. */
+typedef struct
+{
+  uint32_t magic;                             /**< MSDSTATS_MAGIC          */
+  uint16_t version;                           /**< MSDSTATS_VERSION        */
+  uint16_t numRegions;                        /**< MSDSTATS_NUM_REGIONS    */
+  uint32_t sectorsPerRegion;                  /**< Region size in sectors  */
+  uint32_t coreClockFreq;                     /**< Unit of flush cycles    */
+  uint32_t readSizeHist[  MSDSTATS_NUM_BUCKETS ]; /**< log2 request sizes  */
+  uint32_t writeSizeHist[ MSDSTATS_NUM_BUCKETS ]; /**< log2 request sizes  */
+  uint32_t flushCount;                        /**< Number of page flushes  */
+  uint32_t flushCyclesMin;                    /**< Fastest flush           */
+  uint32_t flushCyclesMax;                    /**< Slowest flush           */
+  uint32_t flushCyclesTotalLo;                /**< Sum of all flushes      */
+  uint32_t flushCyclesTotalHi;
+  uint32_t regionReads[   MSDSTATS_NUM_REGIONS ]; /**< Sectors read        */
+  uint32_t regionWrites[  MSDSTATS_NUM_REGIONS ]; /**< Sectors written     */
+  uint32_t regionFlushes[ MSDSTATS_NUM_REGIONS ]; /**< Page flushes        */
+} MSDDSTATS_TypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if ( MSD_STATS == 1 )
+
+/*** MSD Statistics Function prototypes ***/
+
+void     MSDDSTATS_Init( uint32_t numSectors );
+void     MSDDSTATS_Access( uint32_t lba, uint32_t sectors, bool read );
+uint32_t MSDDSTATS_FlushBegin( void );
+void     MSDDSTATS_FlushEnd( uint32_t lba, uint32_t startCycles );
+bool     MSDDSTATS_IsStatsLba( uint32_t lba );
+void     MSDDSTATS_Read( uint8_t *data );
+void     MSDDSTATS_Reset( void );
+
+#else
+
+#define MSDDSTATS_Init( numSectors )
+#define MSDDSTATS_Access( lba, sectors, read )
+#define MSDDSTATS_FlushBegin()                  0
+#define MSDDSTATS_FlushEnd( lba, startCycles )  (void)( startCycles )
+#define MSDDSTATS_IsStatsLba( lba )             false
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MSDDSTATS_H */
@@ -53,7 +53,8 @@
 #include "rtcdrv.h"
 #include "bsp_trace.h"
 
-#define USERPAGE    0x0FE00000 /**< Address of the user page */
+#define USERPAGE      0x0FE00000 /**< Address of the user page */
+#define USERPAGE_SIZE 2048       /**< Size of the user page in bytes */
 
 typedef struct
 {
@@ -61,13 +62,138 @@ typedef struct
   uint32_t numWrites;        /**< Number of saves to flash */
 } UserData_TypeDef;
 
+/** Record appended to the user page on every save */
+typedef struct
+{
+  UserData_TypeDef data;     /**< Saved user data */
+  uint32_t         check;    /**< Check word of the data, written last */
+} UserRecord_TypeDef;
+
+#define RECORD_WORDS  (sizeof(UserRecord_TypeDef) / sizeof(uint32_t))
+#define RECORD_COUNT  (USERPAGE_SIZE / sizeof(UserRecord_TypeDef))
+#define FIRST_RECORD  ((UserRecord_TypeDef *) USERPAGE)
+#define ERASED_WORD   0xFFFFFFFF
+
 volatile UserData_TypeDef userData;                   /**< User data contents */
+UserRecord_TypeDef        *nextRecord;                /**< Position of the next record in the user page */
 
 volatile bool             rtcFlag;                    /**< Flag used by the RTC timing routines */
 volatile bool             recentlySaved;              /**< Flag to indicate successful write */
 
 msc_Return_TypeDef        currentError = mscReturnOk; /** < Latest error encountered */
 
+/**************************************************************************//**
+ * @brief Calculates the check word of a record
+ *****************************************************************************/
+uint32_t RecordCheck(UserRecord_TypeDef *record)
+{
+  uint32_t *word  = (uint32_t *) &record->data;
+  uint32_t check = 0;
+  uint32_t i;
+
+  /* Rotate and add every data word */
+  for (i = 0; i < RECORD_WORDS - 1; i++)
+  {
+    check = ((check << 7) | (check >> 25)) + word[i];
+  }
+
+  return ~check;
+}
+
+/**************************************************************************//**
+ * @brief Checks if a record in the user page has never been written
+ *****************************************************************************/
+bool RecordErased(UserRecord_TypeDef *record)
+{
+  uint32_t *word = (uint32_t *) record;
+  uint32_t i;
+
+  for (i = 0; i < RECORD_WORDS; i++)
+  {
+    if (word[i] != ERASED_WORD) return false;
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Restores the last saved user data from the user page
+ * @details
+ *   Records are appended one after the other, so the page is scanned
+ *   backwards from its end. The first record which is not erased is the last
+ *   one written, and the first one with a correct check word is the last
+ *   complete save. A save interrupted by a reset is skipped.
+ * @return true if a valid record was found
+ *****************************************************************************/
+bool UserPageRestore(void)
+{
+  UserRecord_TypeDef *record = FIRST_RECORD + RECORD_COUNT;
+
+  /* Skip records which have never been written */
+  while ((record > FIRST_RECORD) && RecordErased(record - 1))
+  {
+    record--;
+  }
+  nextRecord = record;
+
+  /* Find the last complete record */
+  while (record > FIRST_RECORD)
+  {
+    record--;
+    if (record->check == RecordCheck(record))
+    {
+      memcpy((void *) &userData, &record->data, sizeof(UserData_TypeDef));
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief Appends the user data to the user page
+ * @details
+ *   The page is only erased when it is full, so it is erased once every
+ *   RECORD_COUNT saves instead of on every save.
+ *****************************************************************************/
+msc_Return_TypeDef UserPageSave(void)
+{
+  UserRecord_TypeDef record;
+  msc_Return_TypeDef ret = mscReturnOk;
+
+  /* Initialize the MSC for writing */
+  MSC_Init();
+
+  /* Erase the page when there is no room for another record */
+  if (nextRecord >= FIRST_RECORD + RECORD_COUNT)
+  {
+    ret = MSC_ErasePage((uint32_t *) USERPAGE);
+    if (ret == mscReturnOk)
+      nextRecord = FIRST_RECORD;
+  }
+
+  if (ret == mscReturnOk)
+  {
+    /* Increase the number of saves */
+    userData.numWrites++;
+
+    memcpy(&record.data, (void *) &userData, sizeof(UserData_TypeDef));
+    record.check = RecordCheck(&record);
+
+    /* Write the record to the userpage. The check word is written last, so
+     * the record only becomes valid when it is complete. */
+    ret = MSC_WriteWord((uint32_t *) nextRecord, &record, sizeof(UserRecord_TypeDef));
+
+    /* A failed write may have programmed part of the record, do not reuse it */
+    nextRecord++;
+  }
+
+  /* Deinitialize the MSC. This disables writing and locks the MSC */
+  MSC_Deinit();
+
+  return ret;
+}
+
 /**************************************************************************//**
  * @brief GPIO Interrupt handler (PB9)
  *        Saves the number to the userpage
@@ -95,38 +221,15 @@ void GPIO_EVEN_IRQHandler(void)
   /* Acknowledge interrupt */
   GPIO_IntClear(1 << 10);
 
-  /* Initialize the MSC for writing */
-  MSC_Init();
-
-  /* Erase the page */
-  ret = MSC_ErasePage((uint32_t *) USERPAGE);
-
-  /* Check for errors. If there are errors, set the global error variable and
-   * deinitialize the MSC */
-  if (ret != mscReturnOk)
-  {
-    currentError = ret;
-    MSC_Deinit();
-    return;
-  }
-
-  /* Increase the number of saves */
-  userData.numWrites++;
+  /* Append the data to the userpage */
+  ret = UserPageSave();
 
-  /* Write data to the userpage */
-  ret = MSC_WriteWord((uint32_t *) USERPAGE, (void *) &userData,
-                      sizeof(UserData_TypeDef));
-
-  /* Check for errors. If there are errors, set the global error variable and
-   * deinitialize the MSC */
+  /* Check for errors. If there are errors, set the global error variable */
   if (ret != mscReturnOk)
   {
     currentError = ret;
-    MSC_Deinit();
     return;
   }
-  /* Deinitialize the MSC. This disables writing and locks the MSC */
-  MSC_Deinit();
 
   /* Signal completion of save. The number of saves will be displayed */
   recentlySaved = true;
@@ -223,14 +326,13 @@ int main(void)
   /* Disable all segments */
   SegmentLCD_AllOff();
 
-  /* Copy contents of the userpage (flash) into the userData struct */
-  memcpy((void *) &userData, (void *) USERPAGE, sizeof(UserData_TypeDef));
-
-  /* Special case for uninitialized data */
-  if (userData.number > 10000)
-    userData.number = 0;
-  if (userData.numWrites == 0xFFFFFFFF)
+  /* Copy the last saved record of the userpage (flash) into the userData
+   * struct. Special case for uninitialized data */
+  if (!UserPageRestore())
+  {
+    userData.number    = 0;
     userData.numWrites = 0;
+  }
 
   /* Display the number */
   SegmentLCD_Number(userData.number);